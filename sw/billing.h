@@ -0,0 +1,147 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename:	sw/billing.h
+//
+// Project:	Xtimesheet, a very simple text-based timesheet tracking program
+// {{{
+// Purpose:	How time becomes billable units, and units become money.
+//		Every tool gets its numbers from here, so they all agree.
+//
+//	ROUNDING<GRAIN,BIAS>	Seconds to units: (secs + BIAS) / GRAIN
+//	BILLACC<ROUND,POINT>	Accumulates seconds, rounding them once per
+//				interval, once per day, or once at the end
+//	CURRENCY<SCALE>		Fixed point money, SCALE parts to the whole
+//
+//	The policy is fixed at compile time, so each accumulator compiles
+//	down to the arithmetic for its one policy, with no tests of the
+//	policy left at run time.
+//
+//	BILLING, TENTHS and CENTS below are the policy that every tool uses:
+//	tenths of an hour, rounded at three minutes, once per day.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2017-2024, Gisselquist Technology, LLC
+// {{{
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	GPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/gpl.html
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+#ifndef	BILLING_H
+#define	BILLING_H
+
+#include <stdint.h>
+#include <limits.h>
+#include <math.h>
+#include <time.h>
+
+// Where rounding takes place
+typedef	enum	{
+	BP_INTERVAL,	// Round every interval on its own
+	BP_DAY,		// Round the total of each day
+	BP_TOTAL	// Round only the final total
+} BILLPOINT;
+
+template<unsigned GRAIN, unsigned BIAS>
+class	ROUNDING {
+public:
+	static const unsigned	SECONDS = GRAIN;	// Seconds per unit
+
+	static	unsigned long	units(unsigned long secs) {
+		return (secs + BIAS) / GRAIN;
+	}
+
+	// Units as tenths of an hour, for reports
+	static	unsigned long	tenths(unsigned long units) {
+		return units * GRAIN / 360;
+	}
+};
+
+template<class ROUND, BILLPOINT POINT>
+class	BILLACC {
+	unsigned long	m_units;	// Already rounded
+	unsigned long	m_secs;		// Not yet rounded
+	time_t		m_day;		// Local midnight of m_secs, BP_DAY only
+public:
+	typedef	ROUND	ROUNDING;
+
+	BILLACC(void) { clear(); }
+
+	void	clear(void) {
+		m_units = 0;
+		m_secs  = 0;
+		m_day   = LONG_MIN;
+	}
+
+	// Add secs worked on the (local) day beginning at midnight
+	void	add(time_t midnight, unsigned long secs) {
+		switch(POINT) {
+		case BP_INTERVAL:
+			m_units += ROUND::units(secs);
+			break;
+		case BP_DAY:
+			if (midnight != m_day) {
+				m_units += ROUND::units(m_secs);
+				m_secs = 0;
+				m_day  = midnight;
+			}
+			m_secs += secs;
+			break;
+		default:
+			m_secs += secs;
+			break;
+		}
+	}
+
+	unsigned long	units(void) const {
+		return m_units + ROUND::units(m_secs);
+	}
+};
+
+template<unsigned SCALE>
+class	CURRENCY {
+public:
+	static	int64_t	from(double v) {
+		return llround(v * SCALE);
+	}
+
+	static	double	to_double(int64_t v) {
+		return v / (double)SCALE;
+	}
+
+	// The charge for units of ROUND at rate per hour (both fixed point),
+	// rounded half away from zero
+	template<class ROUND>
+	static	int64_t	fee(int64_t rate, unsigned long units) {
+		int64_t	num = rate * (int64_t)units * ROUND::SECONDS;
+
+		return (num >= 0) ? (num + 1800) / 3600 : -((1800 - num) / 3600);
+	}
+};
+
+typedef	ROUNDING<360, 180>	TENTHS;
+typedef	CURRENCY<100>		CENTS;
+typedef	BILLACC<TENTHS, BP_DAY>	BILLING;
+
+#endif	// BILLING_H
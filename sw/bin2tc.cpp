@@ -0,0 +1,114 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename:	sw/bin2tc.cpp
+//
+// Project:	Xtimesheet, a very simple text-based timesheet tracking program
+// {{{
+// Purpose:	Converts a .tcb binary time card back into the text card
+//		it came from.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2017-2024, Gisselquist Technology, LLC
+// {{{
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	GPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/gpl.html
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+__attribute__((unused))
+static const char *cpyright = "(C) 2024 Gisselquist Technology, LLC: " __FILE__;
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "tcbfile.h"
+
+void	usage(void) {
+	// {{{
+	fprintf(stderr,
+"USAGE: bin2tc timesheet.tcb [timesheet.txt]\n"
+"\n"
+"Converts a .tcb binary time card back to text.  Without an output name,\n"
+"the text is written to standard out.\n");
+}
+// }}}
+
+int main(int argc, char **argv) {
+	TCBREADER	tcb;
+	TCBREC		rec;
+	FILE		*fout = stdout;
+	char		line[128];
+	unsigned	len;
+
+	if (argc < 2 || argc > 3 || argv[1][0] == '-') {
+		usage();
+		exit(EXIT_FAILURE);
+	}
+
+	if (!tcb.open(argv[1])) {
+		fprintf(stderr, "ERR: %s is not a .tcb time card\n", argv[1]);
+		exit(EXIT_FAILURE);
+	}
+
+	if (argc > 2) {
+		if (0 == access(argv[2], F_OK)) {
+			fprintf(stderr, "ERR: %s already exists.  Cowardly "
+				"refusing to overwrite it\n", argv[2]);
+			exit(EXIT_FAILURE);
+		}
+
+		fout = fopen(argv[2], "w");
+		if (NULL == fout) {
+			fprintf(stderr, "ERR: Cannot open %s\n", argv[2]);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	while(tcb.next(rec)) {
+		switch(rec.m_kind) {
+		case TCB_INTERVAL:
+			len = TCBREADER::render(line, sizeof(line), rec.m_day,
+					rec.m_start, rec.m_dur);
+			fwrite(line, 1, len, fout);
+			break;
+		case TCB_RATE:
+			fputs(tcb.rateline(rec.m_rate).c_str(), fout);
+			break;
+		default:
+			fwrite(rec.m_text, 1, rec.m_len, fout);
+			break;
+		}
+	}
+
+	if (tcb.error()) {
+		fprintf(stderr, "ERR: %s is corrupt\n", argv[1]);
+		exit(EXIT_FAILURE);
+	}
+
+	if (fout != stdout)
+		fclose(fout);
+	return 0;
+}
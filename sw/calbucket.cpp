@@ -0,0 +1,185 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename:	sw/calbucket.cpp
+//
+// Project:	Xtimesheet, a very simple text-based timesheet tracking program
+// {{{
+// Purpose:	Assigns each interval of work to its day, ISO week, month,
+//		quarter and year, using a table of day boundaries built once
+//	for each year.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2017-2024, Gisselquist Technology, LLC
+// {{{
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	GPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/gpl.html
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+__attribute__((unused))
+static const char *cpyright = "(C) 2024 Gisselquist Technology, LLC: " __FILE__;
+
+#include "calbucket.h"
+
+CALBUCKETS::CALBUCKETS(void) {
+	// {{{
+	m_year = 0;
+	m_jan1 = 0;
+	m_ndays = m_day = 0;
+	m_rate = 225.0;
+	close();
+}
+// }}}
+
+void	CALBUCKETS::mkyear(long year) {
+	// {{{
+	const TZONE	&tz = TZONE::local();
+	unsigned	mon;
+
+	m_year  = year;
+	m_jan1  = TZONE::days_from_civil(year, 1, 1);
+	m_ndays = TZONE::days_from_civil(year+1, 1, 1) - m_jan1;
+	m_day   = 0;
+
+	for(unsigned d=0; d<=m_ndays; d++)
+		m_bound[d] = tz.civil(year, 1, 1+d);
+
+	for(mon=0; mon<12; mon++)
+		m_month_day[mon] = TZONE::days_from_civil(year, mon+1, 1)
+					- m_jan1;
+	m_month_day[12] = m_ndays;
+
+	for(mon=0; mon<12; mon++)
+		for(unsigned d=m_month_day[mon]; d<m_month_day[mon+1]; d++)
+			m_month[d] = mon;
+}
+// }}}
+
+void	CALBUCKETS::begins(time_t when, time_t *begin) {
+	// {{{
+	unsigned	d, mon, back;
+
+	if (0 == m_ndays || when < m_bound[0] || when >= m_bound[m_ndays]) {
+		struct	tm	tv;
+
+		TZONE::local().localtime(when, tv);
+		mkyear(tv.tm_year + 1900);
+	}
+
+	// Intervals almost always arrive in order, so try the day we left
+	// off on, and the one after it, before searching the table
+	d = m_day;
+	if (when < m_bound[d] || when >= m_bound[d+1]) {
+		if (d+1 < m_ndays && m_bound[d+1] <= when
+					&& when < m_bound[d+2])
+			d++;
+		else {
+			unsigned	lo = 0, hi = m_ndays;
+
+			while(hi - lo > 1) {
+				unsigned mid = (lo + hi) / 2;
+				if (m_bound[mid] <= when)
+					lo = mid;
+				else
+					hi = mid;
+			} d = lo;
+		}
+	} m_day = d;
+
+	mon = m_month[d];
+	begin[CB_DAY]     = m_bound[d];
+	begin[CB_MONTH]   = m_bound[m_month_day[mon]];
+	begin[CB_QUARTER] = m_bound[m_month_day[mon - (mon % 3)]];
+	begin[CB_YEAR]    = m_bound[0];
+
+	// ISO weeks start on Monday, possibly in the year before
+	back = (TZONE::weekday(m_jan1 + d) + 6) % 7;
+	if (back <= d)
+		begin[CB_WEEK] = m_bound[d - back];
+	else
+		begin[CB_WEEK] = TZONE::local().civil(m_year, 1,
+						1 + (int)d - (int)back);
+}
+// }}}
+
+void	CALBUCKETS::add(time_t t_start, time_t t_stop) {
+	// {{{
+	time_t	begin[CB_NLEVELS];
+
+	begins(t_start, begin);
+
+	for(int lvl=0; lvl<CB_NLEVELS; lvl++) {
+		std::vector<CALBUCKET>	&bv = m_bucket[lvl];
+		int	k = m_open[lvl];
+
+		if (k < 0 || bv[k].m_begin != begin[lvl]) {
+			CALBUCKET	b;
+
+			b.m_begin   = begin[lvl];
+			b.m_secs    = 0;
+			b.m_units   = 0;
+			b.m_invoice = false;
+			bv.push_back(b);
+			k = m_open[lvl] = bv.size()-1;
+			m_bill[lvl].clear();
+		}
+
+		m_bill[lvl].add(begin[CB_DAY], t_stop - t_start);
+		bv[k].m_secs += t_stop - t_start;
+		bv[k].m_units = m_bill[lvl].units();
+		bv[k].m_rate  = m_rate;
+	}
+}
+// }}}
+
+void	CALBUCKETS::invoice(void) {
+	// {{{
+	for(int lvl=0; lvl<CB_NLEVELS; lvl++) {
+		if (m_open[lvl] >= 0)
+			m_bucket[lvl][m_open[lvl]].m_invoice = true;
+		else {
+			// Nothing since the last invoice, but keep the marker
+			CALBUCKET	b;
+
+			b.m_begin   = 0;
+			b.m_secs    = 0;
+			b.m_units   = 0;
+			b.m_rate    = m_rate;
+			b.m_invoice = true;
+			m_bucket[lvl].push_back(b);
+		}
+	}
+
+	// Anything after an invoice goes into a new bucket, even if it falls
+	// within the same period
+	close();
+}
+// }}}
+
+void	CALBUCKETS::close(void) {
+	// {{{
+	for(int lvl=0; lvl<CB_NLEVELS; lvl++)
+		m_open[lvl] = -1;
+}
+// }}}
@@ -0,0 +1,93 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename:	sw/calbucket.h
+//
+// Project:	Xtimesheet, a very simple text-based timesheet tracking program
+// {{{
+// Purpose:	Sorts intervals of work into calendar buckets--days, ISO
+//		weeks, months, quarters and years--all at once, so that every
+//	one of these reports can come out of a single pass through the files.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2017-2024, Gisselquist Technology, LLC
+// {{{
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	GPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/gpl.html
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+#ifndef	CALBUCKET_H
+#define	CALBUCKET_H
+
+#include <vector>
+
+#include "timecard.h"
+#include "billing.h"
+
+typedef	enum	{
+	CB_DAY, CB_WEEK, CB_MONTH, CB_QUARTER, CB_YEAR, CB_NLEVELS
+} CALLEVEL;
+
+typedef	struct	CALBUCKET_S {
+	time_t		m_begin;	// Local midnight starting the period
+	unsigned long	m_secs;
+	unsigned long	m_units;	// Billed units, per BILLING
+	double		m_rate;		// Rate in effect at the last interval
+	bool		m_invoice;	// Invoice issued at the end
+} CALBUCKET;
+
+class	CALBUCKETS {
+	// Bucket boundaries for one calendar year, built once per year:
+	// the midnight starting each day, and the first day of each month
+	long		m_year;
+	long		m_jan1;		// Day number of January first
+	unsigned	m_ndays, m_day;
+	time_t		m_bound[367];
+	unsigned	m_month_day[13];
+	unsigned char	m_month[366];
+
+	std::vector<CALBUCKET>	m_bucket[CB_NLEVELS];
+	int		m_open[CB_NLEVELS];
+	BILLING		m_bill[CB_NLEVELS];	// For each open bucket
+	double		m_rate;
+
+	void	mkyear(long year);
+public:
+	CALBUCKETS(void);
+
+	// The start of the day, week, month, quarter and year holding when
+	void	begins(time_t when, time_t *begin);
+
+	void	rate(double r) { m_rate = r; }
+	void	add(time_t t_start, time_t t_stop);
+	void	invoice(void);
+	void	close(void);
+
+	unsigned	size(CALLEVEL lvl) const {
+		return m_bucket[lvl].size(); }
+	const CALBUCKET	&bucket(CALLEVEL lvl, unsigned k) const {
+		return m_bucket[lvl][k]; }
+};
+
+#endif	// CALBUCKET_H
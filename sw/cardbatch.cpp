@@ -0,0 +1,498 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename:	sw/cardbatch.cpp
+//
+// Project:	Xtimesheet, a very simple text-based timesheet tracking program
+// {{{
+// Purpose:	Reads a list of cards into memory, all at once where the
+//		kernel allows, one at a time otherwise.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2017-2024, Gisselquist Technology, LLC
+// {{{
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	GPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/gpl.html
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+__attribute__((unused))
+static const char *cpyright = "(C) 2024 Gisselquist Technology, LLC: " __FILE__;
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#ifdef	HAVE_URING
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#endif
+
+#include "cardbatch.h"
+
+void	CARDBATCH::read(CALLBACK cb, size_t limit) {
+	// {{{
+	m_used = m_uring && uring(cb, limit, false);
+	if (!m_used)
+		serial(cb, limit, false);
+}
+// }}}
+
+void	CARDBATCH::head(CALLBACK cb, size_t len) {
+	// {{{
+	m_used = m_uring && uring(cb, len, true);
+	if (!m_used)
+		serial(cb, len, true);
+}
+// }}}
+
+// serial -- one card at a time, the way it's always been done
+void	CARDBATCH::serial(CALLBACK cb, size_t limit, bool head) {
+	// {{{
+	for(unsigned k=0; k<m_cards.size(); k++) {
+		struct	stat	sb;
+		int	fd;
+		char	*buf;
+		size_t	len = 0, cap;
+		bool	ok = true;
+
+		if (0 > (fd = ::open(m_cards[k].c_str(), O_RDONLY))) {
+			cb(k, NULL, 0);
+			continue;
+		}
+
+		if (head)
+			cap = limit;
+		else if (0 != fstat(fd, &sb)
+				|| (limit > 0 && (size_t)sb.st_size > limit)) {
+			::close(fd);
+			cb(k, NULL, 0);
+			continue;
+		} else	// One more, to see the end of the file
+			cap = sb.st_size + 1;
+
+		buf = new char[cap];
+		while(len < cap) {
+			ssize_t	nr = ::read(fd, &buf[len], cap - len);
+
+			if (nr < 0) {
+				ok = false;
+				break;
+			} else if (nr == 0)
+				break;
+
+			len += nr;
+			if (!head && len == cap) {
+				// It's grown since we looked
+				char	*old = buf;
+
+				buf = new char[2*cap];
+				memcpy(buf, old, len);
+				delete[] old;
+				cap *= 2;
+			}
+		}
+		::close(fd);
+
+		cb(k, (ok) ? buf : NULL, (ok) ? len : 0);
+		delete[] buf;
+	}
+}
+// }}}
+
+#ifdef	HAVE_URING
+// A bare io_uring, set up straight from the kernel's interface
+class	URING {
+	// {{{
+	int		m_fd;
+	void		*m_sq, *m_cq;
+	size_t		m_sqlen, m_cqlen, m_sqeslen;
+	struct io_uring_sqe	*m_sqes;
+	struct io_uring_cqe	*m_cqes;
+	unsigned	*m_sqhead, *m_sqtail, *m_sqmask, *m_sqarray,
+			*m_cqhead, *m_cqtail, *m_cqmask;
+	unsigned	m_entries, m_tail, m_submitted;
+public:
+	URING(unsigned entries) {
+		// {{{
+		struct	io_uring_params	p;
+
+		m_sq = m_cq = MAP_FAILED;
+		m_sqes = (struct io_uring_sqe *)MAP_FAILED;
+		memset(&p, 0, sizeof(p));
+		m_fd = syscall(__NR_io_uring_setup, entries, &p);
+		if (m_fd < 0)
+			return;
+
+		m_entries = p.sq_entries;
+		m_sqlen = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+		m_cqlen = p.cq_off.cqes
+				+ p.cq_entries * sizeof(struct io_uring_cqe);
+		if (p.features & IORING_FEAT_SINGLE_MMAP) {
+			if (m_cqlen > m_sqlen)
+				m_sqlen = m_cqlen;
+			m_cqlen = m_sqlen;
+		}
+
+		m_sq = mmap(NULL, m_sqlen, PROT_READ|PROT_WRITE,
+			MAP_SHARED|MAP_POPULATE, m_fd, IORING_OFF_SQ_RING);
+		if (p.features & IORING_FEAT_SINGLE_MMAP)
+			m_cq = m_sq;
+		else
+			m_cq = mmap(NULL, m_cqlen, PROT_READ|PROT_WRITE,
+				MAP_SHARED|MAP_POPULATE, m_fd,
+				IORING_OFF_CQ_RING);
+		m_sqeslen = p.sq_entries * sizeof(struct io_uring_sqe);
+		m_sqes = (struct io_uring_sqe *)mmap(NULL, m_sqeslen,
+			PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE,
+			m_fd, IORING_OFF_SQES);
+		if (m_sq == MAP_FAILED || m_cq == MAP_FAILED
+				|| m_sqes == MAP_FAILED) {
+			release();
+			return;
+		}
+
+		m_sqhead  = (unsigned *)((char *)m_sq + p.sq_off.head);
+		m_sqtail  = (unsigned *)((char *)m_sq + p.sq_off.tail);
+		m_sqmask  = (unsigned *)((char *)m_sq + p.sq_off.ring_mask);
+		m_sqarray = (unsigned *)((char *)m_sq + p.sq_off.array);
+		m_cqhead  = (unsigned *)((char *)m_cq + p.cq_off.head);
+		m_cqtail  = (unsigned *)((char *)m_cq + p.cq_off.tail);
+		m_cqmask  = (unsigned *)((char *)m_cq + p.cq_off.ring_mask);
+		m_cqes = (struct io_uring_cqe *)((char *)m_cq + p.cq_off.cqes);
+		m_tail = m_submitted = *m_sqtail;
+	}
+	// }}}
+
+	~URING(void) { release(); }
+
+	void	release(void) {
+		// {{{
+		if (m_sqes != MAP_FAILED)
+			munmap(m_sqes, m_sqeslen);
+		if (m_cq != MAP_FAILED && m_cq != m_sq)
+			munmap(m_cq, m_cqlen);
+		if (m_sq != MAP_FAILED)
+			munmap(m_sq, m_sqlen);
+		if (m_fd >= 0)
+			::close(m_fd);
+		m_sq = m_cq = MAP_FAILED;
+		m_sqes = (struct io_uring_sqe *)MAP_FAILED;
+		m_fd = -1;
+	}
+	// }}}
+
+	bool	ok(void) const { return m_fd >= 0; }
+
+	// An empty submission queue entry, or NULL if the queue is full
+	struct io_uring_sqe	*sqe(void) {
+		// {{{
+		unsigned	head = __atomic_load_n(m_sqhead, __ATOMIC_ACQUIRE),
+				idx;
+		struct io_uring_sqe	*s;
+
+		if (m_tail - head >= m_entries)
+			return NULL;
+		idx = m_tail & *m_sqmask;
+		m_sqarray[idx] = idx;
+		s = &m_sqes[idx];
+		memset(s, 0, sizeof(*s));
+		m_tail++;
+		return s;
+	}
+	// }}}
+
+	// Submits everything queued, and waits for at least wait
+	// completions.  Returns false on failure.
+	bool	submit(unsigned wait) {
+		// {{{
+		int	r;
+
+		__atomic_store_n(m_sqtail, m_tail, __ATOMIC_RELEASE);
+		do {
+			r = syscall(__NR_io_uring_enter, m_fd,
+				m_tail - m_submitted, wait,
+				(wait) ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+		} while(r < 0 && errno == EINTR);
+		if (r < 0)
+			return false;
+		m_submitted += r;
+		return true;
+	}
+	// }}}
+
+	// Takes back everything queued that the kernel hasn't yet been given,
+	// returning how many entries that was
+	unsigned	withdraw(void) {
+		// {{{
+		unsigned	n = m_tail - m_submitted;
+
+		m_tail = m_submitted;
+		__atomic_store_n(m_sqtail, m_tail, __ATOMIC_RELEASE);
+		return n;
+	}
+	// }}}
+
+	// The next completion, if there is one
+	bool	cqe(struct io_uring_cqe &c) {
+		// {{{
+		unsigned	head = *m_cqhead;
+
+		if (head == __atomic_load_n(m_cqtail, __ATOMIC_ACQUIRE))
+			return false;
+		c = m_cqes[head & *m_cqmask];
+		__atomic_store_n(m_cqhead, head+1, __ATOMIC_RELEASE);
+		return true;
+	}
+	// }}}
+};
+// }}}
+
+// Each card steps through opening (and, for whole cards, a statx() for its
+// size, at the same time), reading, possibly reading again should it have
+// grown, and closing
+typedef	enum { OP_OPEN = 0, OP_STATX, OP_READ, OP_CLOSE } BATCHOP;
+
+typedef	struct	{
+	int		m_fd;
+	struct statx	m_stx;
+	bool		m_sized, m_reading, m_read, m_failed,
+			m_delivered, m_done;
+	unsigned	m_ops;		// Outstanding
+	char		*m_buf;
+	size_t		m_cap, m_len;
+} BATCHSLOT;
+
+bool	CARDBATCH::uring(CALLBACK cb, size_t limit, bool head) {
+	// {{{
+	// Cards open at once, and entries in the ring
+	static const unsigned	MAXACTIVE = 64, RINGLEN = 128;
+	const unsigned	n = m_cards.size();
+	URING		ring(RINGLEN);
+	std::vector<BATCHSLOT>	slot(n);
+	std::vector<uint64_t>	todo;	// Waiting on room in the ring
+	unsigned	next = 0, active = 0, finished = 0, inflight = 0;
+	bool		ok = true;
+
+	if (!ring.ok())
+		return false;
+
+	for(unsigned k=0; k<n; k++) {
+		BATCHSLOT	&s = slot[k];
+
+		memset(&s, 0, sizeof(s));
+		s.m_fd = -1;
+		s.m_sized = head;
+	}
+
+	while(finished < n) {
+		struct io_uring_cqe	c;
+		unsigned		k;
+
+		// Start on as many cards as we're allowed open
+		for(; next < n && active < MAXACTIVE; next++, active++) {
+			todo.push_back(((uint64_t)next << 2) | OP_OPEN);
+			if (!head)
+				todo.push_back(((uint64_t)next << 2) | OP_STATX);
+		}
+
+		for(k=0; k<todo.size(); k++) {
+			struct io_uring_sqe	*q;
+			unsigned	idx = todo[k] >> 2;
+			BATCHSLOT	&s = slot[idx];
+
+			if (NULL == (q = ring.sqe()))
+				break;
+			q->user_data = todo[k];
+			switch(todo[k] & 3) {
+			case OP_OPEN:
+				q->opcode = IORING_OP_OPENAT;
+				q->fd = AT_FDCWD;
+				q->addr = (uint64_t)m_cards[idx].c_str();
+				q->open_flags = O_RDONLY;
+				break;
+			case OP_STATX:
+				q->opcode = IORING_OP_STATX;
+				q->fd = AT_FDCWD;
+				q->addr = (uint64_t)m_cards[idx].c_str();
+				q->len  = STATX_SIZE;
+				q->off  = (uint64_t)&s.m_stx;
+				break;
+			case OP_READ:
+				q->opcode = IORING_OP_READ;
+				q->fd   = s.m_fd;
+				q->addr = (uint64_t)&s.m_buf[s.m_len];
+				q->len  = s.m_cap - s.m_len;
+				q->off  = s.m_len;
+				break;
+			case OP_CLOSE:
+				q->opcode = IORING_OP_CLOSE;
+				q->fd = s.m_fd;
+				break;
+			}
+			s.m_ops++;
+			inflight++;
+		}
+		todo.erase(todo.begin(), todo.begin()+k);
+
+		if (inflight == 0 || !ring.submit(1)) {
+			// Nothing to wait on, yet not done.  Shouldn't happen.
+			ok = false;
+			break;
+		}
+
+		while(ring.cqe(c)) {
+			unsigned	idx = c.user_data >> 2;
+			BATCHSLOT	&s = slot[idx];
+
+			inflight--;
+			s.m_ops--;
+			switch(c.user_data & 3) {
+			case OP_OPEN:
+				if (c.res < 0)
+					s.m_failed = true;
+				else
+					s.m_fd = c.res;
+				break;
+			case OP_STATX:
+				if (c.res < 0)
+					s.m_failed = true;
+				else
+					s.m_sized = true;
+				break;
+			case OP_READ:
+				s.m_reading = false;
+				if (c.res < 0)
+					s.m_failed = true;
+				else {
+					s.m_len += c.res;
+					if (head || c.res == 0 || s.m_len < s.m_cap)
+						s.m_read = true;
+				}
+				break;
+			case OP_CLOSE:
+				s.m_fd = -1;
+				break;
+			}
+
+			// What's next for this card?
+			if (s.m_delivered) {
+				if (s.m_ops == 0 && s.m_fd < 0 && !s.m_done) {
+					s.m_done = true;
+					finished++;
+					active--;
+				}
+				continue;
+			}
+
+			if (s.m_failed || (!head && s.m_sized && limit > 0
+					&& s.m_stx.stx_size > limit)) {
+				// Leave this one to the caller
+				if (s.m_ops > 0)
+					continue;
+				s.m_read = true;
+				s.m_len = 0;
+				delete[] s.m_buf;
+				s.m_buf = NULL;
+			}
+
+			if (s.m_read) {
+				cb(idx, s.m_buf, s.m_len);
+				delete[] s.m_buf;
+				s.m_buf = NULL;
+				s.m_delivered = true;
+				if (s.m_fd >= 0)
+					todo.push_back(((uint64_t)idx << 2) | OP_CLOSE);
+				else if (s.m_ops == 0) {
+					s.m_done = true;
+					finished++;
+					active--;
+				}
+			} else if (s.m_fd >= 0 && s.m_sized && !s.m_reading) {
+				if (NULL == s.m_buf) {
+					s.m_cap = (head) ? limit : s.m_stx.stx_size + 1;
+					s.m_buf = new char[s.m_cap];
+				} else {
+					// It's grown since we looked
+					char	*old = s.m_buf;
+
+					s.m_buf = new char[2*s.m_cap];
+					memcpy(s.m_buf, old, s.m_len);
+					delete[] old;
+					s.m_cap *= 2;
+				}
+				s.m_reading = true;
+				todo.push_back(((uint64_t)idx << 2) | OP_READ);
+			}
+		}
+	}
+
+	if (!ok) {
+		// The kernel may still be opening cards, and reading into
+		// their buffers.  Take back what it hasn't been given, and
+		// wait out the rest before freeing anything.  The operations
+		// are all on files, so they finish on their own: should
+		// waiting fail, the completions are polled for instead.
+		inflight -= ring.withdraw();
+		while(inflight > 0) {
+			struct io_uring_cqe	c;
+
+			while(ring.cqe(c)) {
+				BATCHSLOT	&s = slot[c.user_data >> 2];
+
+				inflight--;
+				if ((c.user_data & 3) == OP_OPEN && c.res >= 0)
+					s.m_fd = c.res;
+				else if ((c.user_data & 3) == OP_CLOSE)
+					s.m_fd = -1;
+			}
+
+			if (inflight > 0 && !ring.submit(1))
+				usleep(1000);
+		}
+
+		// Give back whatever's left to be read by name
+		for(unsigned k=0; k<n; k++) {
+			BATCHSLOT	&s = slot[k];
+
+			if (s.m_fd >= 0)
+				::close(s.m_fd);
+			if (!s.m_delivered)
+				cb(k, NULL, 0);
+			delete[] s.m_buf;
+		}
+	}
+
+	return true;
+}
+// }}}
+#else
+bool	CARDBATCH::uring(CALLBACK cb, size_t limit, bool head) {
+	return false;
+}
+#endif
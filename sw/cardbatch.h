@@ -0,0 +1,91 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename:	sw/cardbatch.h
+//
+// Project:	Xtimesheet, a very simple text-based timesheet tracking program
+// {{{
+// Purpose:	Reads a whole list of cards into memory at once.  Where the
+//		kernel supports it, the opens, statx() calls, reads, and closes
+//	for every card are handed to an io_uring together, rather than made
+//	one card after another, and each card is passed on as soon as it's
+//	arrived.  Otherwise, or should the ring fail to set up, the cards are
+//	read one at a time with read().
+//
+//	Meant for the many small cards named in ~/.xtimesheet.  Cards larger
+//	than a limit are left alone, for the caller to read however suits it
+//	best--by seeking, or from the end.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2017-2024, Gisselquist Technology, LLC
+// {{{
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	GPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/gpl.html
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+#ifndef	CARDBATCH_H
+#define	CARDBATCH_H
+
+#include <sys/types.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+class	CARDBATCH {
+public:
+	// Called once for each card, in whatever order they arrive.  data
+	// is NULL if the card wasn't read: it couldn't be, or it was too
+	// large.  Either way, the caller should try it by name.  data is
+	// valid only for the duration of the call.
+	typedef	std::function<void(unsigned card, const char *data,
+				size_t len)>	CALLBACK;
+private:
+	std::vector<std::string>	m_cards;
+	bool	m_uring;	// Try io_uring first?
+	bool	m_used;		// Was it used, the last time?
+
+	void	serial(CALLBACK cb, size_t limit, bool head);
+	bool	uring(CALLBACK cb, size_t limit, bool head);
+public:
+	CARDBATCH(void) { m_uring = true; m_used = false; }
+
+	void	add(const char *fname) { m_cards.push_back(fname); }
+	void	clear(void) { m_cards.clear(); }
+	unsigned	size(void) const { return m_cards.size(); }
+	const char	*name(unsigned card) const {
+		return m_cards[card].c_str(); }
+
+	// Whole cards, skipping any larger than limit bytes (zero for no
+	// limit)
+	void	read(CALLBACK cb, size_t limit = 0);
+
+	// Only the first len bytes of each card
+	void	head(CALLBACK cb, size_t len);
+
+	// For comparison: never use io_uring.  And, did the last read?
+	void	set_uring(bool on) { m_uring = on; }
+	bool	used_uring(void) const { return m_used; }
+};
+
+#endif	// CARDBATCH_H
@@ -0,0 +1,395 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename:	sw/cardfile.cpp
+//
+// Project:	Xtimesheet, a very simple text-based timesheet tracking program
+// {{{
+// Purpose:	A buffered line reader for time cards, which transparently
+//		decompresses gzip'd and zstd'd cards as it goes.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2017-2024, Gisselquist Technology, LLC
+// {{{
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	GPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/gpl.html
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+__attribute__((unused))
+static const char *cpyright = "(C) 2024 Gisselquist Technology, LLC: " __FILE__;
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "cardfile.h"
+
+CARDFILE::CARDFILE(void) {
+	// {{{
+	m_fd   = -1;
+	m_kind = CF_PLAIN;
+	m_eof  = true;
+	m_ended = m_more = m_err = false;
+	m_in   = new unsigned char[BUFLEN];
+	m_buf  = new char[BUFLEN];
+	m_pos  = m_len = 0;
+	m_base = 0;
+	m_mem  = NULL;
+	m_memlen = 0;
+#ifdef	HAVE_ZSTD
+	m_zs = NULL;
+#endif
+}
+// }}}
+
+CARDFILE::~CARDFILE(void) {
+	// {{{
+	close();
+	delete[] m_in;
+	delete[] m_buf;
+}
+// }}}
+
+bool	CARDFILE::open(const char *fname) {
+	// {{{
+	ssize_t	nr;
+
+	close();
+	if (0 > (m_fd = ::open(fname, O_RDONLY)))
+		return false;
+
+	m_eof = false;
+	m_ended = m_more = m_err = false;
+	m_fname = fname;
+	m_pos = m_len = 0;
+	m_base = 0;
+
+	// Read the first block, and look for a magic number at its front
+	nr = read(m_fd, m_in, BUFLEN);
+	if (nr < 0) {
+		close();
+		return false;
+	}
+
+	if (nr >= 2 && m_in[0] == 0x1f && m_in[1] == 0x8b) {
+		// {{{
+		m_kind = CF_GZIP;
+		memset(&m_gz, 0, sizeof(m_gz));
+		// 15 window bits, +32 to accept either a gzip or zlib header
+		if (Z_OK != inflateInit2(&m_gz, 15+32)) {
+			close();
+			return false;
+		}
+		m_gz.next_in  = m_in;
+		m_gz.avail_in = nr;
+		// }}}
+	} else if (nr >= 4 && m_in[0] == 0x28 && m_in[1] == 0xb5
+				&& m_in[2] == 0x2f && m_in[3] == 0xfd) {
+		// {{{
+#ifdef	HAVE_ZSTD
+		m_kind = CF_ZSTD;
+		m_zs = ZSTD_createDStream();
+		if (NULL == m_zs || ZSTD_isError(ZSTD_initDStream(m_zs))) {
+			close();
+			return false;
+		}
+		m_zin.src  = m_in;
+		m_zin.size = nr;
+		m_zin.pos  = 0;
+#else
+		fprintf(stderr, "ERR: %s is zstd compressed, but zstd support "
+			"wasn't built in\n", fname);
+		close();
+		return false;
+#endif
+		// }}}
+	} else {
+		// Plain text.  What we've read is the first block of lines.
+		m_kind = CF_PLAIN;
+		memcpy(m_buf, m_in, nr);
+		m_len = nr;
+	}
+
+	return true;
+}
+// }}}
+
+bool	CARDFILE::open(const char *data, size_t len) {
+	// {{{
+	const unsigned char	*magic = (const unsigned char *)data;
+
+	close();
+	if ((len >= 2 && magic[0] == 0x1f && magic[1] == 0x8b)
+		|| (len >= 4 && magic[0] == 0x28 && magic[1] == 0xb5
+				&& magic[2] == 0x2f && magic[3] == 0xfd))
+		return false;
+
+	m_mem    = data;
+	m_memlen = len;
+	m_kind = CF_PLAIN;
+	m_eof  = false;
+	m_ended = m_more = m_err = false;
+	m_fname = "(memory)";
+	m_pos  = m_len = 0;
+	m_base = 0;
+	return true;
+}
+// }}}
+
+void	CARDFILE::close(void) {
+	// {{{
+	if (m_mem) {
+		m_mem  = NULL;
+		m_memlen = 0;
+		m_eof  = true;
+		m_pos  = m_len = 0;
+		return;
+	}
+
+	if (m_fd < 0)
+		return;
+
+	if (m_kind == CF_GZIP)
+		inflateEnd(&m_gz);
+#ifdef	HAVE_ZSTD
+	if (m_zs)
+		ZSTD_freeDStream(m_zs);
+	m_zs = NULL;
+#endif
+
+	::close(m_fd);
+	m_fd   = -1;
+	m_kind = CF_PLAIN;
+	m_eof  = true;
+	m_pos  = m_len = 0;
+}
+// }}}
+
+bool	CARDFILE::fill(void) {
+	// {{{
+	ssize_t	nr;
+
+	m_base += m_len;
+	m_pos = m_len = 0;
+	if (m_eof)
+		return false;
+
+	switch(m_kind) {
+	case CF_GZIP:	return fill_gzip();
+	case CF_ZSTD:	return fill_zstd();
+	default:
+		if (m_mem) {
+			nr = ((size_t)m_base < m_memlen)
+				? m_memlen - m_base : 0;
+			if (nr > BUFLEN)
+				nr = BUFLEN;
+			memcpy(m_buf, &m_mem[m_base], nr);
+		} else
+			nr = read(m_fd, m_buf, BUFLEN);
+		if (nr <= 0) {
+			if (nr < 0)
+				fail("read error", strerror(errno));
+			m_eof = true;
+			return false;
+		}
+		m_len = nr;
+		return true;
+	}
+}
+// }}}
+
+void	CARDFILE::fail(const char *why, const char *detail) {
+	// {{{
+	if (detail)
+		fprintf(stderr, "ERR: %s: %s: %s\n", m_fname.c_str(), why, detail);
+	else
+		fprintf(stderr, "ERR: %s: %s\n", m_fname.c_str(), why);
+	m_err = true;
+	m_eof = true;
+}
+// }}}
+
+ssize_t	CARDFILE::refill(void) {
+	// {{{
+	ssize_t	nr = read(m_fd, m_in, BUFLEN);
+
+	// Running out of input partway through a stream means the file was
+	// cut short.  What's been read so far is only part of the card.
+	if (nr < 0)
+		fail("read error", strerror(errno));
+	else if (nr == 0 && !m_ended)
+		fail("truncated compressed stream");
+	else if (nr == 0)
+		m_eof = true;
+	return nr;
+}
+// }}}
+
+bool	CARDFILE::fill_gzip(void) {
+	// {{{
+	ssize_t	nr;
+	int	r;
+
+	do {
+		// Once the output buffer's been filled, inflate() may hold
+		// more yet, even with no more input
+		if (m_gz.avail_in == 0 && !m_more) {
+			if ((nr = refill()) <= 0)
+				return false;
+			m_gz.next_in  = m_in;
+			m_gz.avail_in = nr;
+		}
+
+		m_gz.next_out  = (Bytef *)m_buf;
+		m_gz.avail_out = BUFLEN;
+		r = inflate(&m_gz, Z_NO_FLUSH);
+		m_len = BUFLEN - m_gz.avail_out;
+		m_more = (m_gz.avail_out == 0);
+
+		if (r == Z_STREAM_END) {
+			// gzip files may hold several members, one after
+			// another.  Get ready for the next, should there be one.
+			inflateReset(&m_gz);
+			m_ended = true;
+		} else if (r == Z_OK) {
+			m_ended = false;
+		} else if (r != Z_BUF_ERROR) {
+			fail("corrupt gzip data",
+				(m_gz.msg) ? m_gz.msg : "(unknown)");
+			return (m_len > 0);
+		}
+	} while(m_len == 0);
+
+	return true;
+}
+// }}}
+
+bool	CARDFILE::fill_zstd(void) {
+	// {{{
+#ifdef	HAVE_ZSTD
+	ZSTD_outBuffer	zout;
+	ssize_t		nr;
+	size_t		r;
+
+	do {
+		if (m_zin.pos >= m_zin.size && !m_more) {
+			if ((nr = refill()) <= 0)
+				return false;
+			m_zin.src  = m_in;
+			m_zin.size = nr;
+			m_zin.pos  = 0;
+		}
+
+		zout.dst  = m_buf;
+		zout.size = BUFLEN;
+		zout.pos  = 0;
+		r = ZSTD_decompressStream(m_zs, &zout, &m_zin);
+		m_len = zout.pos;
+
+		if (ZSTD_isError(r)) {
+			fail("corrupt zstd data", ZSTD_getErrorName(r));
+			return (m_len > 0);
+		}
+
+		// Zero once a frame has been decoded, and all of it flushed
+		m_ended = (r == 0);
+		m_more  = (zout.pos == zout.size);
+	} while(m_len == 0);
+
+	return true;
+#else
+	m_eof = true;
+	return false;
+#endif
+}
+// }}}
+
+char	*CARDFILE::gets(char *line, int len) {
+	// {{{
+	int	n = 0;
+
+	if (len <= 1)
+		return NULL;
+
+	while(n < len-1) {
+		const char	*src, *nl;
+		unsigned	avail, cnt;
+
+		if (m_pos >= m_len && !fill())
+			break;
+
+		src   = &m_buf[m_pos];
+		avail = m_len - m_pos;
+		if (avail > (unsigned)(len-1-n))
+			avail = len-1-n;
+
+		nl  = (const char *)memchr(src, '\n', avail);
+		cnt = (nl) ? (nl - src + 1) : avail;
+		memcpy(&line[n], src, cnt);
+		n     += cnt;
+		m_pos += cnt;
+
+		if (nl)
+			break;
+	}
+
+	if (n == 0)
+		return NULL;
+
+	line[n] = '\0';
+	return line;
+}
+// }}}
+
+off_t	CARDFILE::size(void) const {
+	// {{{
+	struct	stat	sb;
+
+	if (m_mem)
+		return m_memlen;
+	if (m_fd < 0 || 0 != fstat(m_fd, &sb))
+		return 0;
+	return sb.st_size;
+}
+// }}}
+
+bool	CARDFILE::seek(off_t offset) {
+	// {{{
+	if (m_mem) {
+		if (offset < 0 || (size_t)offset > m_memlen)
+			return false;
+	} else if (m_fd < 0 || m_kind != CF_PLAIN)
+		return false;
+	else if (offset != lseek(m_fd, offset, SEEK_SET))
+		return false;
+
+	m_base = offset;
+	m_pos  = m_len = 0;
+	m_eof  = false;
+	return true;
+}
+// }}}
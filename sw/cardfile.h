@@ -0,0 +1,111 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename:	sw/cardfile.h
+//
+// Project:	Xtimesheet, a very simple text-based timesheet tracking program
+// {{{
+// Purpose:	Reads the lines of a time card, whether the card is plain
+//		text or has been archived with gzip or zstd.  Compressed cards
+//	are recognized by their magic bytes, not their names, and are
+//	decompressed one block at a time straight into the line reader--no
+//	temporary files, and no more memory than two fixed size buffers.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2017-2024, Gisselquist Technology, LLC
+// {{{
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	GPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/gpl.html
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+#ifndef	CARDFILE_H
+#define	CARDFILE_H
+
+#include <sys/types.h>
+#include <zlib.h>
+#include <string>
+#ifdef	HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+class	CARDFILE {
+public:
+	static const unsigned	BUFLEN = 65536;
+	typedef	enum { CF_PLAIN, CF_GZIP, CF_ZSTD } CFKIND;
+private:
+	int		m_fd;
+	CFKIND		m_kind;
+	bool		m_eof;
+	bool		m_ended;	// Compressed stream ended cleanly
+	bool		m_more;		// Decompressor may have more output
+	bool		m_err;		// Truncated, corrupt, or unreadable
+	std::string	m_fname;	// For reporting any of the above
+	unsigned char	*m_in;		// Compressed data, as read
+	char		*m_buf;		// Text, ready to be split into lines
+	unsigned	m_pos, m_len;
+	off_t		m_base;		// File offset of m_buf[0], plain text only
+	const char	*m_mem;		// A card already in memory, or NULL
+	size_t		m_memlen;
+
+	z_stream	m_gz;
+#ifdef	HAVE_ZSTD
+	ZSTD_DStream	*m_zs;
+	ZSTD_inBuffer	m_zin;
+#endif
+
+	bool	fill(void);
+	bool	fill_gzip(void);
+	bool	fill_zstd(void);
+	// Reads more compressed data, returning false at its end
+	ssize_t	refill(void);
+	void	fail(const char *why, const char *detail = NULL);
+public:
+	CARDFILE(void);
+	~CARDFILE(void);
+
+	bool	open(const char *fname);
+	// A plain text card that's already been read into memory, which
+	// must stay put until close().  Fails on compressed data.
+	bool	open(const char *data, size_t len);
+	void	close(void);
+	bool	isopen(void) const { return m_fd >= 0 || m_mem != NULL; }
+	CFKIND	kind(void) const { return m_kind; }
+	// True once a read has failed, or a compressed card turned out to be
+	// corrupt or cut short.  Whatever was read before then was returned,
+	// but the card wasn't read to its end.
+	bool	error(void) const { return m_err; }
+
+	// Works just like fgets(): at most len-1 characters, stopping after
+	// the first newline.  Returns NULL at the end of the file.
+	char	*gets(char *line, int len);
+
+	// Plain text cards only: the size of the file, the offset of the
+	// next character gets() will return, and a way to move it.  seek()
+	// fails on compressed cards.
+	off_t	size(void) const;
+	off_t	tell(void) const { return m_base + m_pos; }
+	bool	seek(off_t offset);
+};
+
+#endif	// CARDFILE_H
@@ -0,0 +1,274 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename:	sw/cardio.cpp
+//
+// Project:	Xtimesheet, a very simple text-based timesheet tracking program
+// {{{
+// Purpose:	The GUI's time card I/O, carried out on a thread of its own.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2017-2024, Gisselquist Technology, LLC
+// {{{
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	GPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/gpl.html
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+__attribute__((unused))
+static const char *cpyright = "(C) 2024 Gisselquist Technology, LLC: " __FILE__;
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "cardscan.h"
+#include "cardio.h"
+
+CARDIO::CARDIO(void) {
+	// {{{
+	sem_init(&m_wake, 0, 0);
+	m_running = false;
+	m_stopping = false;
+}
+// }}}
+
+CARDIO::~CARDIO(void) {
+	// {{{
+	shutdown();
+	sem_destroy(&m_wake);
+}
+// }}}
+
+void	CARDIO::start(std::function<void(void)> notify) {
+	// {{{
+	if (m_running)
+		return;
+	m_notify = notify;
+	m_running = true;
+	m_thread = std::thread(&CARDIO::run, this);
+}
+// }}}
+
+void	CARDIO::flush(void) {
+	// {{{
+	unsigned	k;
+
+	for(k=0; k<m_backlog.size(); k++) {
+		if (!m_requests.push(m_backlog[k]))
+			break;
+		sem_post(&m_wake);
+	}
+
+	m_backlog.erase(m_backlog.begin(), m_backlog.begin()+k);
+}
+// }}}
+
+void	CARDIO::post(CARDREQ *req) {
+	// {{{
+	// Keep requests in order: nothing may pass the backlog
+	flush();
+	if (m_backlog.empty() && m_requests.push(req))
+		sem_post(&m_wake);
+	else
+		m_backlog.push_back(req);
+}
+// }}}
+
+CARDREQ	*CARDIO::result(void) {
+	// {{{
+	CARDREQ	*req;
+
+	flush();
+	return (m_results.pop(req)) ? req : NULL;
+}
+// }}}
+
+void	CARDIO::shutdown(void) {
+	// {{{
+	CARDREQ	*req;
+
+	if (m_running) {
+		// Nothing more will be taken from m_results, so the worker
+		// mustn't wait on room there
+		m_stopping = true;
+		post(new CARDREQ(CR_QUIT));
+		while(!m_backlog.empty()) {
+			usleep(1000);
+			flush();
+		}
+		m_thread.join();
+		m_running = false;
+		m_stopping = false;
+	}
+
+	while(m_results.pop(req))
+		delete req;
+}
+// }}}
+
+void	CARDIO::deliver(CARDREQ *req) {
+	// {{{
+	// Only the GUI can make room, and it's told whenever there's
+	// something to take--unless it's shutting down, and won't
+	while(!m_results.push(req)) {
+		if (m_stopping) {
+			delete req;
+			return;
+		}
+		m_notify();
+		usleep(1000);
+	}
+	m_notify();
+}
+// }}}
+
+void	CARDIO::run(void) {
+	// {{{
+	CARDREQ	*req;
+
+	while(1) {
+		if (0 != sem_wait(&m_wake))
+			continue;	// EINTR
+		if (!m_requests.pop(req))
+			continue;
+
+		switch(req->m_kind) {
+		case CR_LOG:
+			log(req->m_fname.c_str(), req->m_start, req->m_stop);
+			delete req;
+			break;
+		case CR_START:
+			note_start(req->m_fname.c_str(), req->m_start);
+			delete req;
+			break;
+		case CR_READ:
+			read(req);
+			deliver(req);
+			break;
+		case CR_TALLY:
+			req->m_secs = m_tally.today();
+			deliver(req);
+			break;
+		case CR_ADDCARD:
+			m_tally.add(req->m_fname.c_str());
+			delete req;
+			break;
+		case CR_HISTORY:
+			history(req);
+			deliver(req);
+			break;
+		case CR_QUIT:
+			delete req;
+			return;
+		}
+	}
+}
+// }}}
+
+// read -- read whatever has been added to a card since it was last read
+void	CARDIO::read(CARDREQ *req) {
+	// {{{
+	FILE		*fp;
+	struct	stat	sb;
+	char		*buf, tail[CARDREQ::TAILLEN];
+	unsigned	ntail = req->m_tail.size();
+	off_t		len;
+
+	req->m_error = req->m_restart = false;
+	req->m_data.clear();
+	if (NULL == (fp = fopen(req->m_fname.c_str(), "r"))
+			|| 0 != fstat(fileno(fp), &sb)) {
+		req->m_error = true;
+		if (fp)
+			fclose(fp);
+		return;
+	}
+
+	// Cards are only ever appended to.  Anything else--a card edited by
+	// hand, or replaced--starts us over from the top.  So does adding
+	// to a last line that was taken, without its newline, as finished.
+	if (!req->m_scanned || sb.st_ino != req->m_ino
+		|| sb.st_size < req->m_size
+		|| (ntail > 0 && req->m_tail[ntail-1] != '\n'
+			&& sb.st_size > req->m_size)
+		|| (ntail > 0 && (0 != fseeko(fp, req->m_size-ntail, SEEK_SET)
+			|| ntail != fread(tail, 1, ntail, fp)
+			|| 0 != memcmp(tail, req->m_tail.data(), ntail)))) {
+		req->m_restart = true;
+		req->m_size = 0;
+	}
+	req->m_ino = sb.st_ino;
+
+	len = sb.st_size - req->m_size;
+	if (len > 0) {
+		buf = new char[len];
+		if (0 == fseeko(fp, req->m_size, SEEK_SET))
+			len = fread(buf, 1, len, fp);
+		else
+			len = 0;
+
+		// A line still being written will be read next time.  One
+		// that's no longer changing is taken as it is, newline or
+		// not, as is one found when reading from the top.
+		if (!req->m_restart && sb.st_size != req->m_seen)
+			while(len > 0 && buf[len-1] != '\n')
+				len--;
+		req->m_data.assign(buf, len);
+		req->m_size += len;
+		delete[] buf;
+	}
+	req->m_seen = sb.st_size;
+
+	// Remember how the card ended, to know it's unchanged next time
+	ntail = (req->m_size < (off_t)CARDREQ::TAILLEN)
+			? req->m_size : CARDREQ::TAILLEN;
+	if (0 == fseeko(fp, req->m_size - ntail, SEEK_SET)
+			&& ntail == fread(tail, 1, ntail, fp))
+		req->m_tail.assign(tail, ntail);
+	else
+		req->m_tail.clear();
+
+	fclose(fp);
+}
+// }}}
+
+// history -- the history of a list of cards, taken together
+void	CARDIO::history(CARDREQ *req) {
+	// {{{
+	CARDSCAN	card;
+	CARDEVENT	ev;
+
+	req->m_hist = new HISTPYRAMID();
+	for(unsigned k=0; k<req->m_cards.size(); k++) {
+		if (!card.open(req->m_cards[k].c_str()))
+			continue;
+		while(card.next(ev))
+			if (ev.m_kind == CE_INTERVAL)
+				req->m_hist->add(ev.m_start, ev.m_stop);
+		card.close();
+	}
+}
+// }}}
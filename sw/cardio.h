@@ -0,0 +1,166 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename:	sw/cardio.h
+//
+// Project:	Xtimesheet, a very simple text-based timesheet tracking program
+// {{{
+// Purpose:	A worker thread that does all of the GUI's time card I/O, so
+//		that a slow disk (or a slow NFS home directory) can never hold
+//	up the window.  Requests go to the worker, and results come back,
+//	through a pair of lock-free queues.  Each request is new'd by the
+//	thread posting it, and deleted by whichever thread is done with it.
+//
+//	Requests are carried out in the order they were posted, so a card
+//	read after an interval was logged to it will always find that
+//	interval.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2017-2024, Gisselquist Technology, LLC
+// {{{
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	GPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/gpl.html
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+#ifndef	CARDIO_H
+#define	CARDIO_H
+
+#include <sys/types.h>
+#include <semaphore.h>
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "spscq.h"
+#include "timecard.h"
+#include "daytally.h"
+#include "histpyr.h"
+
+typedef	enum	{
+	CR_LOG,		// Append an interval to a card
+	CR_START,	// Note the start of an interval
+	CR_READ,	// Read what's new on a card
+	CR_TALLY,	// Count today's time, over every card added to
+	CR_ADDCARD,	// ... the tally
+	CR_HISTORY,	// Build a history of a list of cards
+	CR_QUIT
+} CARDREQ_KIND;
+
+class	CARDREQ {
+public:
+	static const unsigned	TAILLEN = 64;
+
+	CARDREQ_KIND	m_kind;
+	std::string	m_fname;
+	time_t		m_start, m_stop;	// CR_LOG, CR_START
+
+	// CR_READ.  Where the last read left off, on the way in, and where
+	// this one did, on the way out.  m_data holds only whole lines, save
+	// for a last line without a newline that's been left alone since the
+	// card was last read, or that's found when reading from the top.
+	// m_seen is the card's size when last read, whole lines or not.
+	bool		m_scanned, m_restart, m_error;
+	ino_t		m_ino;
+	off_t		m_size, m_seen;
+	std::string	m_tail, m_data;
+
+	unsigned long	m_secs;			// CR_TALLY
+	std::vector<std::string>	m_cards;	// CR_HISTORY
+	HISTPYRAMID	*m_hist;
+
+	// Left for the poster, untouched by the worker
+	unsigned long	m_serial, m_logged;
+
+	CARDREQ(CARDREQ_KIND kind, const char *fname = NULL) {
+		m_hist = NULL;
+		reset(kind, fname);
+	}
+
+	~CARDREQ(void) {
+		if (m_hist)
+			delete m_hist;
+	}
+
+	// Readies a used request to be posted again.  Its strings keep
+	// their buffers, so reusing one needn't allocate.
+	void	reset(CARDREQ_KIND kind, const char *fname = NULL) {
+		m_kind = kind;
+		if (fname)
+			m_fname.assign(fname);
+		else
+			m_fname.clear();
+		m_start = m_stop = 0;
+		m_scanned = m_restart = m_error = false;
+		m_ino = 0;
+		m_size = m_seen = 0;
+		m_tail.clear();
+		m_data.clear();
+		m_secs = 0;
+		m_cards.clear();
+		if (m_hist)
+			delete m_hist;
+		m_hist = NULL;
+		m_serial = m_logged = 0;
+	}
+};
+
+class	CARDIO : public TIMECARD {
+	SPSCQUEUE<CARDREQ *, 256>	m_requests, m_results;
+	std::vector<CARDREQ *>	m_backlog;	// Waiting on a full queue
+	sem_t			m_wake;
+	std::thread		m_thread;
+	std::function<void(void)>	m_notify;
+	bool			m_running;
+	// Set by shutdown(), once no one will take any more results
+	std::atomic<bool>	m_stopping;
+	DAYTALLY		m_tally;	// Worker only
+
+	void	run(void);
+	void	read(CARDREQ *req);
+	void	history(CARDREQ *req);
+	void	deliver(CARDREQ *req);
+	void	flush(void);
+public:
+	CARDIO(void);
+	~CARDIO(void);
+
+	// Starts the worker.  notify() is called, from the worker, each time
+	// a result is ready.  Requests may be posted before this.
+	void	start(std::function<void(void)> notify);
+
+	// Posts a request.  Never waits.
+	void	post(CARDREQ *req);
+
+	// Returns the next result, or NULL if there are none.  The caller
+	// deletes it.
+	CARDREQ	*result(void);
+
+	// Waits for everything posted to be carried out, and the worker to
+	// end.  Results still waiting are discarded.
+	void	shutdown(void);
+};
+
+#endif	// CARDIO_H
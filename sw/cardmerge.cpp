@@ -0,0 +1,182 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename:	sw/cardmerge.cpp
+//
+// Project:	Xtimesheet, a very simple text-based timesheet tracking program
+// {{{
+// Purpose:	A k-way, heap-based, chronological merge of time cards.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2017-2024, Gisselquist Technology, LLC
+// {{{
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	GPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/gpl.html
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+__attribute__((unused))
+static const char *cpyright = "(C) 2024 Gisselquist Technology, LLC: " __FILE__;
+
+#include <limits.h>
+#include <ctype.h>
+
+#include "cardmerge.h"
+
+CARDMERGE::~CARDMERGE(void) {
+	// {{{
+	for(unsigned k=0; k<m_src.size(); k++)
+		delete m_src[k].m_scan;
+}
+// }}}
+
+void	CARDMERGE::sift_up(unsigned k) {
+	// {{{
+	HEAPENT		v = m_heap[k];
+
+	while(k > 0) {
+		unsigned	parent = (k-1)/2;
+
+		if (!before(v, m_heap[parent]))
+			break;
+		m_heap[k] = m_heap[parent];
+		k = parent;
+	} m_heap[k] = v;
+}
+// }}}
+
+void	CARDMERGE::sift_down(unsigned k) {
+	// {{{
+	HEAPENT		v = m_heap[k];
+	unsigned	n = m_heap.size();
+
+	for(;;) {
+		unsigned	child = 2*k+1;
+
+		if (child >= n)
+			break;
+		if (child+1 < n && before(m_heap[child+1], m_heap[child]))
+			child++;
+		if (!before(m_heap[child], v))
+			break;
+		m_heap[k] = m_heap[child];
+		k = child;
+	} m_heap[k] = v;
+}
+// }}}
+
+void	CARDMERGE::advance(unsigned src) {
+	// {{{
+	// src is at the top of the heap.  Replace it with its next event,
+	// or drop it if it has none.
+	SOURCE	&s = m_src[src];
+
+	if (s.m_scan->next(s.m_ev)) {
+		// Events other than intervals stay in place within their card
+		if (s.m_ev.m_kind == CE_INTERVAL)
+			s.m_last = s.m_ev.m_start;
+		m_heap[0].m_key = s.m_last;
+		sift_down(0);
+	} else {
+		if (s.m_scan->error())
+			m_nfailed++;
+		s.m_scan->close();
+		m_heap[0] = m_heap.back();
+		m_heap.pop_back();
+		if (!m_heap.empty())
+			sift_down(0);
+	}
+}
+// }}}
+
+bool	CARDMERGE::add(const char *fname) {
+	// {{{
+	SOURCE		s;
+	HEAPENT		h;
+	const char	*base, *ext;
+
+	s.m_scan = new CARDSCAN;
+	if (!s.m_scan->open(fname)) {
+		delete s.m_scan;
+		return false;
+	}
+
+	s.m_fname = fname;
+	base = strrchr(fname, '/');
+	base = (base) ? base+1 : fname;
+	ext  = strchr(base, '.');
+	s.m_name.assign(base, (ext) ? (size_t)(ext-base) : strlen(base));
+
+	// Anything before the first interval sorts before everything else
+	s.m_last = LONG_MIN;
+	if (!s.m_scan->next(s.m_ev)) {
+		// An empty card.  Keep its name, but nothing else.
+		if (s.m_scan->error())
+			m_nfailed++;
+		s.m_scan->close();
+		m_src.push_back(s);
+		return true;
+	}
+
+	if (s.m_ev.m_kind == CE_INTERVAL)
+		s.m_last = s.m_ev.m_start;
+	m_src.push_back(s);
+
+	h.m_key = s.m_last;
+	h.m_src = m_src.size()-1;
+	m_heap.push_back(h);
+	sift_up(m_heap.size()-1);
+	return true;
+}
+// }}}
+
+bool	CARDMERGE::next(CARDEVENT &ev, unsigned &src) {
+	// {{{
+	// The event we returned last time is only now done with
+	if (m_last >= 0)
+		advance(m_last);
+	m_last = -1;
+
+	if (m_heap.empty())
+		return false;
+
+	src = m_heap[0].m_src;
+	ev  = m_src[src].m_ev;
+	m_last = src;
+
+	if (ev.m_kind == CE_PROJECT) {
+		const char	*name = &ev.m_line[8];
+		unsigned	len;
+
+		while(*name && isspace(*name))
+			name++;
+		len = strlen(name);
+		while(len > 0 && isspace(name[len-1]))
+			len--;
+		if (len > 0)
+			m_src[src].m_name.assign(name, len);
+	}
+
+	return true;
+}
+// }}}
@@ -0,0 +1,107 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename:	sw/cardmerge.h
+//
+// Project:	Xtimesheet, a very simple text-based timesheet tracking program
+// {{{
+// Purpose:	Merges the event streams of several time cards into one,
+//		in time order.  Each card is expected to be in date order
+//	already, as cards written by xtimesheet are.  The merge keeps one
+//	pending event per card in a binary heap, so memory grows with the
+//	number of cards, never with their length.
+//
+//	Events other than intervals are kept in their place within their
+//	own card: they sort at the time of the last interval before them.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2017-2024, Gisselquist Technology, LLC
+// {{{
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	GPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/gpl.html
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+#ifndef	CARDMERGE_H
+#define	CARDMERGE_H
+
+#include <string>
+#include <vector>
+
+#include "cardscan.h"
+
+class	CARDMERGE {
+	typedef	struct	{
+		CARDSCAN	*m_scan;
+		CARDEVENT	m_ev;	// The next event from this card
+		time_t		m_last;	// Start of its last interval
+		std::string	m_name, m_fname;
+	} SOURCE;
+
+	// The heap holds its sort keys, rather than looking them up in
+	// m_src, so sifting touches only this one small array
+	typedef	struct	{
+		time_t		m_key;	// When the next event sorts
+		unsigned	m_src;
+	} HEAPENT;
+
+	std::vector<SOURCE>	m_src;
+	std::vector<HEAPENT>	m_heap;
+	int			m_last;	// Source to advance on the next call
+	unsigned		m_nfailed;
+
+	static	bool	before(const HEAPENT &a, const HEAPENT &b) {
+		// Ties go to the card given first, so the merge is repeatable
+		return (a.m_key < b.m_key)
+			|| (a.m_key == b.m_key && a.m_src < b.m_src);
+	}
+
+	void	sift_up(unsigned k);
+	void	sift_down(unsigned k);
+	void	advance(unsigned src);
+public:
+	CARDMERGE(void) : m_last(-1), m_nfailed(0) {}
+	~CARDMERGE(void);
+
+	// Adds a card to the merge.  Cards must all be added before the
+	// first call to next().
+	bool	add(const char *fname);
+
+	unsigned	size(void) const { return m_src.size(); }
+
+	// The project name of a card: its Project: line, once that line
+	// has been seen, or else the card's file name, sans extension
+	const char	*name(unsigned src) const {
+		return m_src[src].m_name.c_str(); }
+	const char	*fname(unsigned src) const {
+		return m_src[src].m_fname.c_str(); }
+
+	// Returns false once every card has run out.  The event is valid
+	// until the next call.
+	bool	next(CARDEVENT &ev, unsigned &src);
+
+	// Cards that ran out early, found to be truncated or corrupt
+	unsigned	nfailed(void) const { return m_nfailed; }
+};
+
+#endif	// CARDMERGE_H
@@ -0,0 +1,326 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename:	sw/cardscan.cpp
+//
+// Project:	Xtimesheet, a very simple text-based timesheet tracking program
+// {{{
+// Purpose:	Turns the lines of a time card into a stream of events.
+//		Binary (.tcb) cards skip the text entirely for all but the
+//	lines that were kept verbatim.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2017-2024, Gisselquist Technology, LLC
+// {{{
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	GPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/gpl.html
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+__attribute__((unused))
+static const char *cpyright = "(C) 2024 Gisselquist Technology, LLC: " __FILE__;
+
+#include "cardscan.h"
+
+CARDSCAN::CARDSCAN(void) {
+	// {{{
+	m_line = new char[MXLEN];
+	m_lineno = 0;
+	m_day = 0;
+	m_midnight = 0;
+	m_nbad = 0;
+	m_quiet = false;
+}
+// }}}
+
+CARDSCAN::~CARDSCAN(void) {
+	// {{{
+	close();
+	delete[] m_line;
+}
+// }}}
+
+bool	CARDSCAN::open(const char *fname) {
+	// {{{
+	close();
+
+	m_lineno = 0;
+	m_day = 0;
+	m_midnight = 0;
+	m_nbad = 0;
+	m_fname.assign(fname);
+	if (TCBREADER::istcb(fname)) {
+		if (!m_tcb.open(fname))
+			return false;
+		// Day zero, 1970/01/01, until a record says otherwise
+		m_midnight = TZONE::local().civil(1970, 1, 1);
+		return true;
+	} return m_file.open(fname);
+}
+// }}}
+
+bool	CARDSCAN::open(const char *data, size_t len, const char *name) {
+	// {{{
+	close();
+
+	m_lineno = 0;
+	m_day = 0;
+	m_midnight = 0;
+	m_nbad = 0;
+	m_fname.assign((name) ? name : "(memory)");
+	if (len >= 4 && 0 == memcmp(data, TCB_MAGIC, 4))
+		return false;
+	return m_file.open(data, len);
+}
+// }}}
+
+void	CARDSCAN::close(void) {
+	// {{{
+	m_file.close();
+	m_tcb.close();
+}
+// }}}
+
+bool	CARDSCAN::classify(CARDEVENT &ev) {
+	// {{{
+	time_t	lnstart, lnstop;
+
+	ev.m_lineno = m_lineno;
+	ev.m_line   = m_line;
+	if (strncasecmp(m_line, "rate:", 5)==0) {
+		ev.m_kind = CE_RATE;
+		ev.m_rate = atof(&m_line[5]);
+		return true;
+	} else if (strncasecmp(m_line, "project:", 8)==0) {
+		ev.m_kind = CE_PROJECT;
+		return true;
+	} else if ((strncasecmp(m_line, "invoice", 7)==0)
+			||(strncasecmp(m_line, "billed", 6)==0)) {
+		ev.m_kind = CE_INVOICE;
+		return true;
+	} else if (parse(m_line, lnstart, lnstop)) {
+		if (lnstart > 24*3600)
+			m_midnight = get_midnight(lnstart);
+		else {
+			// \tHHMM -- HHMM, relative to the last date
+			lnstart += m_midnight;
+			lnstop  += m_midnight;
+		}
+
+		// Date lines, and empty intervals, add nothing
+		if (lnstart == lnstop)
+			return false;
+
+		ev.m_kind  = CE_INTERVAL;
+		ev.m_start = lnstart;
+		ev.m_stop  = lnstop;
+		return true;
+	} else if (reversed())
+		bad("stops before it starts");
+
+	return false;
+}
+// }}}
+
+// Counts a line skipped as bad, and says so while there aren't too many
+void	CARDSCAN::bad(const char *why) {
+	// {{{
+	m_nbad++;
+	if (m_quiet || m_nbad > MAXREPORT)
+		return;
+
+	fprintf(stderr, "WARNING: %s:%u: Interval %s, skipped\n",
+		m_fname.c_str(), m_lineno, why);
+	if (m_nbad == MAXREPORT)
+		fprintf(stderr, "WARNING: %s: Further bad lines will be "
+			"skipped quietly.  Run tclint for the rest.\n",
+			m_fname.c_str());
+}
+// }}}
+
+bool	CARDSCAN::next_tcb(CARDEVENT &ev) {
+	// {{{
+	TCBREC	rec;
+
+	while(m_tcb.next(rec)) {
+		m_lineno++;
+
+		ev.m_lineno = m_lineno;
+		switch(rec.m_kind) {
+		case TCB_INTERVAL:
+			if (rec.m_day != m_day) {
+				const TZONE	&tz = TZONE::local();
+				long		year;
+				unsigned	mon, mday;
+
+				TZONE::civil_from_days(rec.m_day, year, mon, mday);
+				m_midnight = tz.civil(year, mon, mday);
+				m_day = rec.m_day;
+			}
+
+			if (rec.m_dur == 0)
+				continue;
+			m_line[0]  = '\0';
+			ev.m_line  = m_line;
+			ev.m_kind  = CE_INTERVAL;
+			ev.m_start = m_midnight + rec.m_start;
+			ev.m_stop  = ev.m_start + rec.m_dur;
+			return true;
+		case TCB_RATE:
+			ev.m_kind = CE_RATE;
+			ev.m_rate = m_tcb.rate(rec.m_rate);
+			ev.m_line = m_tcb.rateline(rec.m_rate).c_str();
+			return true;
+		default: {
+			unsigned	len = rec.m_len;
+			bool		r;
+
+			if (len > MXLEN-1)
+				len = MXLEN-1;
+			memcpy(m_line, rec.m_text, len);
+			m_line[len] = '\0';
+
+			if (rec.m_kind == TCB_PROJECT) {
+				ev.m_kind = CE_PROJECT;
+				ev.m_line = m_line;
+				return true;
+			} else if (rec.m_kind == TCB_INVOICE) {
+				ev.m_kind = CE_INVOICE;
+				ev.m_line = m_line;
+				return true;
+			}
+
+			// A line kept verbatim.  Parse it as if it were text,
+			// and then pick up the day it left us on.
+			r = classify(ev);
+			m_day = rec.m_day;
+			if (r)
+				return true;
+			} break;
+		}
+	}
+
+	if (m_tcb.error())
+		fprintf(stderr, "ERR: Corrupt .tcb card, after line %u\n",
+			m_lineno);
+	return false;
+}
+// }}}
+
+// The first dated line starting after from, and before to
+bool	CARDSCAN::probe(off_t from, off_t to, off_t &offset, time_t &midnight) {
+	// {{{
+	time_t	lnstart, lnstop;
+
+	if (!m_file.seek(from))
+		return false;
+
+	// Resynchronize to the start of the next line
+	if (from > 0 && !m_file.gets(m_line, MXLEN))
+		return false;
+
+	// Relative times, comments, and such have no date.  Pass them by.
+	while((offset = m_file.tell()) < to && m_file.gets(m_line, MXLEN)) {
+		if (parse(m_line, lnstart, lnstop) && lnstart > 24*3600) {
+			midnight = get_midnight(lnstart);
+			return true;
+		}
+	}
+
+	return false;
+}
+// }}}
+
+bool	CARDSCAN::seek(time_t when) {
+	// {{{
+	time_t	target = get_midnight(when);
+
+	if (m_lineno != 0)
+		return true;
+
+	if (m_tcb.isopen()) {
+		struct	tm	datev;
+
+		TIMECARD::localtime(target, datev);
+		m_tcb.skip_to(TZONE::days_from_civil(datev.tm_year+1900,
+				datev.tm_mon+1, datev.tm_mday));
+		return true;
+	}
+
+	if (m_file.kind() != CARDFILE::CF_PLAIN)
+		return true;
+
+	// Bisect for a dated line before the target day, as late as can be
+	// found.  lo is always the start of a line: the top of the file, or
+	// a line dated before the target.  Any dated line at or past hi is
+	// on or after the target day.
+	off_t	lo = 0, hi = m_file.size(), offset;
+	time_t	lo_day = 0, hi_day = 0, midnight;
+	bool	have_hi = false;
+
+	while(hi - lo > (off_t)CARDFILE::BUFLEN) {
+		off_t	mid = lo + (hi - lo) / 2;
+
+		if (!probe(mid, hi, offset, midnight)) {
+			// Nothing dated between mid and hi
+			hi = mid;
+			continue;
+		}
+
+		if ((lo > 0 && midnight < lo_day)
+				|| (have_hi && midnight > hi_day)) {
+			// Out of order.  Give up, and start from the top.
+			m_file.seek(0);
+			return false;
+		}
+
+		if (midnight < target) {
+			lo = offset;
+			lo_day = midnight;
+		} else {
+			hi = mid;
+			hi_day = midnight;
+			have_hi = true;
+		}
+	}
+
+	m_file.seek(lo);
+	return true;
+}
+// }}}
+
+bool	CARDSCAN::next(CARDEVENT &ev) {
+	// {{{
+	if (m_tcb.isopen())
+		return next_tcb(ev);
+
+	while(m_file.gets(m_line, MXLEN)) {
+		m_lineno++;
+
+		if (classify(ev))
+			return true;
+	}
+
+	return false;
+}
+// }}}
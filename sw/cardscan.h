@@ -0,0 +1,129 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename:	sw/cardscan.h
+//
+// Project:	Xtimesheet, a very simple text-based timesheet tracking program
+// {{{
+// Purpose:	Reads a time card from top to bottom, turning each line of
+//		interest into an event: the project name, a rate change, an
+//	invoice marker, or a (fully resolved) interval of work.  Cards may
+//	be plain text, compressed text, or .tcb binary cards.  Intervals from
+//	a binary card are decoded without ever becoming text, so their m_line
+//	is empty.
+//
+//	A line that looks like an interval but stops before it starts is
+//	skipped, and the first few such lines in a card are reported on
+//	stderr, by file and line number.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2017-2024, Gisselquist Technology, LLC
+// {{{
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	GPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/gpl.html
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+#ifndef	CARDSCAN_H
+#define	CARDSCAN_H
+
+#include <string>
+
+#include "timecard.h"
+#include "cardfile.h"
+#include "tcbfile.h"
+
+typedef	enum	{
+	CE_PROJECT,	// Project: line, m_line holds the line
+	CE_RATE,	// Rate: line, m_rate holds the new rate
+	CE_INVOICE,	// An "invoice" or "billed" marker
+	CE_INTERVAL	// A work interval, m_start -- m_stop
+} CARDEVENT_KIND;
+
+typedef	struct	CARDEVENT_S {
+	CARDEVENT_KIND	m_kind;
+	time_t		m_start, m_stop;
+	double		m_rate;
+	unsigned	m_lineno;
+	const char	*m_line;	// Valid only until the next event
+} CARDEVENT;
+
+class	CARDSCAN : public TIMECARD {
+	static const unsigned	MXLEN = 4096;
+	// Bad lines reported per card, before going quiet about the rest
+	static const unsigned	MAXREPORT = 10;
+
+	CARDFILE	m_file;
+	TCBREADER	m_tcb;
+	char		*m_line;
+	unsigned	m_lineno;
+	long		m_day;		// Day number of m_midnight, .tcb only
+	time_t		m_midnight;	// For resolving \tHHMM -- HHMM lines
+	std::string	m_fname;	// For reporting bad lines
+	unsigned	m_nbad;
+	bool		m_quiet;
+
+	bool	classify(CARDEVENT &ev);
+	void	bad(const char *why);
+	bool	next_tcb(CARDEVENT &ev);
+	bool	probe(off_t from, off_t to, off_t &offset, time_t &midnight);
+
+public:
+	CARDSCAN(void);
+	~CARDSCAN(void);
+
+	bool	open(const char *fname);
+	// A plain text card already in memory, as CARDFILE::open() takes it.
+	// Fails on compressed and .tcb cards, which must be opened by name.
+	// The name is only used to report bad lines.
+	bool	open(const char *data, size_t len, const char *name = NULL);
+	void	close(void);
+	bool	isbinary(void) const { return m_tcb.isopen(); }
+	// A plain text card, one that can be appended to as it is
+	bool	isplain(void) const {
+		return !m_tcb.isopen() && m_file.kind() == CARDFILE::CF_PLAIN; }
+
+	// Lines skipped as bad since the card was opened
+	unsigned	nbad(void) const { return m_nbad; }
+	// Skip bad lines without reporting them
+	void	quiet(bool q = true) { m_quiet = q; }
+	// True if the card couldn't be read to its end: it was cut short,
+	// corrupt, or unreadable.  Unlike bad lines, this is always reported.
+	bool	error(void) const {
+		return (m_tcb.isopen()) ? m_tcb.error() : m_file.error(); }
+
+	// Returns false at the end of the file
+	bool	next(CARDEVENT &ev);
+
+	// Right after open(), skips ahead toward the first interval on or
+	// after when.  A plain text card is bisected by byte offset, a .tcb
+	// card is skipped a block at a time, and a compressed card isn't
+	// skipped at all.  Nothing on or after when's day is skipped, but
+	// earlier events (rates and invoices included) may or may not be.
+	// Line numbers are counted from wherever the seek left off.
+	// Returns false, having skipped nothing, if the card was found to
+	// be out of date order.
+	bool	seek(time_t when);
+};
+
+#endif	// CARDSCAN_H
@@ -0,0 +1,266 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename:	sw/cardtail.cpp
+//
+// Project:	Xtimesheet, a very simple text-based timesheet tracking program
+// {{{
+// Purpose:	Reads a plain text time card backwards, last event first.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2017-2024, Gisselquist Technology, LLC
+// {{{
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	GPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/gpl.html
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+__attribute__((unused))
+static const char *cpyright = "(C) 2024 Gisselquist Technology, LLC: " __FILE__;
+
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "cardtail.h"
+
+CARDTAIL::CARDTAIL(void) {
+	// {{{
+	m_fd = -1;
+	m_pos = 0;
+	m_size = BLKLEN + 1;
+	m_buf = new char[m_size];
+	m_len = 0;
+	m_head = m_nrelative = 0;
+	m_offset = 0;
+	m_end = 0;
+}
+// }}}
+
+CARDTAIL::~CARDTAIL(void) {
+	// {{{
+	close();
+	delete[] m_buf;
+}
+// }}}
+
+bool	CARDTAIL::open(const char *fname) {
+	// {{{
+	struct	stat	sb;
+	unsigned char	magic[4];
+	ssize_t		nr;
+
+	close();
+	if (0 > (m_fd = ::open(fname, O_RDONLY)))
+		return false;
+	m_fname.assign(fname);
+
+	// Compressed (gzip or zstd) and .tcb cards can't be read backwards
+	nr = pread(m_fd, magic, sizeof(magic), 0);
+	if (nr < 0 || 0 != fstat(m_fd, &sb)
+		|| (nr >= 2 && magic[0] == 0x1f && magic[1] == 0x8b)
+		|| (nr >= 4 && magic[0] == 0x28 && magic[1] == 0xb5
+				&& magic[2] == 0x2f && magic[3] == 0xfd)
+		|| (nr >= 4 && 0 == memcmp(magic, "TCB1", 4))) {
+		close();
+		return false;
+	}
+
+	m_pos = m_end = sb.st_size;
+	m_len = 0;
+	return true;
+}
+// }}}
+
+void	CARDTAIL::close(void) {
+	// {{{
+	if (m_fd >= 0)
+		::close(m_fd);
+	m_fd = -1;
+	m_pos = 0;
+	m_len = 0;
+	m_queue.clear();
+	m_head = m_nrelative = 0;
+}
+// }}}
+
+char	*CARDTAIL::prevline(off_t &offset) {
+	// {{{
+	// m_buf holds the file from m_pos to m_pos+m_len, everything that
+	// hasn't yet been returned
+	while(m_len > 0 || m_pos > 0) {
+		char		*nl = NULL, *line;
+		unsigned	len;
+
+		// Look for the newline ending the line before the last, not
+		// counting the last line's own newline
+		if (m_len > 1)
+			nl = (char *)memrchr(m_buf, '\n', m_len-1);
+
+		if (nl || m_pos == 0) {
+			line = (nl) ? nl+1 : m_buf;
+			len  = m_len - (line - m_buf);
+			m_len -= len;
+			offset = m_pos + (line - m_buf);
+
+			// The newline stays, as fgets() would leave it.  There's
+			// always room for a terminator, since m_size is kept one
+			// larger than anything we read.
+			line[len] = '\0';
+			return line;
+		}
+
+		// Read the block before this one, in front of what we have
+		unsigned	n = (m_pos < BLKLEN) ? m_pos : BLKLEN;
+		ssize_t		nr;
+
+		if (m_len + n + 1 > m_size) {
+			// A very long line.  Make room for it.
+			char	*buf;
+
+			m_size = 2 * m_size;
+			if (m_size < m_len + n + 1)
+				m_size = m_len + n + 1;
+			buf = new char[m_size];
+			memcpy(buf, m_buf, m_len);
+			delete[] m_buf;
+			m_buf = buf;
+		}
+
+		memmove(&m_buf[n], m_buf, m_len);
+		nr = pread(m_fd, m_buf, n, m_pos - n);
+		if (nr != (ssize_t)n) {
+			// The card shrank beneath us.  Stop here.
+			m_pos = m_len = 0;
+			return NULL;
+		}
+		m_pos -= n;
+		m_len += n;
+	}
+
+	return NULL;
+}
+// }}}
+
+void	CARDTAIL::push(CARDEVENT_KIND kind, off_t offset, const char *line) {
+	// {{{
+	TAILEV	t;
+
+	t.m_ev.m_kind = kind;
+	t.m_ev.m_start = t.m_ev.m_stop = 0;
+	t.m_ev.m_rate = 0.0;
+	t.m_ev.m_lineno = 0;
+	t.m_ev.m_line = NULL;
+	t.m_offset = offset;
+	t.m_relative = false;
+	if (line)
+		t.m_text = line;
+	m_queue.push_back(t);
+}
+// }}}
+
+void	CARDTAIL::resolve(time_t midnight) {
+	// {{{
+	for(unsigned k=m_head; k<m_queue.size() && m_nrelative > 0; k++) {
+		TAILEV	&t = m_queue[k];
+
+		if (t.m_relative) {
+			t.m_ev.m_start += midnight;
+			t.m_ev.m_stop  += midnight;
+			t.m_relative = false;
+			m_nrelative--;
+		}
+	}
+}
+// }}}
+
+bool	CARDTAIL::prev(CARDEVENT &ev) {
+	// {{{
+	while(1) {
+		char	*line;
+		off_t	offset;
+		time_t	lnstart, lnstop;
+
+		// Anything at the front that isn't waiting on a date can go
+		if (m_head < m_queue.size() && !m_queue[m_head].m_relative) {
+			TAILEV	&t = m_queue[m_head++];
+
+			ev = t.m_ev;
+			ev.m_line = t.m_text.c_str();
+			m_offset = t.m_offset;
+			return true;
+		}
+
+		if (m_head >= m_queue.size()) {
+			m_queue.clear();
+			m_head = 0;
+		}
+
+		if (NULL == (line = prevline(offset))) {
+			if (m_head >= m_queue.size())
+				return false;
+
+			// Relative times with no date above them.  CARDSCAN
+			// takes them as relative to time zero, so do we.
+			resolve(0);
+			continue;
+		}
+
+		// The same classification as CARDSCAN::classify()
+		if (strncasecmp(line, "rate:", 5)==0) {
+			push(CE_RATE, offset, line);
+			m_queue.back().m_ev.m_rate = atof(&line[5]);
+		} else if (strncasecmp(line, "project:", 8)==0) {
+			push(CE_PROJECT, offset, line);
+		} else if ((strncasecmp(line, "invoice", 7)==0)
+				||(strncasecmp(line, "billed", 6)==0)) {
+			push(CE_INVOICE, offset, line);
+		} else if (parse(line, lnstart, lnstop)) {
+			bool	relative = (lnstart <= 24*3600);
+
+			// A date: everything held back below it can be placed
+			if (!relative)
+				resolve(get_midnight(lnstart));
+
+			// Date lines, and empty intervals, add nothing
+			if (lnstart == lnstop)
+				continue;
+
+			push(CE_INTERVAL, offset, NULL);
+			m_queue.back().m_ev.m_start = lnstart;
+			m_queue.back().m_ev.m_stop  = lnstop;
+			if (relative) {
+				m_queue.back().m_relative = true;
+				m_nrelative++;
+			}
+		} else if (reversed()) {
+			// As CARDSCAN, but lines can't be numbered from here
+			fprintf(stderr, "WARNING: %s, at byte %lld: Interval "
+				"stops before it starts, skipped\n",
+				m_fname.c_str(), (long long)offset);
+		}
+	}
+}
+// }}}
@@ -0,0 +1,104 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename:	sw/cardtail.h
+//
+// Project:	Xtimesheet, a very simple text-based timesheet tracking program
+// {{{
+// Purpose:	Reads a plain text time card backwards, from its end, in large
+//		blocks.  Queries that only care about the recent past--this
+//	week, or the time since the last invoice--can then stop once they've
+//	gone far enough, at a cost that grows with recent activity rather
+//	than with the age of the card.  Like CARDMERGE, this expects the
+//	card to be in date order, as cards written by xtimesheet are.
+//
+//	A \tHHMM -- HHMM line takes its date from the nearest date line
+//	above it.  Going backwards, that line comes later, so such intervals
+//	(and anything read after them) are held back until it's been found.
+//
+//	Only plain text cards can be read this way.  open() fails on
+//	compressed and .tcb cards, which should be read with a CARDSCAN.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2017-2024, Gisselquist Technology, LLC
+// {{{
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	GPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/gpl.html
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+#ifndef	CARDTAIL_H
+#define	CARDTAIL_H
+
+#include <sys/types.h>
+#include <string>
+#include <vector>
+
+#include "timecard.h"
+#include "cardscan.h"
+
+class	CARDTAIL : public TIMECARD {
+	static const unsigned	BLKLEN = 65536;
+
+	typedef	struct	{
+		CARDEVENT	m_ev;
+		off_t		m_offset;	// Of its line within the file
+		bool		m_relative;	// Still waiting on its date
+		std::string	m_text;		// The line, if not an interval
+	} TAILEV;
+
+	int		m_fd;
+	std::string	m_fname;	// For reporting bad lines
+	off_t		m_pos;		// File offset of m_buf[0]
+	char		*m_buf;
+	unsigned	m_size, m_len;	// Allocated, and yet to be read
+
+	std::vector<TAILEV>	m_queue;	// Front first: latest first
+	unsigned	m_head, m_nrelative;
+	off_t		m_offset, m_end;
+
+	char	*prevline(off_t &offset);
+	void	push(CARDEVENT_KIND kind, off_t offset, const char *line);
+	void	resolve(time_t midnight);
+public:
+	CARDTAIL(void);
+	~CARDTAIL(void);
+
+	// Fails if the card can't be read, or isn't plain text
+	bool	open(const char *fname);
+	void	close(void);
+
+	// Returns the card's events, last first, and false once the top of
+	// the card has been passed.  m_lineno is always zero, since lines
+	// can't be numbered without reading the whole card.  The event
+	// is valid until the next call.
+	bool	prev(CARDEVENT &ev);
+
+	// The file offset of the line of the last event returned
+	off_t	offset(void) const { return m_offset; }
+
+	// The size of the card when it was opened, where reading began
+	off_t	length(void) const { return m_end; }
+};
+
+#endif	// CARDTAIL_H
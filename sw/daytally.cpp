@@ -0,0 +1,193 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename:	sw/daytally.cpp
+//
+// Project:	Xtimesheet, a very simple text-based timesheet tracking program
+// {{{
+// Purpose:	Counts the time logged today across a list of cards.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2017-2024, Gisselquist Technology, LLC
+// {{{
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	GPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/gpl.html
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+__attribute__((unused))
+static const char *cpyright = "(C) 2024 Gisselquist Technology, LLC: " __FILE__;
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+
+#include "cardscan.h"
+#include "cardtail.h"
+#include "daytally.h"
+
+void	DAYTALLY::add(const char *fname) {
+	// {{{
+	char	path[PATH_MAX];
+	DAYCARD	c;
+
+	if (NULL == realpath(fname, path))
+		return;
+	if (m_index.find(path) != m_index.end())
+		return;
+
+	c.m_fname = fname;
+	c.m_read = false;
+	c.m_plain = false;
+	c.m_ino = 0;
+	c.m_size = 0;
+	c.m_lastdate = 0;
+	c.m_secs = 0;
+
+	m_index[path] = m_cards.size();
+	m_cards.push_back(c);
+}
+// }}}
+
+// first -- read back from the end of the card, only as far as today
+void	DAYTALLY::first(DAYCARD &c, const struct stat &sb) {
+	// {{{
+	CARDTAIL	tail;
+	CARDSCAN	card;
+	CARDEVENT	ev;
+	bool		latest = true;
+
+	c.m_read = true;
+	c.m_plain = false;
+	c.m_ino  = sb.st_ino;
+	c.m_size = sb.st_size;
+	c.m_lastdate = 0;
+	c.m_secs = 0;
+
+	if (tail.open(c.m_fname.c_str())) {
+		c.m_plain = true;
+		c.m_size = tail.length();
+		while(tail.prev(ev)) {
+			if (ev.m_kind != CE_INTERVAL)
+				continue;
+			// The last interval on the card dates anything
+			// relative appended after it
+			if (latest)
+				c.m_lastdate = get_midnight(ev.m_start);
+			latest = false;
+			if (ev.m_start < m_today)
+				break;
+			count(c, ev.m_start, ev.m_stop);
+		}
+	} else if (card.open(c.m_fname.c_str())) {
+		// Compressed and .tcb cards can't be read backwards, but
+		// neither are they appended to.  Read them once.
+		while(card.next(ev))
+			if (ev.m_kind == CE_INTERVAL)
+				count(c, ev.m_start, ev.m_stop);
+		card.close();
+	}
+}
+// }}}
+
+// append -- read only what's been added since the card was last read
+void	DAYTALLY::append(DAYCARD &c) {
+	// {{{
+	const	unsigned MXLEN=4096;
+	FILE	*fp;
+	char	*line;
+	time_t	lnstart, lnstop;
+
+	if (NULL == (fp = fopen(c.m_fname.c_str(), "r")))
+		return;
+
+	line = new char[MXLEN];
+	fseeko(fp, c.m_size, SEEK_SET);
+	while(fgets(line, MXLEN, fp)) {
+		unsigned	len = strlen(line);
+
+		// A line still being written will be read next time
+		if (len > 0 && line[len-1] != '\n' && feof(fp))
+			break;
+		c.m_size += len;
+
+		if (!parse(line, lnstart, lnstop))
+			continue;
+		if (lnstart > 24*3600) {
+			c.m_lastdate = get_midnight(lnstart);
+			count(c, lnstart, lnstop);
+		} else if (c.m_lastdate)
+			count(c, c.m_lastdate+lnstart, c.m_lastdate+lnstop);
+	}
+
+	delete[] line;
+	fclose(fp);
+}
+// }}}
+
+void	DAYTALLY::refresh(DAYCARD &c) {
+	// {{{
+	struct	stat	sb;
+
+	if (0 != stat(c.m_fname.c_str(), &sb)) {
+		// Gone, at least for now
+		c.m_read = false;
+		c.m_secs = 0;
+		return;
+	}
+
+	if (!c.m_read || sb.st_ino != c.m_ino || sb.st_size < c.m_size)
+		// New to us, or rewritten rather than appended to
+		first(c, sb);
+	else if (sb.st_size > c.m_size) {
+		if (c.m_plain)
+			append(c);
+		else
+			first(c, sb);
+	}
+}
+// }}}
+
+unsigned long	DAYTALLY::today(void) {
+	// {{{
+	time_t		midnight = get_midnight(time(NULL));
+	unsigned long	secs = 0;
+
+	if (midnight != m_today) {
+		// A new day.  Whatever was read so far was logged before it.
+		m_today = midnight;
+		m_tomorrow = get_midnight(midnight + 26 * 3600);
+		for(unsigned k=0; k<m_cards.size(); k++)
+			m_cards[k].m_secs = 0;
+	}
+
+	for(unsigned k=0; k<m_cards.size(); k++) {
+		refresh(m_cards[k]);
+		secs += m_cards[k].m_secs;
+	}
+
+	return secs;
+}
+// }}}
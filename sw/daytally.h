@@ -0,0 +1,87 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename:	sw/daytally.h
+//
+// Project:	Xtimesheet, a very simple text-based timesheet tracking program
+// {{{
+// Purpose:	Counts the time logged today across a whole list of cards,
+//		whoever logged it.  Each card is first read backwards, only as
+//	far as today's first interval, and from then on only what's appended
+//	to it is read.  A refresh with nothing new costs a stat() per card.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2017-2024, Gisselquist Technology, LLC
+// {{{
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	GPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/gpl.html
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+#ifndef	DAYTALLY_H
+#define	DAYTALLY_H
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include "timecard.h"
+
+class	DAYTALLY : public TIMECARD {
+	typedef	struct	{
+		std::string	m_fname;
+		bool		m_read;		// Has this card been read?
+		bool		m_plain;	// Plain text, appended to
+		ino_t		m_ino;
+		off_t		m_size;		// Bytes read, always whole lines
+		time_t		m_lastdate;	// For \tHHMM -- HHMM lines
+		unsigned long	m_secs;		// Logged today
+	} DAYCARD;
+
+	std::vector<DAYCARD>	m_cards;
+	std::unordered_map<std::string, unsigned>	m_index; // By real path
+	time_t		m_today, m_tomorrow;
+
+	void	count(DAYCARD &c, time_t start, time_t stop) {
+		if (start >= m_today && start < m_tomorrow && start < stop)
+			c.m_secs += stop - start;
+	}
+
+	void	first(DAYCARD &c, const struct stat &sb);
+	void	append(DAYCARD &c);
+	void	refresh(DAYCARD &c);
+public:
+	DAYTALLY(void) { m_today = m_tomorrow = 0; }
+
+	// Adds a card to those counted.  A card already present, under any
+	// name, is only counted once.
+	void	add(const char *fname);
+	unsigned	size(void) const { return m_cards.size(); }
+
+	// Seconds logged today, over every card, reading whatever is new
+	unsigned long	today(void);
+};
+
+#endif	// DAYTALLY_H
@@ -0,0 +1,149 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename:	sw/histpyr.cpp
+//
+// Project:	Xtimesheet, a very simple text-based timesheet tracking program
+// {{{
+// Purpose:	Seconds worked, pre-summed by day, week, month, and year.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2017-2024, Gisselquist Technology, LLC
+// {{{
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	GPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/gpl.html
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+__attribute__((unused))
+static const char *cpyright = "(C) 2024 Gisselquist Technology, LLC: " __FILE__;
+
+#include <limits.h>
+
+#include "tzone.h"
+#include "histpyr.h"
+
+// Division, rounding toward minus infinity
+static	long	floordiv(long a, long b) {
+	return (a >= 0) ? a / b : -((b - 1 - a) / b);
+}
+
+void	HISTPYRAMID::clear(void) {
+	// {{{
+	for(int lvl=0; lvl<HL_NLEVELS; lvl++) {
+		m_secs[lvl].clear();
+		m_first[lvl] = 0;
+	}
+
+	m_lo = LONG_MAX;
+	m_hi = LONG_MIN;
+}
+// }}}
+
+long	HISTPYRAMID::period(HISTLEVEL lvl, long day) {
+	// {{{
+	long		year;
+	unsigned	mon, mday;
+
+	switch(lvl) {
+	case HL_DAY:	return day;
+	// Day -3, 1969/12/29, was a Monday
+	case HL_WEEK:	return floordiv(day + 3, 7);
+	default:
+		TZONE::civil_from_days(day, year, mon, mday);
+		return (lvl == HL_MONTH) ? year * 12 + mon - 1 : year;
+	}
+}
+// }}}
+
+long	HISTPYRAMID::begins(HISTLEVEL lvl, long period) {
+	// {{{
+	switch(lvl) {
+	case HL_DAY:	return period;
+	case HL_WEEK:	return period * 7 - 3;
+	case HL_MONTH:	return TZONE::days_from_civil(floordiv(period, 12),
+				period - floordiv(period, 12) * 12 + 1, 1);
+	default:	return TZONE::days_from_civil(period, 1, 1);
+	}
+}
+// }}}
+
+void	HISTPYRAMID::grow(HISTLEVEL lvl, long period) {
+	// {{{
+	std::vector<unsigned long>	&v = m_secs[lvl];
+
+	if (v.empty()) {
+		m_first[lvl] = period;
+		v.push_back(0);
+	} else if (period < m_first[lvl]) {
+		// Cards are added one after another, each starting well
+		// before the last one ended.  Grow the front by at least the
+		// present size, so that's not quadratic.
+		unsigned long	n = m_first[lvl] - period;
+
+		if (n < v.size())
+			n = v.size();
+		v.insert(v.begin(), n, 0);
+		m_first[lvl] -= n;
+	} else if ((unsigned long)(period - m_first[lvl]) >= v.size())
+		v.resize(period - m_first[lvl] + 1, 0);
+}
+// }}}
+
+void	HISTPYRAMID::add_day(long day, unsigned long secs) {
+	// {{{
+	if (secs == 0)
+		return;
+
+	for(int lvl=0; lvl<HL_NLEVELS; lvl++) {
+		long	p = period((HISTLEVEL)lvl, day);
+
+		grow((HISTLEVEL)lvl, p);
+		m_secs[lvl][p - m_first[lvl]] += secs;
+	}
+
+	if (day < m_lo)
+		m_lo = day;
+	if (day > m_hi)
+		m_hi = day;
+}
+// }}}
+
+void	HISTPYRAMID::add(time_t start, time_t stop) {
+	// {{{
+	const TZONE	&tz = TZONE::local();
+
+	while(start < stop) {
+		struct	tm	tv;
+		time_t		tomorrow, upto;
+
+		tz.localtime(start, tv);
+		tomorrow = tz.civil(tv.tm_year+1900, tv.tm_mon+1, tv.tm_mday+1);
+		upto = (stop < tomorrow) ? stop : tomorrow;
+
+		add_day(TZONE::days_from_civil(tv.tm_year+1900, tv.tm_mon+1,
+				tv.tm_mday), upto - start);
+		start = upto;
+	}
+}
+// }}}
@@ -0,0 +1,97 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename:	sw/histpyr.h
+//
+// Project:	Xtimesheet, a very simple text-based timesheet tracking program
+// {{{
+// Purpose:	Seconds worked, pre-summed by day, week, month, and year.
+//		Each level is a dense array indexed by its period number, so
+//	the total for any period is a single lookup, and a chart of any span,
+//	at any level, costs no more than the number of bars it draws.  New
+//	intervals update one entry on each level.
+//
+//	Weeks begin on Monday, as they do for byweek.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2017-2024, Gisselquist Technology, LLC
+// {{{
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	GPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/gpl.html
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+#ifndef	HISTPYR_H
+#define	HISTPYR_H
+
+#include <time.h>
+#include <vector>
+
+typedef	enum	{
+	HL_DAY = 0, HL_WEEK, HL_MONTH, HL_YEAR, HL_NLEVELS
+} HISTLEVEL;
+
+class	HISTPYRAMID {
+	std::vector<unsigned long>	m_secs[HL_NLEVELS];
+	long		m_first[HL_NLEVELS];	// Period of m_secs[lvl][0]
+	long		m_lo, m_hi;		// Days with any time logged
+
+	void	grow(HISTLEVEL lvl, long period);
+public:
+	HISTPYRAMID(void) { clear(); }
+
+	void	clear(void);
+	bool	empty(void) const { return m_lo > m_hi; }
+
+	// Adds an interval, split at (local) midnight as need be
+	void	add(time_t start, time_t stop);
+	// Adds seconds to a day, counted from 1970/01/01
+	void	add_day(long day, unsigned long secs);
+
+	// Seconds worked within a period, zero outside of what's known
+	unsigned long	secs(HISTLEVEL lvl, long period) const {
+		unsigned long	k = period - m_first[lvl];
+
+		return (k < m_secs[lvl].size()) ? m_secs[lvl][k] : 0;
+	}
+
+	// Roughly, the memory held
+	size_t	bytes(void) const {
+		size_t	n = 0;
+
+		for(int lvl=0; lvl<HL_NLEVELS; lvl++)
+			n += m_secs[lvl].capacity() * sizeof(unsigned long);
+		return n;
+	}
+
+	// The first and last days with any time logged
+	long	first_day(void) const { return m_lo; }
+	long	last_day(void) const { return m_hi; }
+
+	// Period numbers: the period containing a day, and the first day of
+	// a period
+	static	long	period(HISTLEVEL lvl, long day);
+	static	long	begins(HISTLEVEL lvl, long period);
+};
+
+#endif	// HISTPYR_H
@@ -0,0 +1,207 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename:	sw/outbuf.cpp
+//
+// Project:	Xtimesheet, a very simple text-based timesheet tracking program
+// {{{
+// Purpose:	A large output buffer, with printf()-free number formatting.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2017-2024, Gisselquist Technology, LLC
+// {{{
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	GPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/gpl.html
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+__attribute__((unused))
+static const char *cpyright = "(C) 2024 Gisselquist Technology, LLC: " __FILE__;
+
+#include <errno.h>
+
+#include "outbuf.h"
+
+// Two digits at a time, 00 through 99
+const char	OUTBUF::m_digits[201] =
+	"00010203040506070809"
+	"10111213141516171819"
+	"20212223242526272829"
+	"30313233343536373839"
+	"40414243444546474849"
+	"50515253545556575859"
+	"60616263646566676869"
+	"70717273747576777879"
+	"80818283848586878889"
+	"90919293949596979899";
+
+OUTBUF::OUTBUF(int fd) {
+	// {{{
+	m_fd  = fd;
+	m_buf = new char[BUFLEN];
+	m_len = 0;
+	m_err = false;
+}
+// }}}
+
+OUTBUF::~OUTBUF(void) {
+	// {{{
+	flush();
+	delete[] m_buf;
+}
+// }}}
+
+void	OUTBUF::flush(void) {
+	// {{{
+	unsigned	pos = 0;
+
+	while(pos < m_len && !m_err) {
+		ssize_t	nw = write(m_fd, &m_buf[pos], m_len - pos);
+
+		if (nw < 0 && errno == EINTR)
+			continue;
+		if (nw <= 0)
+			m_err = true;
+		else
+			pos += nw;
+	}
+
+	m_len = 0;
+}
+// }}}
+
+void	OUTBUF::put(const char *str, unsigned len) {
+	// {{{
+	while(len > 0) {
+		unsigned	n;
+
+		if (m_len >= BUFLEN)
+			flush();
+
+		n = BUFLEN - m_len;
+		if (n > len)
+			n = len;
+		memcpy(&m_buf[m_len], str, n);
+		m_len += n;
+		str   += n;
+		len   -= n;
+	}
+}
+// }}}
+
+void	OUTBUF::put_uint(uint64_t v) {
+	// {{{
+	char	tmp[20], *ptr = &tmp[20];
+
+	while(v >= 100) {
+		unsigned	k = (unsigned)(v % 100) * 2;
+
+		v /= 100;
+		*--ptr = m_digits[k+1];
+		*--ptr = m_digits[k];
+	}
+
+	if (v >= 10) {
+		*--ptr = m_digits[v*2+1];
+		*--ptr = m_digits[v*2];
+	} else
+		*--ptr = (char)('0' + v);
+
+	put(ptr, &tmp[20] - ptr);
+}
+// }}}
+
+void	OUTBUF::put_fixed(uint64_t v, unsigned ndigits) {
+	// {{{
+	char	tmp[20];
+
+	put(tmp, fixed(tmp, v, ndigits) - tmp);
+}
+// }}}
+
+void	OUTBUF::put_right(const char *str, unsigned width) {
+	// {{{
+	unsigned	len = strlen(str);
+
+	for(; len < width; width--)
+		put(' ');
+	put(str, len);
+}
+// }}}
+
+char	*OUTBUF::fixed(char *buf, uint64_t v, unsigned ndigits) {
+	// {{{
+	if (ndigits > 20)
+		ndigits = 20;
+	for(unsigned k=ndigits; k>0; k--) {
+		buf[k-1] = (char)('0' + (v % 10));
+		v /= 10;
+	}
+
+	return buf + ndigits;
+}
+// }}}
+
+char	*OUTBUF::decimal(char *buf, int64_t v, unsigned nfrac,
+		unsigned width) {
+	// {{{
+	char		tmp[24], *ptr = &tmp[24];
+	uint64_t	mag = (v < 0) ? -(uint64_t)v : (uint64_t)v;
+	unsigned	len;
+
+	// Build the number backwards: fraction, point, integer, sign
+	for(unsigned k=0; k<nfrac; k++) {
+		*--ptr = (char)('0' + (mag % 10));
+		mag /= 10;
+	}
+
+	if (nfrac > 0)
+		*--ptr = '.';
+	do {
+		*--ptr = (char)('0' + (mag % 10));
+		mag /= 10;
+	} while(mag > 0);
+
+	if (v < 0)
+		*--ptr = '-';
+
+	len = &tmp[24] - ptr;
+	if (width > 24)
+		width = 24;
+	for(; len < width; width--)
+		*buf++ = ' ';
+	memcpy(buf, ptr, len);
+	return buf + len;
+}
+// }}}
+
+char	*OUTBUF::right(char *buf, const char *str, unsigned width) {
+	// {{{
+	unsigned	len = strlen(str);
+
+	for(; len < width; width--)
+		*buf++ = ' ';
+	memcpy(buf, str, len);
+	return buf + len;
+}
+// }}}
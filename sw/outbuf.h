@@ -0,0 +1,109 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename:	sw/outbuf.h
+//
+// Project:	Xtimesheet, a very simple text-based timesheet tracking program
+// {{{
+// Purpose:	A large output buffer, written straight to a file descriptor,
+//		with number formatting that doesn't go through printf().  For
+//	tools that write a line (or more) for every interval in a card.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2017-2024, Gisselquist Technology, LLC
+// {{{
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	GPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/gpl.html
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+#ifndef	OUTBUF_H
+#define	OUTBUF_H
+
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+class	OUTBUF {
+	static const unsigned	BUFLEN = 256*1024;
+
+	int		m_fd;
+	char		*m_buf;
+	unsigned	m_len;
+	bool		m_err;
+
+	static const char	m_digits[201];
+public:
+	OUTBUF(int fd = STDOUT_FILENO);
+	~OUTBUF(void);
+
+	// Writes everything buffered so far
+	void	flush(void);
+	// True if any write has failed
+	bool	error(void) const { return m_err; }
+
+	void	put(char ch) {
+		if (m_len >= BUFLEN)
+			flush();
+		m_buf[m_len++] = ch;
+	}
+
+	void	put(const char *str, unsigned len);
+	void	put(const char *str) { put(str, strlen(str)); }
+
+	// Unsigned and signed decimal
+	void	put_uint(uint64_t v);
+	void	put_int(int64_t v) {
+		if (v < 0) {
+			put('-');
+			put_uint(-(uint64_t)v);
+		} else
+			put_uint(v);
+	}
+
+	// Exactly ndigits (at most 20) decimal digits, zero padded on the
+	// left, as printf's %0*u would write for values that fit
+	void	put_fixed(uint64_t v, unsigned ndigits);
+
+	// Fixed point numbers, given in tenths or hundredths, written as
+	// printf's %*.1f or %*.2f would write v/10.0 or v/100.0
+	void	put_tenths(int64_t v, unsigned width = 0) {
+		char	buf[48];
+		put(buf, decimal(buf, v, 1, width) - buf); }
+	void	put_cents(int64_t v, unsigned width = 0) {
+		char	buf[48];
+		put(buf, decimal(buf, v, 2, width) - buf); }
+
+	// A string right justified within width characters, as %*s
+	void	put_right(const char *str, unsigned width);
+
+	// The formatters behind the above, for building text in memory.
+	// Each returns a pointer to just past the last character written.
+	// At most 20 digits and a width of 24 are supported.
+	static	char	*fixed(char *buf, uint64_t v, unsigned ndigits);
+	static	char	*decimal(char *buf, int64_t v, unsigned nfrac,
+				unsigned width);
+	static	char	*right(char *buf, const char *str, unsigned width);
+};
+
+#endif	// OUTBUF_H
@@ -0,0 +1,687 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename:	sw/report.cpp
+//
+// Project:	Xtimesheet, a very simple text-based timesheet tracking program
+// {{{
+// Purpose:	The reports tc can make, each fed one card at a time, and
+//		each printing itself once every card has been read.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2017-2024, Gisselquist Technology, LLC
+// {{{
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	GPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/gpl.html
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+__attribute__((unused))
+static const char *cpyright = "(C) 2024 Gisselquist Technology, LLC: " __FILE__;
+
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+
+#include <algorithm>
+
+#include "report.h"
+
+static const char	*daystr[] = {
+	"Sunday",
+	"Monday",
+	"Tuesday",
+	"Wednesday",
+	"Thursday",
+	"Friday",
+	"Saturday"
+};
+
+// "%.1f Hours", followed by suffix
+static	void	hours(OUTBUF &out, unsigned long units, const char *suffix) {
+	// {{{
+	char	buf[64];
+
+	snprintf(buf, sizeof(buf), "%.1f Hours%s\n",
+		(double)BILLING::ROUNDING::tenths(units)/10.0, suffix);
+	out.put(buf);
+}
+// }}}
+
+// "<what>: YYYY/MM/DD", of the day beginning at when
+static	void	dateline(std::string &str, const char *what, time_t when) {
+	// {{{
+	struct	tm	datev;
+	char		buf[64];
+
+	TZONE::local().localtime(when, datev);
+	snprintf(buf, sizeof(buf), "%s: %04d/%02d/%02d\n", what,
+		datev.tm_year+1900, datev.tm_mon+1, datev.tm_mday);
+	str += buf;
+}
+// }}}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// WEEKREPORT
+// {{{
+////////////////////////////////////////////////////////////////////////////////
+//
+//
+
+WEEKREPORT::WEEKREPORT(time_t when) {
+	// {{{
+	m_backward = false;
+	m_units = 0;
+	this->when(when);
+}
+// }}}
+
+void	WEEKREPORT::when(time_t when) {
+	// {{{
+	const TZONE	&tz = TZONE::local();
+	struct	tm	datev;
+
+	// Count back to the beginning of the week in days, not seconds, so
+	// a daylight savings change can't shift it
+	tz.localtime(when, datev);
+	m_begin = tz.civil(datev.tm_year+1900, datev.tm_mon+1,
+			datev.tm_mday - datev.tm_wday);
+	m_end   = tz.civil(datev.tm_year+1900, datev.tm_mon+1,
+			datev.tm_mday - datev.tm_wday + 7);
+}
+// }}}
+
+void	WEEKREPORT::heading(void) {
+	// {{{
+	dateline(m_head, "Week begins", m_begin);
+}
+// }}}
+
+void	WEEKREPORT::begin(unsigned card, const char *fname, bool backward) {
+	// {{{
+	m_backward = backward;
+	m_acc.clear();
+}
+// }}}
+
+bool	WEEKREPORT::event(const CARDEVENT &ev, time_t midnight) {
+	// {{{
+	if (ev.m_kind != CE_INTERVAL)
+		return true;
+
+	if (m_backward) {
+		if (ev.m_start < m_begin)
+			return false;
+		if (ev.m_stop < m_end)
+			m_acc.add(midnight, ev.m_stop - ev.m_start);
+		return true;
+	}
+
+	if (ev.m_start >= m_end)
+		return false;
+	if ((ev.m_start >= m_begin)&&(ev.m_stop < m_end))
+		m_acc.add(midnight, ev.m_stop - ev.m_start);
+	return true;
+}
+// }}}
+
+void	WEEKREPORT::end(void) {
+	// {{{
+	m_units += m_acc.units();
+}
+// }}}
+
+void	WEEKREPORT::print(OUTBUF &out) {
+	// {{{
+	out.put(m_head.data(), m_head.size());
+	hours(out, m_units, "");
+}
+// }}}
+
+// }}}
+////////////////////////////////////////////////////////////////////////////////
+//
+// MONTHREPORT
+// {{{
+////////////////////////////////////////////////////////////////////////////////
+//
+//
+
+MONTHREPORT::MONTHREPORT(time_t when) {
+	// {{{
+	m_units = 0;
+	this->when(when);
+}
+// }}}
+
+void	MONTHREPORT::when(time_t when) {
+	// {{{
+	const TZONE	&tz = TZONE::local();
+	struct	tm	datev;
+
+	tz.localtime(when, datev);
+	m_begin = tz.civil(datev.tm_year+1900, datev.tm_mon+1, 1);
+	m_end   = tz.civil(datev.tm_year+1900, datev.tm_mon+2, 1);
+}
+// }}}
+
+void	MONTHREPORT::heading(void) {
+	// {{{
+	dateline(m_head, "Month begins", m_begin);
+	dateline(m_head, "Month ends", m_end);
+}
+// }}}
+
+void	MONTHREPORT::begin(unsigned card, const char *fname, bool backward) {
+	// {{{
+	m_acc.clear();
+}
+// }}}
+
+bool	MONTHREPORT::event(const CARDEVENT &ev, time_t midnight) {
+	// {{{
+	if (ev.m_kind != CE_INTERVAL)
+		return true;
+
+	if (ev.m_start >= m_end)
+		return false;
+	if ((ev.m_start > m_begin)&&(ev.m_stop < m_end))
+		m_acc.add(midnight, ev.m_stop - ev.m_start);
+	return true;
+}
+// }}}
+
+void	MONTHREPORT::end(void) {
+	// {{{
+	m_units += m_acc.units();
+}
+// }}}
+
+void	MONTHREPORT::print(OUTBUF &out) {
+	// {{{
+	out.put(m_head.data(), m_head.size());
+	hours(out, m_units, "");
+}
+// }}}
+
+// }}}
+////////////////////////////////////////////////////////////////////////////////
+//
+// TOTALREPORT
+// {{{
+////////////////////////////////////////////////////////////////////////////////
+//
+//
+
+TOTALREPORT::TOTALREPORT(bool since_only) {
+	// {{{
+	m_since = since_only;
+	m_backward = false;
+	m_cardinv = 0;
+	m_invoiced = m_pending = 0;
+}
+// }}}
+
+void	TOTALREPORT::begin(unsigned card, const char *fname, bool backward) {
+	// {{{
+	m_backward = backward;
+	m_acc.clear();
+	m_cardinv = 0;
+}
+// }}}
+
+bool	TOTALREPORT::event(const CARDEVENT &ev, time_t midnight) {
+	// {{{
+	if (ev.m_kind == CE_INVOICE) {
+		// Read backwards, the last invoice is as far as we go
+		if (m_backward)
+			return false;
+		m_cardinv += m_acc.units();
+		m_acc.clear();
+	} else if (ev.m_kind == CE_INTERVAL)
+		m_acc.add(midnight, ev.m_stop - ev.m_start);
+
+	return true;
+}
+// }}}
+
+void	TOTALREPORT::end(void) {
+	// {{{
+	if (!m_since)
+		m_invoiced += m_cardinv;
+	m_pending += m_acc.units();
+}
+// }}}
+
+void	TOTALREPORT::print(OUTBUF &out) {
+	// {{{
+	unsigned long	invoiced = m_invoiced, pending = m_pending;
+
+	out.put(m_head.data(), m_head.size());
+	if (m_since) {
+		hours(out, pending, " (since last invoice)");
+		return;
+	}
+
+	if (invoiced == 0) {
+		invoiced = pending; pending = 0;
+	}
+
+	hours(out, invoiced + pending, "");
+	if (pending != 0)
+		hours(out, pending, " (since last invoice)");
+}
+// }}}
+
+// }}}
+////////////////////////////////////////////////////////////////////////////////
+//
+// ROLLREPORT
+// {{{
+////////////////////////////////////////////////////////////////////////////////
+//
+//
+
+char	*ROLLREPORT::label(CALLEVEL lvl, time_t begin, bool latex, char *buf) {
+	// {{{
+	struct	tm	datev;
+	char		*ptr = buf;
+
+	TIMECARD::localtime(begin, datev);
+
+	switch(lvl) {
+	case CB_DAY:
+		// Plain:	"%9s %04d/%02d/%02d", day, y, m, d
+		// LaTeX:	"%04d/%02d/%02d, %s", y, m, d, day
+		if (!latex) {
+			ptr = OUTBUF::right(ptr, daystr[datev.tm_wday], 9);
+			*ptr++ = ' ';
+		}
+		ptr = OUTBUF::fixed(ptr, datev.tm_year+1900, 4);
+		*ptr++ = '/';
+		ptr = OUTBUF::fixed(ptr, datev.tm_mon+1, 2);
+		*ptr++ = '/';
+		ptr = OUTBUF::fixed(ptr, datev.tm_mday, 2);
+		if (latex) {
+			*ptr++ = ',';
+			*ptr++ = ' ';
+			ptr = OUTBUF::right(ptr, daystr[datev.tm_wday], 0);
+		}
+		break;
+	case CB_WEEK: {
+		// "%04ld-W%02ld %04d/%02d/%02d"
+		// The ISO year and week number are those of the Thursday
+		long		thursday, iso_year;
+		unsigned	mon, mday;
+
+		thursday = TZONE::days_from_civil(datev.tm_year+1900,
+					datev.tm_mon+1, datev.tm_mday) + 3;
+		TZONE::civil_from_days(thursday, iso_year, mon, mday);
+		ptr = OUTBUF::fixed(ptr, iso_year, 4);
+		*ptr++ = '-';
+		*ptr++ = 'W';
+		ptr = OUTBUF::fixed(ptr,
+			(thursday - TZONE::days_from_civil(iso_year,1,1))/7+1,
+			2);
+		*ptr++ = ' ';
+		ptr = OUTBUF::fixed(ptr, datev.tm_year+1900, 4);
+		*ptr++ = '/';
+		ptr = OUTBUF::fixed(ptr, datev.tm_mon+1, 2);
+		*ptr++ = '/';
+		ptr = OUTBUF::fixed(ptr, datev.tm_mday, 2);
+		} break;
+	case CB_MONTH:
+		// "%04d/%02d"
+		ptr = OUTBUF::fixed(ptr, datev.tm_year+1900, 4);
+		*ptr++ = '/';
+		ptr = OUTBUF::fixed(ptr, datev.tm_mon+1, 2);
+		break;
+	case CB_QUARTER:
+		// "%04d-Q%d"
+		ptr = OUTBUF::fixed(ptr, datev.tm_year+1900, 4);
+		*ptr++ = '-';
+		*ptr++ = 'Q';
+		*ptr++ = (char)('1' + datev.tm_mon/3);
+		break;
+	default:
+		// "%04d"
+		ptr = OUTBUF::fixed(ptr, datev.tm_year+1900, 4);
+		break;
+	}
+
+	*ptr = '\0';
+	return ptr;
+}
+// }}}
+
+ROLLREPORT::~ROLLREPORT(void) {
+	// {{{
+	for(unsigned k=0; k<m_cal.size(); k++)
+		if (m_cal[k])
+			delete m_cal[k];
+}
+// }}}
+
+void	ROLLREPORT::start(unsigned ncards) {
+	// {{{
+	m_cross = (ncards > 1 && !m_separate && !m_latex);
+	if (m_cross) {
+		m_open.assign(ncards, false);
+		m_name.resize(ncards);
+		m_days.clear();
+	} else
+		m_cal.assign(ncards, NULL);
+}
+// }}}
+
+void	ROLLREPORT::begin(unsigned card, const char *fname, bool backward) {
+	// {{{
+	m_card = card;
+
+	if (!m_cross) {
+		if (m_cal[card])
+			delete m_cal[card];
+		m_cal[card] = new CALBUCKETS;
+		m_cal[card]->rate(225.0);
+		return;
+	}
+
+	// Until its Project: line turns up, a card is known by its file
+	// name, sans extension
+	const char	*base, *ext;
+
+	base = strrchr(fname, '/');
+	base = (base) ? base+1 : fname;
+	ext  = strchr(base, '.');
+	m_name[card].assign(base, (ext) ? (size_t)(ext-base) : strlen(base));
+	m_open[card] = true;
+	// A card read over again is always the last one begun
+	while(!m_days.empty() && m_days.back().m_card == card)
+		m_days.pop_back();
+}
+// }}}
+
+bool	ROLLREPORT::event(const CARDEVENT &ev, time_t midnight) {
+	// {{{
+	if (!m_cross) {
+		CALBUCKETS	&cal = *m_cal[m_card];
+
+		switch(ev.m_kind) {
+		case CE_RATE:	cal.rate(ev.m_rate); break;
+		case CE_INVOICE: cal.invoice(); break;
+		case CE_INTERVAL: cal.add(ev.m_start, ev.m_stop); break;
+		default:	break;
+		}
+
+		return true;
+	}
+
+	if (ev.m_kind == CE_PROJECT) {
+		const char	*name = &ev.m_line[8];
+		unsigned	len;
+
+		while(*name && isspace(*name))
+			name++;
+		len = strlen(name);
+		while(len > 0 && isspace(name[len-1]))
+			len--;
+		if (len > 0)
+			m_name[m_card].assign(name, len);
+	} else if (ev.m_kind == CE_INTERVAL) {
+		if (!m_days.empty() && m_days.back().m_day == midnight
+				&& m_days.back().m_card == m_card)
+			m_days.back().m_secs += ev.m_stop - ev.m_start;
+		else {
+			DAYSECS	d;
+
+			d.m_day  = midnight;
+			d.m_card = m_card;
+			d.m_secs = ev.m_stop - ev.m_start;
+			m_days.push_back(d);
+		}
+	}
+
+	return true;
+}
+// }}}
+
+void	ROLLREPORT::end(void) {
+	// {{{
+	// Don't merge the first period of the next card with our last
+	if (!m_cross)
+		m_cal[m_card]->close();
+}
+// }}}
+
+void	ROLLREPORT::fee(OUTBUF &out, CALLEVEL lvl, const CALBUCKET &b,
+		unsigned nunits) {
+	// {{{
+	char		buf[64];
+	int64_t		rate = CENTS::from(b.m_rate);
+
+	out.put("\\Fee{", 5);
+	out.put(buf, label(lvl, b.m_begin, true, buf) - buf);
+	// "}{%.2f}{%.1f}{%.2f}", rate, hours, rate * hours, all kept
+	// in (integer) cents and tenths of an hour
+	out.put("}{", 2);
+	out.put_cents(rate);
+	out.put("}{", 2);
+	out.put_tenths(BILLING::ROUNDING::tenths(nunits));
+	out.put("}{", 2);
+	out.put_cents(CENTS::fee<BILLING::ROUNDING>(rate, nunits));
+	out.put("}\n", 2);
+}
+// }}}
+
+void	ROLLREPORT::row(OUTBUF &out, CALLEVEL lvl, const CALBUCKET &b,
+		unsigned nunits) const {
+	// {{{
+	char		buf[64];
+
+	if (m_latex) {
+		fee(out, lvl, b, nunits);
+		return;
+	}
+
+	// ": %4.1f"
+	out.put(buf, label(lvl, b.m_begin, false, buf) - buf);
+	out.put(": ", 2);
+	out.put_tenths(BILLING::ROUNDING::tenths(nunits), 4);
+	out.put('\n');
+}
+// }}}
+
+// current holds the start of each period now is in
+void	ROLLREPORT::separate(OUTBUF &out, CALLEVEL lvl,
+			const time_t *current) const {
+	// {{{
+	unsigned	total = 0;
+
+	// Card after card, each with its own invoices
+	for(unsigned c=0; c<m_cal.size(); c++) {
+		unsigned	sumunits = 0, last_invoiced = 0;
+		time_t		latest = 0;	// The last period worked
+
+		if (NULL == m_cal[c])
+			continue;
+
+		const CALBUCKETS	&cal = *m_cal[c];
+
+		for(unsigned k=0; k<cal.size(lvl); k++) {
+			const CALBUCKET	&b = cal.bucket(lvl, k);
+			unsigned	nunits = b.m_units;
+
+			if (nunits > 0) {
+				row(out, lvl, b, nunits);
+				sumunits += nunits;
+				latest = b.m_begin;
+			}
+
+			if (b.m_invoice) {
+				if (lvl == CB_DAY || sumunits == last_invoiced)
+					out.put("INVOICE\n");
+				else {
+					out.put("INVOICE -- ");
+					out.put_tenths(BILLING::ROUNDING::tenths(
+						sumunits - last_invoiced));
+					out.put('\n');
+				}
+				last_invoiced = sumunits;
+			}
+		}
+
+		// Only a card still being worked on, this period, has time
+		// waiting on an invoice
+		if (lvl != CB_DAY && sumunits > last_invoiced
+				&& latest == current[lvl]) {
+			out.put("NOT-YET INVOICED -- ");
+			out.put_tenths(BILLING::ROUNDING::tenths(
+						sumunits - last_invoiced));
+			out.put('\n');
+		}
+
+		total += sumunits;
+	}
+
+	if (!m_latex) {
+		out.put("Total: ");
+		out.put_tenths(BILLING::ROUNDING::tenths(total));
+		out.put(" Hours\n");
+	}
+}
+// }}}
+
+void	ROLLREPORT::cross(OUTBUF &out, CALLEVEL lvl,
+		const std::vector<DAYSECS> &days,
+		const std::vector<unsigned> &column,
+		const std::vector<unsigned> &width) {
+	// {{{
+	std::vector<BILLING>	bill(m_open.size());
+	BILLING		total;
+	time_t		begin[CB_NLEVELS], period = 0;
+	unsigned	sumunits = 0;
+	char		buf[64];
+
+	// Writes out the row of the period just finished, if anything was
+	// worked within it, and starts over
+	auto	flush = [&](void) {
+		unsigned	nunits = total.units();
+		char		*ptr;
+
+		if (nunits > 0) {
+			// "%s: %5.1f", label, hours, then " %*.1f" for each
+			// project
+			ptr = label(lvl, period, false, buf);
+			*ptr++ = ':';
+			*ptr++ = ' ';
+			ptr = OUTBUF::decimal(ptr,
+				BILLING::ROUNDING::tenths(nunits), 1, 5);
+			out.put(buf, ptr - buf);
+			for(unsigned k=0; k<column.size(); k++) {
+				buf[0] = ' ';
+				ptr = OUTBUF::decimal(buf+1,
+					BILLING::ROUNDING::tenths(
+						bill[column[k]].units()),
+					1, width[k]);
+				out.put(buf, ptr - buf);
+			} out.put('\n');
+			sumunits += nunits;
+		}
+
+		total.clear();
+		for(unsigned k=0; k<column.size(); k++)
+			bill[column[k]].clear();
+	};
+
+	// A heading, naming each column
+	out.put_right("", label(lvl, 0, false, buf) - buf);
+	out.put("  Total");
+	for(unsigned k=0; k<column.size(); k++) {
+		std::string	name(m_name[column[k]], 0, width[k]);
+
+		out.put(' ');
+		out.put_right(name.c_str(), width[k]);
+	} out.put('\n');
+
+	for(unsigned d=0; d<days.size(); d++) {
+		m_bounds.begins(days[d].m_day, begin);
+		if (begin[lvl] != period) {
+			flush();
+			period = begin[lvl];
+		}
+
+		total.add(days[d].m_day, days[d].m_secs);
+		bill[days[d].m_card].add(days[d].m_day, days[d].m_secs);
+	} flush();
+
+	out.put("Total: ");
+	out.put_tenths(BILLING::ROUNDING::tenths(sumunits));
+	out.put(" Hours\n");
+}
+// }}}
+
+void	ROLLREPORT::print(OUTBUF &out) {
+	// {{{
+	unsigned	levels = m_levels;
+	std::vector<unsigned>	column, width;
+	time_t		current[CB_NLEVELS];
+
+	out.put(m_head.data(), m_head.size());
+
+	if (m_cross) {
+		// Every card's days, in day order, as though the cards had
+		// all been read together
+		std::sort(m_days.begin(), m_days.end(), byday);
+
+		// A column for every card that could be read
+		for(unsigned c=0; c<m_open.size(); c++) {
+			unsigned	w;
+
+			if (!m_open[c])
+				continue;
+			w = m_name[c].size();
+			w = (w < MINWIDTH) ? MINWIDTH : w;
+			w = (w > MAXWIDTH) ? MAXWIDTH : w;
+			column.push_back(c);
+			width.push_back(w);
+		}
+	} else
+		m_bounds.begins(time(NULL), current);
+
+	for(int lvl=0; lvl<CB_NLEVELS; lvl++) {
+		if (0 == (levels & (1<<lvl)))
+			continue;
+
+		if (m_cross)
+			cross(out, (CALLEVEL)lvl, m_days, column, width);
+		else
+			separate(out, (CALLEVEL)lvl, current);
+		levels &= ~(1<<lvl);
+		if (levels && !m_latex)
+			out.put('\n');
+	}
+}
+// }}}
+
+// }}}
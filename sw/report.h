@@ -0,0 +1,227 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename:	sw/report.h
+//
+// Project:	Xtimesheet, a very simple text-based timesheet tracking program
+// {{{
+// Purpose:	The reports tc can make: the hours in a week or a month, the
+//		hours ever and since the last invoice, and the daily through
+//	yearly rollups.  Each is an accumulator.  tc reads every card just
+//	once, hands each of its events to every report asked for, and then
+//	has each report print itself.
+//
+//	A report says how little of a card it can be made from.  If every
+//	report asked for only needs the end of a card, the card is read
+//	backwards, and only until they're all done.  If every one has a date
+//	before which it counts nothing, the card is read from that date.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2017-2024, Gisselquist Technology, LLC
+// {{{
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	GPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/gpl.html
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+#ifndef	REPORT_H
+#define	REPORT_H
+
+#include <limits.h>
+#include <stdint.h>
+#include <time.h>
+
+#include <string>
+#include <vector>
+
+#include "cardscan.h"
+#include "calbucket.h"
+#include "outbuf.h"
+#include "billing.h"
+
+class	REPORT {
+protected:
+	std::string	m_head;		// Printed ahead of the report
+public:
+	virtual	~REPORT(void) {}
+
+	// Anything to print ahead of the report itself
+	void	head(const char *str) { m_head += str; }
+
+	// The earliest interval the report counts.  LONG_MIN if it needs
+	// every event of every card.
+	virtual	time_t	from(void) const { return LONG_MIN; }
+
+	// Can the report be made from the end of each card, read backwards?
+	virtual	bool	backward(void) const { return false; }
+
+	// Called once, before any card is read, with the number of cards
+	virtual	void	start(unsigned ncards) {}
+
+	// A card's events are about to follow.  If a card turns out to be
+	// out of order, and has to be read over, this is called again for
+	// the same card, and everything since the last call is forgotten.
+	virtual	void	begin(unsigned card, const char *fname,
+				bool backward) = 0;
+
+	// One event of the card.  midnight is that of an interval's start,
+	// zero for any other event.  Returns false once nothing further, in
+	// the direction the card is being read, could matter--provided the
+	// card is in date order.
+	virtual	bool	event(const CARDEVENT &ev, time_t midnight) = 0;
+
+	// The card's events are done
+	virtual	void	end(void) = 0;
+
+	virtual	void	print(OUTBUF &out) = 0;
+};
+
+// The hours worked in one week, Sunday through Saturday
+class	WEEKREPORT : public REPORT {
+	time_t		m_begin, m_end;
+	bool		m_backward;
+	BILLING		m_acc;		// The card being read
+	unsigned long	m_units;	// Every card done with
+public:
+	WEEKREPORT(time_t when);
+
+	// Moves the report to the week holding when
+	void	when(time_t when);
+	// Adds "Week begins: YYYY/MM/DD" to the heading
+	void	heading(void);
+
+	time_t	from(void) const { return m_begin; }
+	bool	backward(void) const { return true; }
+	void	begin(unsigned card, const char *fname, bool backward);
+	bool	event(const CARDEVENT &ev, time_t midnight);
+	void	end(void);
+	void	print(OUTBUF &out);
+};
+
+// The hours worked in one calendar month
+class	MONTHREPORT : public REPORT {
+	time_t		m_begin, m_end;
+	BILLING		m_acc;
+	unsigned long	m_units;
+public:
+	MONTHREPORT(time_t when);
+
+	void	when(time_t when);
+	// Adds the "Month begins:" and "Month ends:" lines to the heading
+	void	heading(void);
+
+	time_t	from(void) const { return m_begin; }
+	void	begin(unsigned card, const char *fname, bool backward);
+	bool	event(const CARDEVENT &ev, time_t midnight);
+	void	end(void);
+	void	print(OUTBUF &out);
+};
+
+// The hours worked ever, and how many of them since each card's last
+// invoice.  Or, if since_only, only those since the last invoice.
+class	TOTALREPORT : public REPORT {
+	bool		m_since, m_backward;
+	BILLING		m_acc;
+	unsigned long	m_cardinv;	// Invoiced, on the card being read
+	unsigned long	m_invoiced, m_pending;
+public:
+	TOTALREPORT(bool since_only = false);
+
+	bool	backward(void) const { return m_since; }
+	void	begin(unsigned card, const char *fname, bool backward);
+	bool	event(const CARDEVENT &ev, time_t midnight);
+	void	end(void);
+	void	print(OUTBUF &out);
+};
+
+// Daily, weekly, monthly, quarterly, and yearly totals, any number of
+// levels at once.  A single card, or several with separate (or latex),
+// get a report of each card in turn, invoices and all.  Otherwise each
+// period gets its total across every card, followed by a column for each.
+class	ROLLREPORT : public REPORT {
+	static const unsigned	MINWIDTH = 5, MAXWIDTH = 20;
+
+	// Seconds worked on one card on one day.  Sixteen bytes, as there
+	// may be one of these for every day worked on every card.
+	typedef	struct	{
+		time_t		m_day;
+		uint32_t	m_card, m_secs;
+	} DAYSECS;
+
+	static	bool	byday(const DAYSECS &a, const DAYSECS &b) {
+		return (a.m_day < b.m_day)
+			|| (a.m_day == b.m_day && a.m_card < b.m_card);
+	}
+
+	unsigned	m_levels;	// A bit for each CALLEVEL
+	bool		m_latex, m_separate, m_cross;
+	unsigned	m_card;		// The card being read
+
+	// Reported card by card, a calendar for each
+	std::vector<CALBUCKETS *>	m_cal;
+
+	// Reported across cards, only the seconds of each day on each card
+	// are kept, all in one list, card after card.  It's then sorted by
+	// day, and every period rounded as it would have been had the cards
+	// been merged as they were read, as CARDMERGE does.  Merging would
+	// keep every card open to the end, at a buffer or two apiece.  This
+	// keeps sixteen bytes for each day of each card instead, which is
+	// less until cards run to many thousands of days.
+	std::vector<bool>		m_open;
+	std::vector<std::string>	m_name;
+	std::vector<DAYSECS>		m_days;
+	CALBUCKETS	m_bounds;	// Only for its period boundaries
+
+	void	row(OUTBUF &out, CALLEVEL lvl, const CALBUCKET &b,
+			unsigned nunits) const;
+	void	separate(OUTBUF &out, CALLEVEL lvl,
+			const time_t *current) const;
+	void	cross(OUTBUF &out, CALLEVEL lvl,
+			const std::vector<DAYSECS> &days,
+			const std::vector<unsigned> &column,
+			const std::vector<unsigned> &width);
+public:
+	ROLLREPORT(unsigned levels, bool latex = false, bool separate = false)
+		: m_levels(levels), m_latex(latex), m_separate(separate),
+		m_cross(false), m_card(0) {}
+	~ROLLREPORT(void);
+
+	void	levels(unsigned lvls) { m_levels |= lvls; }
+
+	// Writes the name of the period starting at begin into buf,
+	// returning a pointer to its end.  Every label of a given level has
+	// the same width.
+	static	char	*label(CALLEVEL lvl, time_t begin, bool latex,
+				char *buf);
+	// One period's \Fee{label}{rate}{hours}{fee} line
+	static	void	fee(OUTBUF &out, CALLEVEL lvl, const CALBUCKET &b,
+				unsigned nunits);
+
+	void	start(unsigned ncards);
+	void	begin(unsigned card, const char *fname, bool backward);
+	bool	event(const CARDEVENT &ev, time_t midnight);
+	void	end(void);
+	void	print(OUTBUF &out);
+};
+
+#endif	// REPORT_H
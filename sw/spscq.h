@@ -0,0 +1,79 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename:	sw/spscq.h
+//
+// Project:	Xtimesheet, a very simple text-based timesheet tracking program
+// {{{
+// Purpose:	A fixed size, lock-free queue between exactly one producer
+//		thread and exactly one consumer thread.  Neither side ever
+//	waits on the other: push() fails when the queue is full, and pop()
+//	when it's empty.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2017-2024, Gisselquist Technology, LLC
+// {{{
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	GPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/gpl.html
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+#ifndef	SPSCQ_H
+#define	SPSCQ_H
+
+#include <atomic>
+
+template<class T, unsigned N>	class	SPSCQUEUE {
+	static_assert((N & (N-1)) == 0, "SPSCQUEUE length must be a power of two");
+
+	T			m_ring[N];
+	// Only the consumer writes m_head, and only the producer m_tail.
+	// Each counts forever, wrapping, and is reduced mod N to index.
+	std::atomic<unsigned>	m_head, m_tail;
+public:
+	SPSCQUEUE(void) : m_head(0), m_tail(0) {}
+
+	// Producer only
+	bool	push(const T &v) {
+		unsigned	tail = m_tail.load(std::memory_order_relaxed);
+
+		if (tail - m_head.load(std::memory_order_acquire) >= N)
+			return false;
+		m_ring[tail & (N-1)] = v;
+		m_tail.store(tail+1, std::memory_order_release);
+		return true;
+	}
+
+	// Consumer only
+	bool	pop(T &v) {
+		unsigned	head = m_head.load(std::memory_order_relaxed);
+
+		if (head == m_tail.load(std::memory_order_acquire))
+			return false;
+		v = m_ring[head & (N-1)];
+		m_head.store(head+1, std::memory_order_release);
+		return true;
+	}
+};
+
+#endif	// SPSCQ_H
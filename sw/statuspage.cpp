@@ -0,0 +1,143 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename:	sw/statuspage.cpp
+//
+// Project:	Xtimesheet, a very simple text-based timesheet tracking program
+// {{{
+// Purpose:	Publishes the status page, under its sequence lock.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2017-2024, Gisselquist Technology, LLC
+// {{{
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	GPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/gpl.html
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+__attribute__((unused))
+static const char *cpyright = "(C) 2024 Gisselquist Technology, LLC: " __FILE__;
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "statuspage.h"
+
+bool	STATUSPAGE::claim(void) {
+	// {{{
+	struct	stat	sb;
+	void		*page;
+
+	if (m_page)
+		return true;
+
+	if (m_fd < 0) {
+		char	name[64];
+
+		tcstatus_name(name, sizeof(name));
+		m_fd = shm_open(name, O_RDWR|O_CREAT|O_CLOEXEC, 0600);
+		if (m_fd < 0)
+			return false;
+	}
+
+	// Someone else is publishing.  Keep the segment open, and try
+	// again next time.
+	if (0 != flock(m_fd, LOCK_EX|LOCK_NB))
+		return false;
+
+	// A new segment, or one an older version left smaller
+	if (0 != fstat(m_fd, &sb) || (sb.st_size < (off_t)sizeof(TCSTATUS)
+			&& 0 != ftruncate(m_fd, sizeof(TCSTATUS)))) {
+		close();
+		return false;
+	}
+
+	page = mmap(NULL, sizeof(TCSTATUS), PROT_READ|PROT_WRITE, MAP_SHARED,
+			m_fd, 0);
+	if (page == MAP_FAILED) {
+		close();
+		return false;
+	}
+
+	m_page = (TCSTATUS *)page;
+	// Whatever an earlier writer was in the middle of, it isn't now
+	if (m_page->m_seq & 1)
+		__atomic_store_n(&m_page->m_seq, m_page->m_seq+1,
+				__ATOMIC_RELEASE);
+	return true;
+}
+// }}}
+
+void	STATUSPAGE::write(const TCSTATUS &st) {
+	// {{{
+	const size_t	skip = offsetof(TCSTATUS, m_magic);
+	uint32_t	seq = m_page->m_seq;
+
+	// Only this process ever writes m_seq, so it can be read plainly
+	__atomic_store_n(&m_page->m_seq, seq+1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	memcpy((char *)m_page + skip, (const char *)&st + skip,
+		sizeof(TCSTATUS) - skip);
+	__atomic_store_n(&m_page->m_seq, seq+2, __ATOMIC_RELEASE);
+}
+// }}}
+
+void	STATUSPAGE::publish(TCSTATUS &st) {
+	// {{{
+	if (!claim())
+		return;
+
+	st.m_magic = TCSTATUS_MAGIC;
+	st.m_version = TCSTATUS_VERSION;
+	st.m_pid = getpid();
+	st.m_published = time(NULL);
+	write(st);
+}
+// }}}
+
+void	STATUSPAGE::close(void) {
+	// {{{
+	if (m_page) {
+		TCSTATUS	st = *m_page;
+
+		st.m_pid = 0;
+		st.m_last_start = 0;
+		st.m_running = 0;
+		write(st);
+		munmap(m_page, sizeof(TCSTATUS));
+		m_page = NULL;
+	}
+
+	// Closing releases the lock
+	if (m_fd >= 0)
+		::close(m_fd);
+	m_fd = -1;
+}
+// }}}
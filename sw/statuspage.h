@@ -0,0 +1,64 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename:	sw/statuspage.h
+//
+// Project:	Xtimesheet, a very simple text-based timesheet tracking program
+// {{{
+// Purpose:	Publishes the status page described in tcstatus.h.  Only
+//		the one xtimesheet that holds the segment's lock publishes.
+//	Any other keeps trying for the lock each time it would publish, and
+//	takes over once the first has closed.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2017-2024, Gisselquist Technology, LLC
+// {{{
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	GPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/gpl.html
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+#ifndef	STATUSPAGE_H
+#define	STATUSPAGE_H
+
+#include "tcstatus.h"
+
+class	STATUSPAGE {
+	int		m_fd;
+	TCSTATUS	*m_page;	// NULL until we hold the lock
+
+	bool	claim(void);
+	void	write(const TCSTATUS &st);
+public:
+	STATUSPAGE(void) : m_fd(-1), m_page(NULL) {}
+	~STATUSPAGE(void) { close(); }
+
+	// Writes st to the page, if it's ours.  The magic number, version,
+	// pid, and time published are filled in here.
+	void	publish(TCSTATUS &st);
+
+	// Tells readers no one's publishing, and lets the page go
+	void	close(void);
+};
+
+#endif	// STATUSPAGE_H
@@ -0,0 +1,153 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename:	sw/strtab.cpp
+//
+// Project:	Xtimesheet, a very simple text-based timesheet tracking program
+// {{{
+// Purpose:	Interned strings, with stable storage and ids.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2017-2024, Gisselquist Technology, LLC
+// {{{
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	GPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/gpl.html
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+__attribute__((unused))
+static const char *cpyright = "(C) 2024 Gisselquist Technology, LLC: " __FILE__;
+
+#include <string.h>
+
+#include "strtab.h"
+
+const unsigned	STRTAB::NONE;
+
+STRTAB::STRTAB(void) {
+	// {{{
+	m_used = CHUNKLEN;	// Nothing to store into, yet
+	m_slots.assign(64, 0);
+}
+// }}}
+
+STRTAB::~STRTAB(void) {
+	// {{{
+	for(unsigned k=0; k<m_chunks.size(); k++)
+		delete[] m_chunks[k];
+}
+// }}}
+
+// FNV-1a
+uint32_t	STRTAB::hash(std::string_view s) {
+	// {{{
+	uint32_t	h = 2166136261u;
+
+	for(size_t k=0; k<s.size(); k++) {
+		h ^= (unsigned char)s[k];
+		h *= 16777619u;
+	}
+
+	return h;
+}
+// }}}
+
+// The slot holding s, or else the empty slot where it would go
+unsigned	STRTAB::slot(std::string_view s, uint32_t h) const {
+	// {{{
+	unsigned	mask = m_slots.size()-1, k = h & mask;
+
+	while(m_slots[k] != 0) {
+		unsigned	id = m_slots[k]-1;
+
+		if (m_hashes[id] == h && m_strs[id] == s)
+			break;
+		k = (k+1) & mask;
+	}
+
+	return k;
+}
+// }}}
+
+// Copies a string into the arena, with a NUL after it
+const char	*STRTAB::store(std::string_view s) {
+	// {{{
+	char	*dst;
+
+	if (s.size() + 1 > CHUNKLEN) {
+		// Too long to share a chunk.  Give it its own, ahead of
+		// the one being filled.
+		dst = new char[s.size()+1];
+		m_chunks.insert(m_chunks.end()
+			- ((m_chunks.empty()) ? 0 : 1), dst);
+	} else {
+		if (m_used + s.size() + 1 > CHUNKLEN) {
+			m_chunks.push_back(new char[CHUNKLEN]);
+			m_used = 0;
+		}
+		dst = &m_chunks.back()[m_used];
+		m_used += s.size() + 1;
+	}
+
+	memcpy(dst, s.data(), s.size());
+	dst[s.size()] = '\0';
+	return dst;
+}
+// }}}
+
+void	STRTAB::rehash(unsigned nslots) {
+	// {{{
+	m_slots.assign(nslots, 0);
+	for(unsigned id=0; id<m_strs.size(); id++)
+		m_slots[slot(m_strs[id], m_hashes[id])] = id+1;
+}
+// }}}
+
+unsigned	STRTAB::intern(std::string_view s) {
+	// {{{
+	uint32_t	h = hash(s);
+	unsigned	k = slot(s, h), id;
+
+	if (m_slots[k] != 0)
+		return m_slots[k]-1;
+
+	id = m_strs.size();
+	m_strs.push_back(std::string_view(store(s), s.size()));
+	m_hashes.push_back(h);
+	m_slots[k] = id+1;
+
+	// Keep the table no more than half full
+	if (2*m_strs.size() > m_slots.size())
+		rehash(2*m_slots.size());
+
+	return id;
+}
+// }}}
+
+unsigned	STRTAB::find(std::string_view s) const {
+	// {{{
+	unsigned	k = slot(s, hash(s));
+
+	return (m_slots[k] != 0) ? m_slots[k]-1 : NONE;
+}
+// }}}
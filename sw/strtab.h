@@ -0,0 +1,81 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename:	sw/strtab.h
+//
+// Project:	Xtimesheet, a very simple text-based timesheet tracking program
+// {{{
+// Purpose:	Interned strings.  Each distinct string is copied once, into a
+//		chunked arena where it never moves, and given a small id
+//	that's good for as long as the table lives.  Lookups hash a
+//	std::string_view straight into an open addressed table, so finding a
+//	string that's already there never builds a temporary, and never
+//	allocates.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2017-2024, Gisselquist Technology, LLC
+// {{{
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	GPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/gpl.html
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+#ifndef	STRTAB_H
+#define	STRTAB_H
+
+#include <stdint.h>
+#include <string_view>
+#include <vector>
+
+class	STRTAB {
+	static const unsigned	CHUNKLEN = 16384;
+
+	std::vector<char *>	m_chunks;	// The arena
+	unsigned		m_used;		// ... of its last chunk
+	std::vector<std::string_view>	m_strs;	// By id
+	std::vector<uint32_t>	m_hashes;	// By id
+	std::vector<unsigned>	m_slots;	// id+1, or zero if empty
+
+	static	uint32_t	hash(std::string_view s);
+	unsigned	slot(std::string_view s, uint32_t h) const;
+	const char	*store(std::string_view s);
+	void	rehash(unsigned nslots);
+public:
+	static const unsigned	NONE = ~0u;
+
+	STRTAB(void);
+	~STRTAB(void);
+
+	// The id of a string, adding it if it isn't already there
+	unsigned	intern(std::string_view s);
+
+	// The id of a string, or NONE if it isn't there
+	unsigned	find(std::string_view s) const;
+
+	// Interned strings are NUL terminated, and stay put
+	const char	*str(unsigned id) const { return m_strs[id].data(); }
+	std::string_view	view(unsigned id) const { return m_strs[id]; }
+	unsigned	size(void) const { return m_strs.size(); }
+};
+
+#endif	// STRTAB_H
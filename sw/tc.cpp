@@ -0,0 +1,671 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename:	sw/tc.cpp
+//
+// Project:	Xtimesheet, a very simple text-based timesheet tracking program
+// {{{
+// Purpose:	Makes any number of reports from one pass through the time
+//		cards.  "tc week month total bymonth -- cards..." reads and
+//	parses each card exactly once, handing every event to all four
+//	reports, and then prints each in turn.
+//
+//	This program is also installed as thisweek, thismonth, totalhrs,
+//	byday, byweek, bymonth and byquarter.  Called by any of those names,
+//	it takes that program's arguments, and makes that program's report.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2017-2024, Gisselquist Technology, LLC
+// {{{
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	GPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/gpl.html
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+__attribute__((unused))
+static const char *cpyright = "(C) 2024 Gisselquist Technology, LLC: " __FILE__;
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <string.h>
+#include <ctype.h>
+
+#include <string>
+#include <vector>
+
+#include "timecard.h"
+#include "cardscan.h"
+#include "cardtail.h"
+#include "cardbatch.h"
+#include "report.h"
+
+// Cards from ~/.xtimesheet no larger than this are all read at once, and
+// parsed from memory
+static	const	size_t	BATCHLIMIT = 256*1024;
+
+// Cards are taken to be in date order, but aren't always: a line may be
+// added late, for an old day.  Read from the end, a card is read on past
+// where every report is done, until a day this much earlier, to see that
+// it is.
+static	const	time_t	TAILCHECK = 7*24*3600;
+
+class	TCRUN {
+	std::vector<REPORT *>	m_reports;
+	std::vector<std::string>	m_cards;
+	std::vector<bool>	m_batched;	// From ~/.xtimesheet?
+	REPORT	**m_live;	// Reports still reading the card
+	unsigned	m_nlive;
+	unsigned	m_nfailed;	// Cards that couldn't be read to their end
+	bool	m_linear;	// Read every card from the top
+	time_t	m_today, m_tomorrow;	// The last day an interval began on
+
+	// The midnight starting the day when is on.  Most intervals begin
+	// on the same day as the last, so that day is kept.
+	time_t	dayof(time_t when) {
+		if (when < m_today || when >= m_tomorrow) {
+			m_today = TZONE::local().midnight(when);
+			m_tomorrow = TZONE::local().midnight(m_today + 36*3600);
+		} return m_today;
+	}
+
+	void	begin(unsigned k, bool backward);
+	void	end(void);
+	bool	dispatch(const CARDEVENT &ev, time_t midnight, bool ordered);
+	bool	tail(unsigned k, bool &inorder);
+	bool	scan(unsigned k, CARDSCAN &card, bool ordered);
+	void	read(unsigned k, const char *data, size_t len);
+public:
+	TCRUN(void) : m_live(NULL), m_nlive(0), m_nfailed(0), m_linear(false),
+		m_today(0), m_tomorrow(0) {}
+	~TCRUN(void);
+
+	// The run owns every report added to it
+	void	add(REPORT *r) { m_reports.push_back(r); }
+	unsigned	size(void) const { return m_reports.size(); }
+
+	void	card(const char *fname, bool batched = false) {
+		m_cards.push_back(fname);
+		m_batched.push_back(batched);
+	}
+	unsigned	ncards(void) const { return m_cards.size(); }
+
+	// Adds every card listed in ~/.xtimesheet
+	void	config(void);
+
+	void	linear(bool on = true) { m_linear = on; }
+
+	// Reads every card, and prints every report, with a blank line
+	// between each if spaced
+	void	run(void);
+	void	print(OUTBUF &out, bool spaced);
+	// Cards found truncated or corrupt along the way.  The reports
+	// include what was read of them, but are short the rest.
+	unsigned	nfailed(void) const { return m_nfailed; }
+};
+
+TCRUN::~TCRUN(void) {
+	// {{{
+	for(unsigned k=0; k<m_reports.size(); k++)
+		delete m_reports[k];
+	delete[] m_live;
+}
+// }}}
+
+void	TCRUN::config(void) {
+	// {{{
+	FILE	*fcfg;
+	char	*home, cfg_file[128], cfg_task[128];
+
+	home = getenv("HOME");
+	if (!home)
+		return;
+	strcpy(cfg_file, home);
+	strcat(cfg_file, "/.xtimesheet");
+	if (NULL != (fcfg = fopen(cfg_file, "r"))) {
+		while(fgets(cfg_task, sizeof(cfg_task), fcfg)) {
+			int	sln = strlen(cfg_task);
+			while(sln > 0 && isspace(cfg_task[sln-1]))
+				cfg_task[--sln] = '\0';
+			if (sln > 0)
+				card(cfg_task, true);
+		} fclose(fcfg);
+	}
+}
+// }}}
+
+// Starts every report on card k
+void	TCRUN::begin(unsigned k, bool backward) {
+	// {{{
+	m_nlive = m_reports.size();
+	for(unsigned r=0; r<m_reports.size(); r++) {
+		m_live[r] = m_reports[r];
+		m_reports[r]->begin(k, m_cards[k].c_str(), backward);
+	}
+}
+// }}}
+
+void	TCRUN::end(void) {
+	// {{{
+	for(unsigned r=0; r<m_reports.size(); r++)
+		m_reports[r]->end();
+}
+// }}}
+
+// Hands one event to every report still reading.  Once the card is known
+// to be in order, a report that's done gets nothing more.  Returns false
+// once every report is done.
+bool	TCRUN::dispatch(const CARDEVENT &ev, time_t midnight, bool ordered) {
+	// {{{
+	for(unsigned r=0; r<m_nlive; ) {
+		if (!m_live[r]->event(ev, midnight) && ordered)
+			m_live[r] = m_live[--m_nlive];
+		else
+			r++;
+	}
+
+	return m_nlive > 0;
+}
+// }}}
+
+// Reads card k from its end, for as long as any report wants more, and then
+// TAILCHECK further.  Only plain text cards can be read this way.  Returns
+// false if the card can't be--or if it turns out not to be in date order,
+// in which case nothing is counted, and inorder is cleared.
+bool	TCRUN::tail(unsigned k, bool &inorder) {
+	// {{{
+	CARDTAIL	tail;
+	CARDEVENT	ev;
+	time_t		earliest = LONG_MAX, until = LONG_MIN;
+
+	if (!tail.open(m_cards[k].c_str()))
+		return false;
+
+	begin(k, true);
+	while(tail.prev(ev)) {
+		time_t	midnight = 0;
+
+		if (ev.m_kind == CE_INTERVAL) {
+			midnight = dayof(ev.m_start);
+			if (midnight > earliest) {
+				inorder = false;
+				return false;
+			} earliest = midnight;
+		}
+
+		if (m_nlive > 0) {
+			// The earliest day counted, if any was
+			if (!dispatch(ev, midnight, true))
+				until = earliest;
+		} else if (ev.m_kind == CE_INTERVAL) {
+			if (until == LONG_MAX)
+				until = midnight;
+			if (midnight + TAILCHECK <= until)
+				break;
+		}
+	} end();
+
+	return true;
+}
+// }}}
+
+// Reads card k forwards.  If it's been taken to be in order, reading ends
+// once every report is done--but if it turns out not to be, nothing is
+// counted, and false is returned so that it can be read again, all of it.
+bool	TCRUN::scan(unsigned k, CARDSCAN &card, bool ordered) {
+	// {{{
+	CARDEVENT	ev;
+	time_t		last = 0;
+
+	begin(k, false);
+	while(card.next(ev)) {
+		time_t	midnight = 0;
+
+		if (ev.m_kind == CE_INTERVAL) {
+			midnight = dayof(ev.m_start);
+			if (ordered && midnight < last)
+				return false;
+			last = midnight;
+		}
+
+		if (!dispatch(ev, midnight, ordered))
+			break;
+	} end();
+
+	if (card.error())
+		m_nfailed++;
+	return true;
+}
+// }}}
+
+// Reads card k, as little of it as the reports allow.  A card that's
+// already been read into memory may be given as data, len.
+void	TCRUN::read(unsigned k, const char *data, size_t len) {
+	// {{{
+	const char	*fname = m_cards[k].c_str();
+	time_t		from = LONG_MAX;
+	bool		backward = true, inorder = true;
+
+	for(unsigned r=0; r<m_reports.size(); r++) {
+		if (m_reports[r]->from() < from)
+			from = m_reports[r]->from();
+		if (!m_reports[r]->backward())
+			backward = false;
+	}
+
+	if (!data && backward && !m_linear && tail(k, inorder))
+		return;
+
+	for(int pass=0; pass<2; pass++) {
+		CARDSCAN	card;
+		bool		ordered;
+
+		if (!(data && card.open(data, len, fname))
+				&& !card.open(fname)) {
+			if (!m_batched[k])
+				fprintf(stderr, "ERR: Cannot read %s\n", fname);
+			return;
+		}
+
+		ordered = (pass == 0 && inorder && !m_linear
+				&& from != LONG_MIN);
+		if (ordered)
+			ordered = card.seek(from);
+
+		if (scan(k, card, ordered))
+			return;
+	}
+}
+// }}}
+
+void	TCRUN::run(void) {
+	// {{{
+	CARDBATCH		batch;
+	std::vector<unsigned>	which;	// Card of each one batched
+
+	delete[] m_live;
+	m_live = new REPORT *[m_reports.size()];
+	for(unsigned r=0; r<m_reports.size(); r++)
+		m_reports[r]->start(m_cards.size());
+
+	for(unsigned k=0; k<m_cards.size(); k++) {
+		if (m_batched[k]) {
+			batch.add(m_cards[k].c_str());
+			which.push_back(k);
+		} else
+			read(k, NULL, 0);
+	}
+
+	// Small cards are read all together, the rest as they come
+	batch.read([&](unsigned k, const char *data, size_t len) {
+		read(which[k], data, len);
+	}, BATCHLIMIT);
+}
+// }}}
+
+void	TCRUN::print(OUTBUF &out, bool spaced) {
+	// {{{
+	for(unsigned r=0; r<m_reports.size(); r++) {
+		if (spaced && r > 0)
+			out.put('\n');
+		m_reports[r]->print(out);
+	}
+}
+// }}}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// The programs tc stands in for
+// {{{
+////////////////////////////////////////////////////////////////////////////////
+//
+//
+
+static	void	thisweek(TCRUN &run, int argc, char **argv) {
+	// {{{
+	TIMECARD	tc;
+	WEEKREPORT	*wk = new WEEKREPORT(time(NULL));
+
+	run.add(wk);
+	wk->heading();
+
+	if (!getenv("HOME")) {
+		fprintf(stderr, "No $HOME environment variable defined\n");
+		exit(EXIT_FAILURE);
+	}
+
+	for(int argn=1; argn<argc; argn++) {
+		if (0 == strcmp(argv[argn], "-a")) {
+			run.linear();
+		} else if (access(argv[argn], R_OK)==0) {
+			run.card(argv[argn]);
+		} else if (argv[argn][0] == '%') {
+			run.config();
+		} else if (tc.digitstr(argv[argn],4)) { // Specify the week
+			wk->when(tc.get_midnight(argv[argn]));
+			wk->heading();
+		} else
+			fprintf(stderr, "Unknown arg, %s\n", argv[argn]);
+	}
+}
+// }}}
+
+static	void	thismonth(TCRUN &run, int argc, char **argv) {
+	// {{{
+	TIMECARD	tc;
+	MONTHREPORT	*mo;
+
+	if (argc <= 1) {
+		fprintf(stderr, "Usage: thismonth [-a] [month|[startdate enddate]] timesheet.txt [*]\n"
+"\n"
+"\t-a\tRead all of every card, from the top.  Without it, cards are\n"
+"\t\ttaken to be in date order, and only the month itself is read.\n");
+		exit(EXIT_SUCCESS);
+	}
+
+	mo = new MONTHREPORT(time(NULL));
+	run.add(mo);
+	for(int argn=1; argn<argc; argn++) {
+		if (0 == strcmp(argv[argn], "-a")) {
+			run.linear();
+		} else if (access(argv[argn], R_OK)==0) {
+			run.card(argv[argn]);
+		} else if (argv[argn][0] == '%') {
+			run.config();
+		} else if (tc.digitstr(argv[argn],4)) {
+			// {{{
+			char	datestr[32], line[64];
+
+			strncpy(datestr, argv[argn], sizeof(datestr)-3);
+			datestr[sizeof(datestr)-3] = '\0';
+			if ((tc.digitstr(datestr, 6))&&(!tc.digitstr(datestr, 8)))
+				strcat(datestr, "01");
+
+			snprintf(line, sizeof(line), "Making time from %s\n",
+				datestr);
+			mo->head(line);
+			mo->when(tc.get_midnight(datestr));
+			mo->heading();
+			// }}}
+		}
+	}
+}
+// }}}
+
+static	void	totalhrs(TCRUN &run, int argc, char **argv) {
+	// {{{
+	bool	since_only = false;
+
+	for(int argn=1; argn<argc; argn++) {
+		if (argv[argn][0] == '-') {
+			if (argv[argn][1] == 'i')
+				since_only = true;
+			else {
+				fprintf(stderr,
+"USAGE: totalhrs [-i] timesheet.txt ... [%%]\n"
+"\n"
+"\t-i\tOnly the hours since each card's last invoice\n"
+"\n"
+"A %% stands for every card listed in ~/.xtimesheet.\n");
+				exit(EXIT_FAILURE);
+			}
+		} else if (access(argv[argn], R_OK)==0) {
+			run.card(argv[argn]);
+		} else if (argv[argn][0] == '%') {
+			run.config();
+		} else fprintf(stderr, "WARNING: Cannot access %s\n", argv[argn]);
+	}
+
+	run.add(new TOTALREPORT(since_only));
+}
+// }}}
+
+static	void	rollup_usage(void) {
+	// {{{
+	fprintf(stderr,
+"USAGE: byday|byweek|bymonth|byquarter [-l|-s] [-d|-w|-m|-q|-y] timesheet.txt ...\n"
+"\n"
+"\t-l\tOutput \\Fee{}{}{}{} lines for a LaTeX invoice\n"
+"\t-s\tReport each card separately, with its invoices\n"
+"\t-d\tDaily totals\n"
+"\t-w\tWeekly totals, by ISO week\n"
+"\t-m\tMonthly totals\n"
+"\t-q\tQuarterly totals\n"
+"\t-y\tYearly totals\n"
+"\n"
+"Several reports may be given at once.  All will come from one pass\n"
+"through the time cards.  Without any, the report is chosen by the name\n"
+"of the program.\n"
+"\n"
+"Several cards are merged by date, and each period's total is given across\n"
+"all of them, followed by a column for each project.  With -s or -l, each\n"
+"card is instead reported on its own, one after another.\n");
+}
+// }}}
+
+static	void	rollup(TCRUN &run, unsigned reports,
+			int argc, char **argv) {
+	// {{{
+	bool		latex = false, separate = false;
+	unsigned	levels = 0;
+
+	for(int argn=1; argn<argc; argn++) {
+		if (argv[argn][0] == '-') {
+			switch(tolower(argv[argn][1])) {
+			case 'l': latex = true; break;
+			case 's': separate = true; break;
+			case 'd': levels |= (1<<CB_DAY);	break;
+			case 'w': levels |= (1<<CB_WEEK);	break;
+			case 'm': levels |= (1<<CB_MONTH);	break;
+			case 'q': levels |= (1<<CB_QUARTER);	break;
+			case 'y': levels |= (1<<CB_YEAR);	break;
+			default:
+				rollup_usage();
+				exit(EXIT_FAILURE);
+			}
+		} else
+			run.card(argv[argn]);
+	}
+
+	run.add(new ROLLREPORT((levels) ? levels : reports, latex, separate));
+}
+// }}}
+
+// }}}
+
+void	usage(void) {
+	// {{{
+	fprintf(stderr,
+"USAGE: tc [-a] [-l] [-s] report ... [--] timesheet.txt ... [%%]\n"
+"\n"
+"\t-a\tRead all of every card, from the top.  Without it, cards are\n"
+"\t\ttaken to be in date order, and only as much of each is read\n"
+"\t\tas the reports need.\n"
+"\t-l\tRoll up as \\Fee{}{}{}{} lines, for a LaTeX invoice, as\n"
+"\t\tbyday -l and the like do\n"
+"\t-s\tRoll up each card separately, with its invoices\n"
+"\n"
+"Reports:\n"
+"\tweek[=YYYYMMDD]\tHours in the week, Sunday through Saturday,\n"
+"\t\t\tholding the date, by default this one (thisweek)\n"
+"\tmonth[=YYYYMM]\tHours in the month, by default this one (thismonth)\n"
+"\ttotal\t\tHours ever, and since the last invoice (totalhrs)\n"
+"\tsince\t\tHours since each card's last invoice (totalhrs -i)\n"
+"\tbyday, byweek, bymonth, byquarter, byyear\n"
+"\t\t\tTotals for each period.  Several cards are merged\n"
+"\t\t\tby date, unless -s or -l is given.\n"
+"\n"
+"Every card is read once, whatever the reports.  The reports follow in the\n"
+"order given, but the rollups all come together, where the first was given.\n"
+"A %% stands for every card listed in ~/.xtimesheet.  This program may also\n"
+"be called as thisweek, thismonth, totalhrs, byday, byweek, bymonth or\n"
+"byquarter, to make that report as that program would.\n");
+}
+// }}}
+
+int main(int argc, char **argv) {
+	TIMECARD	tc;
+	TCRUN		run;
+	OUTBUF		out;
+	ROLLREPORT	*roll = NULL;
+	bool		latex = false, separate = false, cards = false;
+	const char	*pname;
+
+	pname = strrchr(argv[0], '/');
+	pname = (pname) ? pname+1 : argv[0];
+
+	// {{{
+	if (0 == strcmp(pname, "thisweek"))
+		thisweek(run, argc, argv);
+	else if (0 == strcmp(pname, "thismonth"))
+		thismonth(run, argc, argv);
+	else if (0 == strcmp(pname, "totalhrs"))
+		totalhrs(run, argc, argv);
+	else if (0 == strcmp(pname, "byday"))
+		rollup(run, (1<<CB_DAY), argc, argv);
+	else if (0 == strcmp(pname, "byweek"))
+		rollup(run, (1<<CB_WEEK), argc, argv);
+	else if (0 == strcmp(pname, "bymonth"))
+		rollup(run, (1<<CB_MONTH), argc, argv);
+	else if (0 == strcmp(pname, "byquarter"))
+		rollup(run, (1<<CB_QUARTER), argc, argv);
+	// }}}
+
+	if (run.size() > 0) {
+		run.run();
+		run.print(out, false);
+		return (run.nfailed() > 0) ? EXIT_FAILURE : 0;
+	}
+
+	// Options come first, so the rollup can be made where it's placed
+	for(int argn=1; argn<argc && strcmp(argv[argn], "--"); argn++) {
+		// {{{
+		if (argv[argn][0] != '-')
+			continue;
+
+		switch(argv[argn][1]) {
+		case 'a': run.linear(); break;
+		case 'l': latex = true; break;
+		case 's': separate = true; break;
+		default:
+			usage();
+			exit(EXIT_FAILURE);
+		}
+		// }}}
+	}
+
+	for(int argn=1; argn<argc; argn++) {
+		const char	*arg = argv[argn], *eq = strchr(arg, '=');
+		size_t		len = (eq) ? (size_t)(eq - arg) : strlen(arg);
+		unsigned	lvl = CB_NLEVELS;
+
+		if (cards) {
+			// {{{
+			if (0 == strcmp(arg, "%"))
+				run.config();
+			else
+				run.card(arg);
+			// }}}
+		} else if (0 == strcmp(arg, "--")) {
+			cards = true;
+		} else if (arg[0] == '-') {
+			continue;
+		} else if (len == 4 && 0 == strncmp(arg, "week", len)) {
+			// {{{
+			WEEKREPORT	*wk = new WEEKREPORT(time(NULL));
+
+			if (eq) {
+				if (!tc.digitstr(eq+1, 8)) {
+					fprintf(stderr, "ERR: Bad date, %s\n", arg);
+					exit(EXIT_FAILURE);
+				} wk->when(tc.get_midnight(eq+1));
+			}
+
+			wk->heading();
+			run.add(wk);
+			// }}}
+		} else if (len == 5 && 0 == strncmp(arg, "month", len)) {
+			// {{{
+			MONTHREPORT	*mo = new MONTHREPORT(time(NULL));
+
+			if (eq) {
+				char	datestr[16];
+
+				if (!tc.digitstr(eq+1, 6) || strlen(eq+1) > 8) {
+					fprintf(stderr, "ERR: Bad month, %s\n", arg);
+					exit(EXIT_FAILURE);
+				}
+
+				strcpy(datestr, eq+1);
+				if (!tc.digitstr(datestr, 8))
+					strcat(datestr, "01");
+				mo->when(tc.get_midnight(datestr));
+			}
+
+			mo->heading();
+			run.add(mo);
+			// }}}
+		} else if (0 == strcmp(arg, "total")) {
+			run.add(new TOTALREPORT(false));
+		} else if (0 == strcmp(arg, "since")) {
+			run.add(new TOTALREPORT(true));
+		} else if (0 == strcmp(arg, "byday")) {
+			lvl = CB_DAY;
+		} else if (0 == strcmp(arg, "byweek")) {
+			lvl = CB_WEEK;
+		} else if (0 == strcmp(arg, "bymonth")) {
+			lvl = CB_MONTH;
+		} else if (0 == strcmp(arg, "byquarter")) {
+			lvl = CB_QUARTER;
+		} else if (0 == strcmp(arg, "byyear")) {
+			lvl = CB_YEAR;
+		} else if (0 == strcmp(arg, "%")) {
+			run.config();
+		} else if (access(arg, R_OK)==0) {
+			run.card(arg);
+		} else {
+			fprintf(stderr, "ERR: Unknown report, %s\n", arg);
+			usage();
+			exit(EXIT_FAILURE);
+		}
+
+		// Every rollup is made by the one report, placed where the
+		// first was asked for
+		if (lvl < CB_NLEVELS) {
+			if (!roll) {
+				roll = new ROLLREPORT(0, latex, separate);
+				run.add(roll);
+			} roll->levels(1<<lvl);
+		}
+	}
+
+	if (run.size() == 0 || run.ncards() == 0) {
+		usage();
+		exit(EXIT_FAILURE);
+	}
+
+	run.run();
+	run.print(out, true);
+	return (run.nfailed() > 0) ? EXIT_FAILURE : 0;
+}
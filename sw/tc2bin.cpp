@@ -0,0 +1,229 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename:	sw/tc2bin.cpp
+//
+// Project:	Xtimesheet, a very simple text-based timesheet tracking program
+// {{{
+// Purpose:	Converts a (closed) text time card into a .tcb binary card.
+//		The conversion is lossless: bin2tc will give back the
+//	original text, byte for byte.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2017-2024, Gisselquist Technology, LLC
+// {{{
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	GPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/gpl.html
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+__attribute__((unused))
+static const char *cpyright = "(C) 2024 Gisselquist Technology, LLC: " __FILE__;
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+#include "timecard.h"
+#include "cardfile.h"
+#include "tcbfile.h"
+
+#define	MXLEN	4096
+
+// The day number of a local midnight
+static	long	dayof(time_t midnight) {
+	// {{{
+	struct	tm	datev;
+
+	TIMECARD::localtime(midnight, datev);
+	return TZONE::days_from_civil(datev.tm_year+1900, datev.tm_mon+1,
+			datev.tm_mday);
+}
+// }}}
+
+// Is this an interval line, exactly as TIMECARD::log() would write it?  If
+// so, the record holds only the numbers.
+static	bool	canonical(TIMECARD &tc, const char *line, long &day,
+			unsigned &start, unsigned &dur) {
+	// {{{
+	char	buf[128];
+	time_t	lnstart, lnstop, midnight;
+
+	if (line[4] != '/' || !tc.parse(line, lnstart, lnstop)
+			|| lnstart <= 24*3600)
+		return false;
+
+	// Don't trust the date to be in range, check it
+	midnight = tc.get_midnight(line);
+	if (tc.get_midnight(lnstart) != midnight)
+		return false;
+
+	day   = dayof(midnight);
+	start = lnstart - midnight;
+	dur   = lnstop - lnstart;
+
+	TCBREADER::render(buf, sizeof(buf), day, start, dur);
+	return (0 == strcmp(buf, line));
+}
+// }}}
+
+void	usage(void) {
+	// {{{
+	fprintf(stderr,
+"USAGE: tc2bin timesheet.txt [timesheet.tcb]\n"
+"\n"
+"Converts a time card to the .tcb binary format.  Without an output name,\n"
+"the output replaces the card's .txt extension with .tcb.  Only convert\n"
+"cards that are no longer being written to.\n");
+}
+// }}}
+
+int main(int argc, char **argv) {
+	TIMECARD	tc;
+	CARDFILE	fp;
+	TCBWRITER	tcb;
+	std::string	project, outname;
+	std::vector<std::string>	rates;
+	char		*line;
+	bool		have_project = false;
+	long		day = 0;
+
+	if (argc < 2 || argc > 3 || argv[1][0] == '-') {
+		usage();
+		exit(EXIT_FAILURE);
+	}
+
+	if (argc > 2)
+		outname = argv[2];
+	else {
+		const char	*ext = strrchr(argv[1], '.');
+
+		if (ext && strchr(ext, '/') == NULL)
+			outname.assign(argv[1], ext - argv[1]);
+		else
+			outname = argv[1];
+		outname += ".tcb";
+	}
+
+	if (0 == access(outname.c_str(), F_OK)) {
+		fprintf(stderr, "ERR: %s already exists.  Cowardly refusing "
+			"to overwrite it\n", outname.c_str());
+		exit(EXIT_FAILURE);
+	}
+
+	if (TCBREADER::istcb(argv[1])) {
+		fprintf(stderr, "ERR: %s is already a .tcb card\n", argv[1]);
+		exit(EXIT_FAILURE);
+	}
+
+	line = new char[MXLEN];
+
+	// First pass: the project and rate lines go into the header
+	// {{{
+	if (!fp.open(argv[1])) {
+		fprintf(stderr, "ERR: Cannot open %s\n", argv[1]);
+		exit(EXIT_FAILURE);
+	}
+
+	while(fp.gets(line, MXLEN)) {
+		if (strncasecmp(line, "rate:", 5)==0) {
+			unsigned	k;
+
+			for(k=0; k<rates.size(); k++)
+				if (rates[k] == line)
+					break;
+			if (k >= rates.size())
+				rates.push_back(line);
+		} else if (!have_project
+				&& strncasecmp(line, "project:", 8)==0) {
+			project = line;
+			have_project = true;
+		}
+	}
+
+	// Half a card is worse than none
+	if (fp.error())
+		exit(EXIT_FAILURE);
+	fp.close();
+	// }}}
+
+	// Second pass: the records
+	// {{{
+	if (!fp.open(argv[1]) || !tcb.open(outname.c_str(), project, rates)) {
+		fprintf(stderr, "ERR: Cannot convert %s to %s\n",
+			argv[1], outname.c_str());
+		exit(EXIT_FAILURE);
+	}
+
+	have_project = false;
+	while(fp.gets(line, MXLEN)) {
+		unsigned	len = strlen(line), start, dur;
+		time_t		lnstart, lnstop;
+		long		lnday;
+
+		if (strncasecmp(line, "rate:", 5)==0) {
+			unsigned	k;
+
+			for(k=0; rates[k] != line; k++)
+				;
+			tcb.rate(k);
+		} else if (!have_project && project == line) {
+			tcb.project();
+			have_project = true;
+		} else if ((strncasecmp(line, "project:", 8)==0)) {
+			tcb.text(line, len, day, 0);
+		} else if ((strncasecmp(line, "invoice", 7)==0)
+				||(strncasecmp(line, "billed", 6)==0)) {
+			tcb.invoice(line, len);
+		} else if (canonical(tc, line, lnday, start, dur)) {
+			day = lnday;
+			tcb.interval(day, start, dur);
+		} else if (tc.parse(line, lnstart, lnstop)) {
+			// Kept as text, but we still need to follow the date
+			if (lnstart > 24*3600)
+				day = dayof(tc.get_midnight(lnstart));
+			tcb.text(line, len, day, lnstop - lnstart);
+		} else
+			tcb.text(line, len, day, 0);
+	}
+
+	if (fp.error()) {
+		tcb.close();
+		unlink(outname.c_str());
+		exit(EXIT_FAILURE);
+	} fp.close();
+	// }}}
+
+	delete[] line;
+
+	if (!tcb.close()) {
+		fprintf(stderr, "ERR: Could not write %s\n", outname.c_str());
+		unlink(outname.c_str());
+		exit(EXIT_FAILURE);
+	}
+
+	return 0;
+}
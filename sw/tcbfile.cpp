@@ -0,0 +1,487 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename:	sw/tcbfile.cpp
+//
+// Project:	Xtimesheet, a very simple text-based timesheet tracking program
+// {{{
+// Purpose:	Writes and reads .tcb binary time cards.  See tcbfile.h for
+//		the layout.  The reader maps the whole file into memory and
+//	decodes records in place, so reading an archived card costs little
+//	more than touching its pages.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2017-2024, Gisselquist Technology, LLC
+// {{{
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	GPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/gpl.html
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+__attribute__((unused))
+static const char *cpyright = "(C) 2024 Gisselquist Technology, LLC: " __FILE__;
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "tzone.h"
+#include "tcbfile.h"
+
+// TCBWRITER
+// {{{
+void	TCBWRITER::put(std::string &s, uint64_t v) {
+	// {{{
+	while(v >= 0x80) {
+		s += (char)((v & 0x7f) | 0x80);
+		v >>= 7;
+	} s += (char)v;
+}
+// }}}
+
+void	TCBWRITER::put_signed(std::string &s, int64_t v) {
+	// {{{
+	put(s, ((uint64_t)v << 1) ^ (uint64_t)(v >> 63));
+}
+// }}}
+
+bool	TCBWRITER::open(const char *fname, const std::string &project,
+			const std::vector<std::string> &rates) {
+	// {{{
+	std::string	hdr;
+
+	close();
+	m_fp = fopen(fname, "wb");
+	if (NULL == m_fp)
+		return false;
+
+	hdr = TCB_MAGIC;
+	put(hdr, TCB_VERSION);
+	put(hdr, project.size());
+	hdr += project;
+	put(hdr, rates.size());
+	for(unsigned k=0; k<rates.size(); k++) {
+		put(hdr, rates[k].size());
+		hdr += rates[k];
+	}
+
+	fwrite(hdr.data(), 1, hdr.size(), m_fp);
+
+	m_day = 0;
+	m_blk.clear();
+	memset(&m_hdr, 0, sizeof(m_hdr));
+	return true;
+}
+// }}}
+
+void	TCBWRITER::flush(void) {
+	// {{{
+	std::string	hdr;
+
+	if (m_hdr.m_nrecs == 0)
+		return;
+
+	put(hdr, m_blk.size());
+	put(hdr, m_hdr.m_nrecs);
+	put_signed(hdr, m_hdr.m_first_day);
+	put_signed(hdr, m_hdr.m_last_day);
+	put(hdr, m_hdr.m_secs);
+	put(hdr, m_hdr.m_flags);
+	fwrite(hdr.data(), 1, hdr.size(), m_fp);
+	fwrite(m_blk.data(), 1, m_blk.size(), m_fp);
+
+	m_blk.clear();
+	memset(&m_hdr, 0, sizeof(m_hdr));
+}
+// }}}
+
+bool	TCBWRITER::close(void) {
+	// {{{
+	std::string	end;
+	bool		r;
+
+	if (NULL == m_fp)
+		return false;
+
+	flush();
+	put(end, 0);	// Length
+	put(end, 0);	// Records
+	fwrite(end.data(), 1, end.size(), m_fp);
+
+	r = (0 == ferror(m_fp));
+	if (0 != fclose(m_fp))
+		r = false;
+	m_fp = NULL;
+	return r;
+}
+// }}}
+
+void	TCBWRITER::add_day(long day) {
+	// {{{
+	// Start a new block if this one is full
+	if (m_hdr.m_nrecs >= BLOCKRECS)
+		flush();
+
+	if (m_hdr.m_nrecs == 0)
+		m_hdr.m_first_day = m_hdr.m_last_day = m_day;
+	m_hdr.m_nrecs++;
+
+	if (day != m_day) {
+		m_day = day;
+		m_hdr.m_last_day = day;
+	}
+}
+// }}}
+
+void	TCBWRITER::interval(long day, unsigned start, unsigned dur) {
+	// {{{
+	long	last = m_day;
+
+	add_day(day);
+
+	m_blk += (char)TCB_INTERVAL;
+	put_signed(m_blk, day - last);
+	put(m_blk, start);
+	put(m_blk, dur);
+	m_hdr.m_secs += dur;
+}
+// }}}
+
+void	TCBWRITER::text(const char *line, unsigned len, long day,
+		unsigned secs) {
+	// {{{
+	long	last = m_day;
+
+	add_day(day);
+
+	m_blk += (char)TCB_TEXT;
+	put(m_blk, len);
+	m_blk.append(line, len);
+	put_signed(m_blk, day - last);
+	m_hdr.m_secs += secs;
+}
+// }}}
+
+void	TCBWRITER::rate(unsigned idx) {
+	// {{{
+	add_day(m_day);
+	m_blk += (char)TCB_RATE;
+	put(m_blk, idx);
+}
+// }}}
+
+void	TCBWRITER::invoice(const char *line, unsigned len) {
+	// {{{
+	add_day(m_day);
+	m_blk += (char)TCB_INVOICE;
+	put(m_blk, len);
+	m_blk.append(line, len);
+	m_hdr.m_flags |= TCB_INVOICED;
+}
+// }}}
+
+void	TCBWRITER::project(void) {
+	// {{{
+	add_day(m_day);
+	m_blk += (char)TCB_PROJECT;
+}
+// }}}
+// }}}
+
+// TCBREADER
+// {{{
+bool	TCBREADER::istcb(const char *fname) {
+	// {{{
+	char	magic[4];
+	int	fd;
+	bool	r;
+
+	if (0 > (fd = ::open(fname, O_RDONLY)))
+		return false;
+	r = (4 == read(fd, magic, 4)) && (0 == memcmp(magic, TCB_MAGIC, 4));
+	::close(fd);
+	return r;
+}
+// }}}
+
+unsigned	TCBREADER::render(char *line, unsigned len, long day,
+			unsigned start, unsigned dur) {
+	// {{{
+	long		year;
+	unsigned	mon, mday, stop = start + dur;
+	int		n;
+
+	TZONE::civil_from_days(day, year, mon, mday);
+	n = snprintf(line, len,
+		"%04ld/%02u/%02u %02u%02u%02u -- %02u%02u%02u (%4.1f)\n",
+		year, mon, mday,
+		start / 3600, (start / 60) % 60, start % 60,
+		stop / 3600, (stop / 60) % 60, stop % 60, dur / 3600.0);
+	return (n < 0) ? 0 : ((unsigned)n >= len) ? len-1 : (unsigned)n;
+}
+// }}}
+
+bool	TCBREADER::get(uint64_t &v) {
+	// {{{
+	unsigned	shift = 0;
+
+	v = 0;
+	while(m_ptr < m_blkend && shift < 64) {
+		unsigned char	b = *m_ptr++;
+
+		v |= (uint64_t)(b & 0x7f) << shift;
+		if (0 == (b & 0x80))
+			return true;
+		shift += 7;
+	}
+
+	m_err = true;
+	return false;
+}
+// }}}
+
+bool	TCBREADER::get_signed(int64_t &v) {
+	// {{{
+	uint64_t	u;
+
+	if (!get(u))
+		return false;
+	v = (int64_t)(u >> 1) ^ -(int64_t)(u & 1);
+	return true;
+}
+// }}}
+
+bool	TCBREADER::get_text(const char *&text, unsigned &len) {
+	// {{{
+	uint64_t	v;
+
+	if (!get(v))
+		return false;
+	if (v > (uint64_t)(m_blkend - m_ptr)) {
+		m_err = true;
+		return false;
+	}
+
+	text  = (const char *)m_ptr;
+	len   = (unsigned)v;
+	m_ptr += len;
+	return true;
+}
+// }}}
+
+bool	TCBREADER::open(const char *fname) {
+	// {{{
+	struct stat	sb;
+	const char	*text;
+	unsigned	len;
+	uint64_t	v, nrates;
+	int		fd;
+
+	close();
+	m_err = false;
+
+	if (0 > (fd = ::open(fname, O_RDONLY)))
+		return false;
+	if (0 != fstat(fd, &sb) || sb.st_size < 4) {
+		::close(fd);
+		return false;
+	}
+
+	m_size = sb.st_size;
+	m_data = (unsigned char *)mmap(NULL, m_size, PROT_READ, MAP_PRIVATE,
+				fd, 0);
+	::close(fd);
+	if (MAP_FAILED == m_data) {
+		m_data = NULL;
+		return false;
+	}
+	madvise(m_data, m_size, MADV_SEQUENTIAL);
+
+	if (0 != memcmp(m_data, TCB_MAGIC, 4)) {
+		close();
+		return false;
+	}
+
+	// Parse the header.  Until the first block, the "block" is the rest
+	// of the file.
+	m_ptr    = m_data + 4;
+	m_blkend = m_data + m_size;
+	if (!get(v) || v != TCB_VERSION) {
+		fprintf(stderr, "ERR: %s is not a version %d .tcb file\n",
+			fname, TCB_VERSION);
+		close();
+		return false;
+	}
+
+	if (!get_text(text, len)) {
+		close();
+		return false;
+	} m_project.assign(text, len);
+
+	if (!get(nrates)) {
+		close();
+		return false;
+	} for(uint64_t k=0; k<nrates; k++) {
+		if (!get_text(text, len)) {
+			close();
+			return false;
+		}
+
+		m_ratelines.push_back(std::string(text, len));
+		// "Rate:" is five characters long
+		m_rates.push_back((len > 5) ? atof(m_ratelines.back().c_str()+5)
+				: 0.0);
+	}
+
+	memset(&m_blk, 0, sizeof(m_blk));
+	m_blkend = m_ptr;
+	m_day = 0;
+	return true;
+}
+// }}}
+
+void	TCBREADER::close(void) {
+	// {{{
+	if (m_data)
+		munmap(m_data, m_size);
+	m_data = NULL;
+	m_size = 0;
+	m_project.clear();
+	m_ratelines.clear();
+	m_rates.clear();
+}
+// }}}
+
+bool	TCBREADER::block_header(void) {
+	// {{{
+	uint64_t	len, nrecs, flags;
+	int64_t		first, last;
+
+	// The block header's fields are bounded by the end of the file
+	m_blkend = m_data + m_size;
+	if (!get(len) || !get(nrecs))
+		return false;
+	if (len == 0 && nrecs == 0)
+		return false;	// The end of the file
+
+	if (!get_signed(first) || !get_signed(last) || !get(m_blk.m_secs)
+			|| !get(flags))
+		return false;
+
+	if (len > (uint64_t)(m_blkend - m_ptr)) {
+		m_err = true;
+		return false;
+	}
+
+	m_blk.m_nrecs     = (unsigned)nrecs;
+	m_blk.m_first_day = first;
+	m_blk.m_last_day  = last;
+	m_blk.m_flags     = (unsigned)flags;
+	m_blkend = m_ptr + len;
+	m_day    = first;
+	return true;
+}
+// }}}
+
+void	TCBREADER::skip_to(long day) {
+	// {{{
+	if (NULL == m_data || m_err || m_ptr < m_blkend)
+		return;
+
+	while(1) {
+		const unsigned char	*hdr = m_ptr;
+
+		if (!block_header() || m_blk.m_last_day >= day
+				|| m_blk.m_first_day > m_blk.m_last_day) {
+			// Leave this header to be read again by next()
+			m_ptr = m_blkend = hdr;
+			return;
+		}
+
+		m_ptr = m_blkend;
+	}
+}
+// }}}
+
+bool	TCBREADER::next(TCBREC &rec) {
+	// {{{
+	uint64_t	v;
+	int64_t		delta;
+
+	if (NULL == m_data || m_err)
+		return false;
+
+	while(m_ptr >= m_blkend) {
+		if (!block_header())
+			return false;
+	}
+
+	rec.m_kind = (TCBKIND)*m_ptr++;
+	rec.m_text = NULL;
+	rec.m_len  = 0;
+	switch(rec.m_kind) {
+	case TCB_INTERVAL:
+		if (!get_signed(delta) || !get(v))
+			return false;
+		rec.m_start = (unsigned)v;
+		if (!get(v))
+			return false;
+		rec.m_dur = (unsigned)v;
+		m_day += delta;
+		break;
+	case TCB_TEXT:
+		if (!get_text(rec.m_text, rec.m_len) || !get_signed(delta))
+			return false;
+		m_day += delta;
+		break;
+	case TCB_RATE:
+		if (!get(v))
+			return false;
+		if (v >= m_rates.size()) {
+			m_err = true;
+			return false;
+		}
+		rec.m_rate = (unsigned)v;
+		break;
+	case TCB_INVOICE:
+		if (!get_text(rec.m_text, rec.m_len))
+			return false;
+		break;
+	case TCB_PROJECT:
+		rec.m_text = m_project.data();
+		rec.m_len  = m_project.size();
+		break;
+	default:
+		m_err = true;
+		return false;
+	}
+
+	rec.m_day = m_day;
+	return true;
+}
+// }}}
+// }}}
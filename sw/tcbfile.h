@@ -0,0 +1,176 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename:	sw/tcbfile.h
+//
+// Project:	Xtimesheet, a very simple text-based timesheet tracking program
+// {{{
+// Purpose:	Defines the .tcb binary time card format, used for archived
+//		cards that are read often but never written to again.
+//
+//	A .tcb file starts with a header:
+//		"TCB1", varint version,
+//		varint length, the (first) Project: line,
+//		varint count, and then for each Rate: line in the card,
+//			varint length, the line itself.
+//	Then come blocks of records, each with a header of varints:
+//		payload length, record count, the day in effect at the start
+//		of the block (zigzag), the last day in the block (zigzag),
+//		the seconds worked within the block, and flags (TCB_INVOICED
+//		if the block contains an invoice marker).
+//	A block header with a zero length and zero records ends the file.
+//
+//	Every line of the text card becomes one record, so nothing is lost
+//	in the conversion.  Interval lines written in the format that
+//	TIMECARD::log() produces become three varints: the change in day
+//	number (zigzag), the start time in seconds since midnight, and the
+//	duration.  Anything else--comments, relative lines, hand-edited
+//	intervals--is kept verbatim.  Days are counted from 1970/01/01, and
+//	are delta-coded from the start of each block, so any block can be
+//	decoded on its own.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2017-2024, Gisselquist Technology, LLC
+// {{{
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	GPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/gpl.html
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+#ifndef	TCBFILE_H
+#define	TCBFILE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#define	TCB_MAGIC	"TCB1"
+#define	TCB_VERSION	1
+#define	TCB_INVOICED	1
+
+// Record types
+typedef	enum	{
+	TCB_INTERVAL,	// day delta, start, duration
+	TCB_TEXT,	// length, bytes, day delta
+	TCB_RATE,	// index into the header's rate table
+	TCB_INVOICE,	// length, bytes
+	TCB_PROJECT	// The header's project line
+} TCBKIND;
+
+typedef	struct	TCBREC_S {
+	TCBKIND		m_kind;
+	long		m_day;		// Day in effect after this record
+	unsigned	m_start, m_dur;	// TCB_INTERVAL only
+	unsigned	m_rate;		// TCB_RATE only
+	const char	*m_text;	// Not NUL terminated
+	unsigned	m_len;
+} TCBREC;
+
+typedef	struct	TCBBLOCK_S {
+	unsigned	m_nrecs;
+	long		m_first_day, m_last_day;
+	uint64_t	m_secs;
+	unsigned	m_flags;
+} TCBBLOCK;
+
+class	TCBWRITER {
+	static const unsigned	BLOCKRECS = 4096;
+
+	FILE		*m_fp;
+	std::string	m_blk;
+	TCBBLOCK	m_hdr;
+	long		m_day;
+
+	static	void	put(std::string &s, uint64_t v);
+	static	void	put_signed(std::string &s, int64_t v);
+	void	add_day(long day);
+	void	flush(void);
+public:
+	TCBWRITER(void) : m_fp(NULL) {}
+	~TCBWRITER(void) { close(); }
+
+	bool	open(const char *fname, const std::string &project,
+			const std::vector<std::string> &rates);
+	bool	close(void);
+
+	void	interval(long day, unsigned start, unsigned dur);
+	void	text(const char *line, unsigned len, long day, unsigned secs);
+	void	rate(unsigned idx);
+	void	invoice(const char *line, unsigned len);
+	void	project(void);
+};
+
+class	TCBREADER {
+	unsigned char	*m_data;
+	size_t		m_size;
+	const unsigned char	*m_ptr, *m_blkend;
+	TCBBLOCK	m_blk;
+	long		m_day;
+	bool		m_err;
+
+	std::string	m_project;
+	std::vector<std::string>	m_ratelines;
+	std::vector<double>		m_rates;
+
+	bool	get(uint64_t &v);
+	bool	get_signed(int64_t &v);
+	bool	get_text(const char *&text, unsigned &len);
+	bool	block_header(void);
+public:
+	TCBREADER(void) : m_data(NULL), m_size(0), m_err(false) {}
+	~TCBREADER(void) { close(); }
+
+	static	bool	istcb(const char *fname);
+
+	// Writes an interval record out as TIMECARD::log() would have
+	// written it, returning the length of the line
+	static	unsigned	render(char *line, unsigned len, long day,
+				unsigned start, unsigned dur);
+
+	bool	open(const char *fname);
+	void	close(void);
+	bool	isopen(void) const { return m_data != NULL; }
+
+	// Returns false at the end of the file, or on a corrupt file
+	bool	next(TCBREC &rec);
+	bool	error(void) const { return m_err; }
+
+	// The block the last record came from, and a way to skip the rest
+	// of it
+	const TCBBLOCK	&block(void) const { return m_blk; }
+	void	skip_block(void) { m_ptr = m_blkend; }
+
+	// Skips, from the top of a block, every whole block that ends before
+	// the given day, by its header alone.  The records skipped may
+	// include rate and invoice records.
+	void	skip_to(long day);
+
+	const std::string	&project(void) const { return m_project; }
+	const std::string	&rateline(unsigned k) const {
+		return m_ratelines[k]; }
+	double	rate(unsigned k) const { return m_rates[k]; }
+	unsigned	nrates(void) const { return m_rates.size(); }
+};
+
+#endif	// TCBFILE_H
@@ -0,0 +1,678 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename:	sw/tccheck.cpp
+//
+// Project:	Xtimesheet, a very simple text-based timesheet tracking program
+// {{{
+// Purpose:	Behind make check.  Writes a handful of small time cards,
+//		each built to catch one way the tools have gone wrong before,
+//	runs the tools on them as a user would, and compares what they print
+//	against what they should.  Prints each check as it's run, and exits
+//	with a non-zero status if any failed.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2017-2024, Gisselquist Technology, LLC
+// {{{
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	GPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/gpl.html
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+__attribute__((unused))
+static const char *cpyright = "(C) 2024 Gisselquist Technology, LLC: " __FILE__;
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <zlib.h>
+
+#include <new>
+#include <string>
+
+#include "cardio.h"
+#include "cardscan.h"
+#include "strtab.h"
+
+// Where the cards are written, and the tools run from, and where the tools
+// are found.  Both are full paths.
+static	char	dir[PATH_MAX], bindir[PATH_MAX];
+
+static	bool	write_file(const char *fname, const char *text,
+			const char *mode = "w") {
+	// {{{
+	std::string	path = std::string(dir) + "/" + fname;
+	FILE		*fp;
+	size_t		len = strlen(text);
+	bool		ok;
+
+	if (NULL == (fp = fopen(path.c_str(), mode)))
+		return false;
+	ok = (len == fwrite(text, 1, len, fp));
+	return (0 == fclose(fp)) && ok;
+}
+// }}}
+
+// Writes text gzip compressed, less the last cut bytes of the file
+static	bool	write_gzip(const char *fname, const char *text, unsigned cut) {
+	// {{{
+	std::string	path = std::string(dir) + "/" + fname;
+	struct	stat	sb;
+	gzFile		gz;
+	unsigned	len = strlen(text);
+	bool		ok;
+
+	if (NULL == (gz = gzopen(path.c_str(), "wb")))
+		return false;
+	ok = ((int)len == gzwrite(gz, text, len));
+	if (Z_OK != gzclose(gz) || !ok)
+		return false;
+
+	return 0 == stat(path.c_str(), &sb) && sb.st_size > (off_t)cut
+		&& 0 == truncate(path.c_str(), sb.st_size - cut);
+}
+// }}}
+
+// Runs a tool from bindir, within dir, capturing everything it prints, to
+// stdout and stderr alike.  Returns its exit status, or -1 if it couldn't
+// be run.
+static	int	run(const char *cmd, std::string &out) {
+	// {{{
+	std::string	sh;
+	FILE		*fp;
+	char		buf[4096];
+	size_t		nr;
+	int		status;
+
+	sh = std::string("cd ") + dir + " && " + bindir + "/" + cmd + " 2>&1";
+	out.clear();
+	if (NULL == (fp = popen(sh.c_str(), "r")))
+		return -1;
+	while((nr = fread(buf, 1, sizeof(buf), fp)) > 0)
+		out.append(buf, nr);
+	status = pclose(fp);
+
+	return (WIFEXITED(status)) ? WEXITSTATUS(status) : -1;
+}
+// }}}
+
+// Checks a tool's output, and whether it succeeded, reporting any
+// difference
+static	bool	expect(const char *cmd, const char *want,
+			bool want_ok = true) {
+	// {{{
+	std::string	got;
+	int		st = run(cmd, got);
+
+	if (got == want && (st == 0) == want_ok)
+		return true;
+
+	printf("\t%s exited with %d, and printed:\n%s", cmd, st, got.c_str());
+	printf("\tbut should have %s, and printed:\n%s",
+		(want_ok) ? "succeeded" : "failed", want);
+	return false;
+}
+// }}}
+
+// Every operator new on a thread while it's counting.  The I/O thread never
+// counts, so what it allocates isn't charged to the thread posting to it.
+static	thread_local	bool	counting = false;
+static	thread_local	unsigned long	nallocs = 0;
+
+void	*operator new(size_t len) {
+	// {{{
+	void	*ptr;
+
+	if (counting)
+		nallocs++;
+	if (NULL == (ptr = malloc((len > 0) ? len : 1)))
+		throw std::bad_alloc();
+	return ptr;
+}
+// }}}
+
+void	operator delete(void *ptr) noexcept { free(ptr); }
+void	operator delete(void *ptr, size_t) noexcept { free(ptr); }
+
+// The checks
+// {{{
+// Each card's invoices are its own.  What's not yet invoiced on one card
+// mustn't be counted on the next card's first invoice.
+static	bool	separate_invoices(void) {
+	// {{{
+	if (!write_file("alpha.txt",
+			"Project: Alpha\n"
+			"2024/05/03 090000 -- 130000\n"
+			"2024/05/04 090000 -- 133000\n"
+			"billed 2024/05/31\n"
+			"2024/06/03 090000 -- 110000\n")
+		|| !write_file("beta.txt",
+			"Project: Beta\n"
+			"2024/05/06 090000 -- 130000\n"
+			"billed 2024/05/31\n"
+			"2024/06/04 090000 -- 100000\n"))
+		return false;
+
+	return expect("bymonth -l alpha.txt beta.txt",
+			"\\Fee{2024/05}{225.00}{8.5}{1912.50}\n"
+			"INVOICE -- 8.5\n"
+			"\\Fee{2024/06}{225.00}{2.0}{450.00}\n"
+			"\\Fee{2024/05}{225.00}{4.0}{900.00}\n"
+			"INVOICE -- 4.0\n"
+			"\\Fee{2024/06}{225.00}{1.0}{225.00}\n")
+		&& expect("bymonth -s alpha.txt beta.txt",
+			"2024/05:  8.5\n"
+			"INVOICE -- 8.5\n"
+			"2024/06:  2.0\n"
+			"2024/05:  4.0\n"
+			"INVOICE -- 4.0\n"
+			"2024/06:  1.0\n"
+			"Total: 15.5 Hours\n");
+}
+// }}}
+
+// -l means a LaTeX invoice to tc, as it does to the programs tc stands in for
+static	bool	latex_flag(void) {
+	// {{{
+	static const char	want[] =
+		"\\Fee{2024/05}{225.00}{4.0}{900.00}\n";
+
+	if (!write_file("fee.txt",
+			"Project: Fee\n"
+			"2024/05/06 090000 -- 130000\n"))
+		return false;
+
+	return expect("bymonth -l fee.txt", want)
+		&& expect("tc -l bymonth -- fee.txt", want);
+}
+// }}}
+
+// A compressed card cut short is an error, not a shorter card.  Cutting off
+// the gzip trailer leaves every line readable, so they're all counted, but
+// the tool must still say the card's truncated, and fail.
+static	bool	truncated_gzip(void) {
+	// {{{
+	if (!write_gzip("cut.txt.gz",
+			"Project: Cut\n"
+			"2024/05/03 090000 -- 130000\n"
+			"2024/06/03 090000 -- 110000\n", 8))
+		return false;
+
+	return expect("bymonth -s cut.txt.gz",
+			"ERR: cut.txt.gz: truncated compressed stream\n"
+			"2024/05:  4.0\n"
+			"2024/06:  2.0\n"
+			"Total: 6.0 Hours\n", false);
+}
+// }}}
+
+// What's not yet invoiced is reported only for a card with time this month
+static	bool	pending_trailer(void) {
+	// {{{
+	struct	tm	tv;
+	time_t		now = time(NULL);
+	char		text[128], want[128];
+
+	localtime_r(&now, &tv);
+	snprintf(text, sizeof(text), "Project: Now\n"
+			"2024/05/06 090000 -- 130000\n"
+			"billed 2024/05/31\n"
+			"%04d/%02d/01 090000 -- 100000\n",
+			tv.tm_year+1900, tv.tm_mon+1);
+	snprintf(want, sizeof(want), "2024/05:  4.0\n"
+			"INVOICE -- 4.0\n"
+			"%04d/%02d:  1.0\n"
+			"NOT-YET INVOICED -- 1.0\n"
+			"Total: 5.0 Hours\n",
+			tv.tm_year+1900, tv.tm_mon+1);
+
+	return write_file("now.txt", text) && expect("bymonth now.txt", want);
+}
+// }}}
+
+// Projects' names are of any length, yet their values must still line up
+static	bool	project_columns(void) {
+	// {{{
+	if (!write_file("short.txt",
+			"Project: Ax\n"
+			"2024/05/03 090000 -- 130000\n"
+			"billed 2024/05/31\n"
+			"2024/06/03 090000 -- 100000\n")
+		|| !write_file("long.txt",
+			"Project: A longer name\n"
+			"2024/05/06 090000 -- 113000\n"))
+		return false;
+
+	return expect("tcq 'sum group by project' short.txt long.txt",
+			"Ax                 5.00\n"
+			"A longer name      2.50\n")
+		&& expect("tcq 'sum group by invoice' short.txt long.txt",
+			"Ax #1                     4.00\n"
+			"Ax (open)                 1.00\n"
+			"A longer name (open)      2.50\n");
+}
+// }}}
+
+// A line added late, for an old day, mustn't hide the days above it from a
+// report read from the end of the card
+static	bool	backdated_line(void) {
+	// {{{
+	static const char	want[] = "Week begins: 2024/03/10\n3.0 Hours\n";
+	const	size_t	wlen = strlen(want);
+	std::string	got;
+	int		st;
+
+	if (!write_file("late.txt",
+			"Project: Late\n"
+			"2024/03/10 090000 -- 100000\n"
+			"2024/03/11 090000 -- 110000\n"
+			"2024/02/01 090000 -- 100000\n"))
+		return false;
+
+	// The first heading is this week's, whatever week that is
+	st = run("thisweek 20240310 late.txt", got);
+	if (st == 0 && got.size() >= wlen
+			&& 0 == got.compare(got.size()-wlen, wlen, want))
+		return true;
+
+	printf("\tthisweek exited with %d, and printed:\n%s", st, got.c_str());
+	printf("\tbut should have ended with:\n%s", want);
+	return false;
+}
+// }}}
+
+// Reads what's new on a card through io, picking up where last left off,
+// as xtimesheet would.  Returns NULL if the worker never answers.
+static	CARDREQ	*read_card(CARDIO &io, const char *fname,
+			const CARDREQ *last) {
+	// {{{
+	std::string	path = std::string(dir) + "/" + fname;
+	CARDREQ		*req = new CARDREQ(CR_READ, path.c_str());
+
+	if (last) {
+		req->m_scanned = true;
+		req->m_ino  = last->m_ino;
+		req->m_size = last->m_size;
+		req->m_seen = last->m_seen;
+		req->m_tail = last->m_tail;
+	}
+
+	io.post(req);
+	for(unsigned k=0; k<5000; k++) {
+		if (NULL != (req = io.result()))
+			return req;
+		usleep(1000);
+	}
+
+	return NULL;
+}
+// }}}
+
+// Checks a read's result, reporting any difference
+static	bool	expect_read(const CARDREQ *req, const char *want,
+			bool restart) {
+	// {{{
+	if (NULL == req) {
+		printf("\tThe read never finished\n");
+		return false;
+	} else if (!req->m_error && req->m_data == want
+			&& req->m_restart == restart)
+		return true;
+
+	printf("\tRead%s%s:\n%s\n\tbut should have%s read:\n%s\n",
+		(req->m_error) ? ", with an error" : "",
+		(req->m_restart) ? ", from the top" : "", req->m_data.c_str(),
+		(restart) ? ", from the top," : "", want);
+	return false;
+}
+// }}}
+
+// A card's last line, left without a newline, is read once the card stops
+// changing.  If it's then added to after all, the card is read again.
+static	bool	unterminated_line(void) {
+	// {{{
+	CARDIO	io;
+	CARDREQ	*req, *last;
+	bool	ok;
+
+	io.start([](void) {});
+	if (!write_file("open.txt", "Project: Open\n"))
+		return false;
+	last = read_card(io, "open.txt", NULL);
+	ok = expect_read(last, "Project: Open\n", true);
+
+	// Still being written, for all we know
+	if (ok && write_file("open.txt", "2024/05/03 090000 -- 130000", "a")) {
+		req = read_card(io, "open.txt", last);
+		ok = expect_read(req, "", false);
+		delete last;
+		last = req;
+	} else
+		ok = false;
+
+	// ... but not any more
+	if (ok) {
+		req = read_card(io, "open.txt", last);
+		ok = expect_read(req, "2024/05/03 090000 -- 130000", false);
+		delete last;
+		last = req;
+	}
+
+	if (ok && write_file("open.txt", "\n2024/05/04 090000 -- 100000\n",
+			"a")) {
+		req = read_card(io, "open.txt", last);
+		ok = expect_read(req, "Project: Open\n"
+			"2024/05/03 090000 -- 130000\n"
+			"2024/05/04 090000 -- 100000\n", true);
+		delete last;
+		last = req;
+	} else
+		ok = false;
+
+	delete last;
+	io.shutdown();
+	return ok;
+}
+// }}}
+
+// Switching back to a card, and reloading it, as the GUI does, mustn't
+// allocate once its name and path are interned and a read request has been
+// recycled: the names are found in place, and the request reused
+static	bool	reload_allocs(void) {
+	// {{{
+	static const char	project[] = "Project: Resident\n",
+				line[] = "2024/05/03 090000 -- 100000\n";
+	static const unsigned	NRELOADS = 100;
+	std::string	path = std::string(dir) + "/resident.txt", tail;
+	STRTAB		strtab;
+	CARDIO		io;
+	CARDREQ		*req;
+	unsigned	card, name;
+	ino_t		ino;
+	off_t		size, seen;
+	unsigned long	n = 0;
+	bool		ok = true, found;
+
+	if (!write_file("resident.txt", project))
+		return false;
+
+	io.start([](void) {});
+	card = strtab.intern(path);
+	name = strtab.intern(std::string_view(&project[9], 8));
+	req = read_card(io, "resident.txt", NULL);
+	if (!expect_read(req, project, true)) {
+		delete req;
+		io.shutdown();
+		return false;
+	}
+
+	for(unsigned k=0; ok && k<NRELOADS; k++) {
+		// Where the last read left off, as the card's state keeps it
+		ino  = req->m_ino;
+		size = req->m_size;
+		seen = req->m_seen;
+		tail = req->m_tail;
+		if (!write_file("resident.txt", line, "a")) {
+			ok = false;
+			break;
+		}
+
+		counting = true; nallocs = 0;
+		// load(): the card's path, and its Project: line's name
+		found = (card == strtab.intern(path.c_str()))
+			&& (name == strtab.intern(
+				std::string_view(&project[9], 8)))
+			&& (name == strtab.find("Resident"));
+		// update(): a spare request, posted again
+		req->reset(CR_READ, strtab.str(card));
+		req->m_scanned = true;
+		req->m_ino  = ino;
+		req->m_size = size;
+		req->m_seen = seen;
+		req->m_tail = tail;
+		io.post(req);
+		// collect()
+		for(unsigned w=0; w<5000 && NULL == (req = io.result()); w++)
+			usleep(1000);
+		counting = false;
+		n += nallocs;
+
+		if (!found) {
+			printf("\tAn interned name was given a new id\n");
+			ok = false;
+		} else if (!expect_read(req, line, false))
+			ok = false;
+	}
+
+	delete req;
+	io.shutdown();
+
+	if (ok && n != 0) {
+		printf("\t%lu allocations over %u reloads, rather than none\n",
+			n, NRELOADS);
+		ok = false;
+	}
+	return ok;
+}
+// }}}
+
+// Several writers appending to one card at once mustn't tear each other's
+// lines, whether a record fits in one atomic pipe-sized write or not
+static	bool	concurrent_appends(void) {
+	// {{{
+	static const unsigned	NWRITERS = 4, NRECS = 100, NBIG = 10,
+				BIGLINES = 160, LNLEN = 28;
+	static const unsigned	NLINES = (NRECS - NBIG) + NBIG * BIGLINES;
+	std::string	path = std::string(dir) + "/shared.txt";
+	CARDSCAN	card;
+	CARDEVENT	ev;
+	FILE		*fp;
+	char		*ln;
+	unsigned	nlines = 0, nintervals = 0, ntorn = 0;
+	int		status;
+	bool		ok = true;
+
+	// Bigger than PIPE_BUF, so no single write of one is atomic
+	static_assert(BIGLINES * LNLEN > PIPE_BUF, "BIGLINES too few");
+
+	if (!write_file("shared.txt", "Project: Shared\n"))
+		return false;
+
+	fflush(stdout);
+	for(unsigned w=0; w<NWRITERS; w++) {
+		pid_t	pid = fork();
+
+		if (pid < 0)
+			return false;
+		else if (pid == 0) {
+			// Each writer's lines are on its own day, ten seconds
+			// apart
+			char	*rec = new char[BIGLINES * LNLEN + 1];
+			unsigned	nth = 0;
+			bool		wok = true;
+
+			for(unsigned k=0; wok && k<NRECS; k++) {
+				unsigned	nl = (k % (NRECS/NBIG) == 0)
+							? BIGLINES : 1;
+
+				for(unsigned j=0; j<nl; j++, nth++) {
+					unsigned	t0 = nth * 10, t1 = t0 + 5;
+
+					sprintf(&rec[j*LNLEN], "2024/05/%02u "
+						"%02u%02u%02u -- %02u%02u%02u\n",
+						w+1, t0/3600, (t0/60)%60, t0%60,
+						t1/3600, (t1/60)%60, t1%60);
+				}
+				wok = TIMECARD::append(path.c_str(), rec,
+						nl * LNLEN);
+			}
+
+			delete[] rec;
+			_exit((wok) ? EXIT_SUCCESS : EXIT_FAILURE);
+		}
+	}
+
+	for(unsigned w=0; w<NWRITERS; w++) {
+		if (wait(&status) < 0 || !WIFEXITED(status)
+				|| WEXITSTATUS(status) != EXIT_SUCCESS)
+			ok = false;
+	}
+
+	if (!ok) {
+		printf("\tA writer failed\n");
+		return false;
+	}
+
+	// Every line whole: the project, and then intervals of one length
+	if (NULL == (fp = fopen(path.c_str(), "r")))
+		return false;
+	ln = new char[256];
+	if (!fgets(ln, 256, fp) || 0 != strcmp(ln, "Project: Shared\n"))
+		ntorn++;
+	while(fgets(ln, 256, fp)) {
+		time_t	lnstart, lnstop;
+
+		nlines++;
+		if (strlen(ln) != LNLEN || ln[LNLEN-1] != '\n'
+				|| !card.parse(ln, lnstart, lnstop)
+				|| lnstop - lnstart != 5)
+			ntorn++;
+	}
+	delete[] ln;
+	fclose(fp);
+
+	if (card.open(path.c_str())) {
+		while(card.next(ev))
+			if (ev.m_kind == CE_INTERVAL)
+				nintervals++;
+		if (card.nbad() > 0 || card.error())
+			ntorn++;
+		card.close();
+	}
+
+	if (ntorn == 0 && nlines == NWRITERS * NLINES
+			&& nintervals == NWRITERS * NLINES)
+		return true;
+
+	printf("\t%u torn lines, and %u lines holding %u intervals, of %u\n",
+		ntorn, nlines, nintervals, NWRITERS * NLINES);
+	return false;
+}
+// }}}
+
+// Shutting down while results back up, untaken, mustn't wait on the worker
+// forever, as it waits on room for them
+static	bool	shutdown_backlog(void) {
+	// {{{
+	CARDIO	io;
+
+	if (!write_file("idle.txt", "Project: Idle\n"))
+		return false;
+
+	io.start([](void) {});
+	for(unsigned k=0; k<1000; k++)
+		io.post(new CARDREQ(CR_READ,
+				(std::string(dir) + "/idle.txt").c_str()));
+
+	// A shutdown that hangs takes the whole check down with it
+	alarm(30);
+	io.shutdown();
+	alarm(0);
+	return true;
+}
+// }}}
+
+typedef	struct	{
+	const char	*m_name;
+	bool		(*m_check)(void);
+} CHECK;
+
+static	const	CHECK	checks[] = {
+	{ "separate-invoices",	separate_invoices },
+	{ "latex-flag",		latex_flag },
+	{ "truncated-gzip",	truncated_gzip },
+	{ "pending-trailer",	pending_trailer },
+	{ "project-columns",	project_columns },
+	{ "unterminated-line",	unterminated_line },
+	{ "shutdown-backlog",	shutdown_backlog },
+	{ "backdated-line",	backdated_line },
+	{ "reload-allocs",	reload_allocs },
+	{ "concurrent-appends",	concurrent_appends },
+	{ NULL, NULL }
+};
+// }}}
+
+void	usage(void) {
+	// {{{
+	fprintf(stderr,
+"USAGE: tccheck [-d dir] bindir\n"
+"\n"
+"\t-d dir\tWhere to write the cards the tools are checked on.  [check]\n"
+"\n"
+"Runs the tools found in bindir on small cards written to catch old bugs,\n"
+"and reports any whose output isn't what it should be.\n");
+}
+// }}}
+
+int main(int argc, char **argv) {
+	const char	*dname = "check", *bname = NULL;
+	unsigned	nfailed = 0, nchecks = 0;
+
+	for(int argn=1; argn<argc; argn++) {
+		if (strcmp(argv[argn], "-d") == 0 && argn+1 < argc)
+			dname = argv[++argn];
+		else if (NULL == bname && argv[argn][0] != '-')
+			bname = argv[argn];
+		else {
+			usage();
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	if (NULL == bname) {
+		usage();
+		exit(EXIT_FAILURE);
+	}
+
+	mkdir(dname, 0777);
+	if (NULL == realpath(bname, bindir) || NULL == realpath(dname, dir)) {
+		fprintf(stderr, "ERR: Cannot find %s or %s\n", bname, dname);
+		exit(EXIT_FAILURE);
+	}
+
+	for(const CHECK *c = checks; c->m_name; c++, nchecks++) {
+		bool	ok = c->m_check();
+
+		printf("%-24s %s\n", c->m_name, (ok) ? "ok" : "FAILED");
+		if (!ok)
+			nfailed++;
+	}
+
+	printf("%u of %u checks failed\n", nfailed, nchecks);
+	return (nfailed > 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
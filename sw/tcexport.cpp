@@ -0,0 +1,343 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename:	sw/tcexport.cpp
+//
+// Project:	Xtimesheet, a very simple text-based timesheet tracking program
+// {{{
+// Purpose:	Exports every interval in a set of time cards, one row per
+//		interval, as either CSV or JSON Lines.  Each row holds the
+//	project, the (local) date, start and stop times, the seconds worked,
+//	and the invoice period: the number of invoice markers that came
+//	before the interval in its card.
+//
+//	Rows are streamed as the cards are read, so memory use doesn't
+//	depend upon how many cards there are or how large they are.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2017-2024, Gisselquist Technology, LLC
+// {{{
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	GPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/gpl.html
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+__attribute__((unused))
+static const char *cpyright = "(C) 2024 Gisselquist Technology, LLC: " __FILE__;
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string>
+
+#include "timecard.h"
+#include "cardscan.h"
+#include "outbuf.h"
+
+class	EXPORTER {
+	OUTBUF		&m_out;
+	bool		m_json;
+	std::string	m_project;	// Already quoted for the output
+	unsigned	m_nfailed;	// Cards cut short, or corrupt
+
+	// The local day of the last time written.  On days without a clock
+	// change, the time of day is just the seconds since midnight.
+	time_t		m_begin, m_end;
+	struct	tm	m_date;
+
+	void	quote(const char *str, unsigned len);
+	void	datetime(time_t when, bool with_date);
+public:
+	EXPORTER(OUTBUF &out, bool json) : m_out(out), m_json(json),
+			m_nfailed(0), m_begin(0), m_end(0) {}
+
+	void	header(void);
+	bool	card(const char *fname);
+	// Every card listed in ~/.xtimesheet
+	void	config(void);
+	// Cards exported only in part, having been found truncated or corrupt
+	unsigned	nfailed(void) const { return m_nfailed; }
+};
+
+void	EXPORTER::quote(const char *str, unsigned len) {
+	// {{{
+	m_project.clear();
+	if (m_json) {
+		// {{{
+		static const char	hex[] = "0123456789abcdef";
+
+		m_project += '"';
+		for(unsigned k=0; k<len; k++) {
+			unsigned char	ch = str[k];
+
+			if (ch == '"' || ch == '\\') {
+				m_project += '\\';
+				m_project += ch;
+			} else if (ch < 0x20) {
+				m_project += "\\u00";
+				m_project += hex[ch >> 4];
+				m_project += hex[ch & 15];
+			} else
+				m_project += ch;
+		}
+		m_project += '"';
+		// }}}
+	} else if (strpbrk(std::string(str, len).c_str(), ",\"\r\n")) {
+		// {{{
+		m_project += '"';
+		for(unsigned k=0; k<len; k++) {
+			if (str[k] == '"')
+				m_project += '"';
+			m_project += str[k];
+		}
+		m_project += '"';
+		// }}}
+	} else
+		m_project.assign(str, len);
+}
+// }}}
+
+void	EXPORTER::datetime(time_t when, bool with_date) {
+	// {{{
+	unsigned	secs;
+
+	if (when < m_begin || when >= m_end) {
+		const TZONE	&tz = TZONE::local();
+
+		tz.localtime(when, m_date);
+		m_begin = tz.civil(m_date.tm_year+1900, m_date.tm_mon+1,
+				m_date.tm_mday);
+		m_end   = tz.civil(m_date.tm_year+1900, m_date.tm_mon+1,
+				m_date.tm_mday+1);
+	}
+
+	if (m_end - m_begin == 24*3600)
+		secs = when - m_begin;
+	else {
+		// A daylight savings change.  Look it up.
+		struct	tm	datev;
+
+		TIMECARD::localtime(when, datev);
+		secs = (datev.tm_hour * 60 + datev.tm_min) * 60 + datev.tm_sec;
+	}
+
+	if (with_date) {
+		if (m_json)
+			m_out.put(",\"date\":\"", 9);
+		else
+			m_out.put(',');
+		m_out.put_fixed(m_date.tm_year+1900, 4);
+		m_out.put('-');
+		m_out.put_fixed(m_date.tm_mon+1, 2);
+		m_out.put('-');
+		m_out.put_fixed(m_date.tm_mday, 2);
+		if (m_json)
+			m_out.put("\",\"start\":\"", 11);
+		else
+			m_out.put(',');
+	} else if (m_json)
+		m_out.put("\",\"stop\":\"", 10);
+	else
+		m_out.put(',');
+
+	m_out.put_fixed(secs / 3600, 2);
+	m_out.put(':');
+	m_out.put_fixed((secs / 60) % 60, 2);
+	m_out.put(':');
+	m_out.put_fixed(secs % 60, 2);
+}
+// }}}
+
+void	EXPORTER::header(void) {
+	// {{{
+	if (!m_json)
+		m_out.put("project,date,start,stop,seconds,invoice\n");
+}
+// }}}
+
+bool	EXPORTER::card(const char *fname) {
+	// {{{
+	CARDSCAN	scan;
+	CARDEVENT	ev;
+	unsigned	period = 0;
+
+	if (!scan.open(fname)) {
+		fprintf(stderr, "WARNING: Cannot open %s\n", fname);
+		return false;
+	}
+
+	// Until we see a Project: line, name the project after its card
+	{
+		const char	*base = strrchr(fname, '/'), *ext;
+
+		base = (base) ? base+1 : fname;
+		ext  = strchr(base, '.');
+		quote(base, (ext) ? (unsigned)(ext-base) : strlen(base));
+	}
+
+	while(scan.next(ev)) {
+		switch(ev.m_kind) {
+		case CE_PROJECT: {
+			const char	*name = &ev.m_line[8];
+			unsigned	len;
+
+			while(*name && isspace(*name))
+				name++;
+			len = strlen(name);
+			while(len > 0 && isspace(name[len-1]))
+				len--;
+			quote(name, len);
+			} break;
+		case CE_INVOICE:
+			period++;
+			break;
+		case CE_INTERVAL:
+			if (m_json)
+				m_out.put("{\"project\":", 11);
+			m_out.put(m_project.data(), m_project.size());
+			datetime(ev.m_start, true);
+			datetime(ev.m_stop, false);
+			if (m_json)
+				m_out.put("\",\"seconds\":", 12);
+			else
+				m_out.put(',');
+			m_out.put_int(ev.m_stop - ev.m_start);
+			if (m_json)
+				m_out.put(",\"invoice\":", 11);
+			else
+				m_out.put(',');
+			m_out.put_uint(period);
+			if (m_json)
+				m_out.put('}');
+			m_out.put('\n');
+			break;
+		default:
+			break;
+		}
+	}
+
+	if (scan.error()) {
+		m_nfailed++;
+		return false;
+	}
+
+	scan.close();
+	return true;
+}
+// }}}
+
+void	EXPORTER::config(void) {
+	// {{{
+	FILE	*fcfg;
+	char	*home, cfg_file[128], task_line[128], *cfg_task;
+
+	home = getenv("HOME");
+	if (NULL == home) {
+		fprintf(stderr, "No $HOME environment variable defined\n");
+		exit(EXIT_FAILURE);
+	}
+
+	strcpy(cfg_file, home);
+	strcat(cfg_file, "/.xtimesheet");
+	if (NULL != (fcfg = fopen(cfg_file, "r"))) {
+		while(fgets(task_line, sizeof(task_line), fcfg)) {
+			cfg_task = strtok(task_line, " \r\n");
+			if (cfg_task)
+				card(cfg_task);
+		} fclose(fcfg);
+	}
+}
+// }}}
+
+void	usage(void) {
+	// {{{
+	fprintf(stderr,
+"USAGE: tcexport [-c|-j] [-o outfile] [timesheet.txt ...] [%%]\n"
+"\n"
+"\t-c\tCSV output, with a header line (the default)\n"
+"\t-j\tJSON Lines output, one object per interval\n"
+"\t-o\tWrite to outfile, rather than standard out\n"
+"\n"
+"A %% stands for every card listed in ~/.xtimesheet.  With no cards given,\n"
+"all of those cards are exported.\n");
+}
+// }}}
+
+int main(int argc, char **argv) {
+	bool		json = false, any = false;
+	int		fd = STDOUT_FILENO;
+	const char	*outname = NULL;
+
+	for(int argn=1; argn<argc; argn++) {
+		if (argv[argn][0] != '-')
+			any = true;
+		else if (argv[argn][1] == 'c')
+			json = false;
+		else if (argv[argn][1] == 'j')
+			json = true;
+		else if (argv[argn][1] == 'o' && argn+1 < argc)
+			outname = argv[++argn];
+		else {
+			usage();
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	if (outname) {
+		fd = open(outname, O_WRONLY|O_CREAT|O_TRUNC, 0644);
+		if (fd < 0) {
+			fprintf(stderr, "ERR: Cannot open %s\n", outname);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	OUTBUF		out(fd);
+	EXPORTER	xp(out, json);
+
+	xp.header();
+	for(int argn=1; argn<argc; argn++) {
+		if (argv[argn][0] == '-') {
+			if (argv[argn][1] == 'o')
+				argn++;
+		} else if (argv[argn][0] == '%')
+			xp.config();
+		else
+			xp.card(argv[argn]);
+	}
+
+	if (!any)
+		xp.config();
+
+	out.flush();
+	if (out.error()) {
+		fprintf(stderr, "ERR: Could not write the export\n");
+		exit(EXIT_FAILURE);
+	}
+
+	if (fd != STDOUT_FILENO)
+		close(fd);
+	return (xp.nfailed() > 0) ? EXIT_FAILURE : 0;
+}
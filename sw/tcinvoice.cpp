@@ -0,0 +1,478 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename:	sw/tcinvoice.cpp
+//
+// Project:	Xtimesheet, a very simple text-based timesheet tracking program
+// {{{
+// Purpose:	Writes the invoice for every project at once: for each card,
+//		the hours worked since its last invoice (or billed) line,
+//	as a LaTeX fragment of \Fee{period}{rate}{hours}{fee} lines, one per
+//	day, week, or month, the same lines byday -l and friends would write.
+//	Each fragment goes to its own file, named for the card.
+//
+//	With -b, each card that was invoiced is then marked as billed, by
+//	appending a "billed YYYY/MM/DD" line to it, so the next run starts
+//	from there.  The line is only appended if the card is just as it was
+//	when it was read.  A card that's been added to since--say, by a timer
+//	stopping while it was being read--is left alone, and reported, since
+//	marking it would bill hours that aren't on its invoice.
+//
+//	The cards are independent, so they're read several at a time, one
+//	per thread, each start to end.  Nothing's shared between the threads
+//	but the index of the next card to read.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2017-2024, Gisselquist Technology, LLC
+// {{{
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	GPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/gpl.html
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+__attribute__((unused))
+static const char *cpyright = "(C) 2024 Gisselquist Technology, LLC: " __FILE__;
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <atomic>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "timecard.h"
+#include "cardscan.h"
+#include "calbucket.h"
+#include "billing.h"
+#include "outbuf.h"
+#include "report.h"
+
+static	const	unsigned	MXTHREADS = 64;
+
+// The options, set once before any thread starts
+static	CALLEVEL	level = CB_DAY;
+static	bool		bill = false;
+static	const char	*outdir = ".";
+
+// One card's invoice, as worked out by whichever thread read it
+typedef	struct	{
+	std::string	m_fname;	// The card
+	std::string	m_stem;		// Its file name, sans directory or .ext
+	std::string	m_name;		// Its project
+	std::string	m_tex;		// Where its fragment was written
+	bool		m_ok;		// Read, and (if anything) written
+	bool		m_billed, m_changed;
+	unsigned long	m_units;	// Billed units, per BILLING
+	int64_t		m_cents;
+	time_t		m_first, m_last;
+} INVOICE;
+
+void	usage(void) {
+	// {{{
+	fprintf(stderr,
+"USAGE: tcinvoice [-b] [-d|-w|-m] [-j N] [-o dir] [timesheet.txt ...] [%%]\n"
+"\n"
+"\t-b\tMark each card invoiced as billed, as of today\n"
+"\t-d\tOne \\Fee line per day (the default)\n"
+"\t-w\tOne \\Fee line per week\n"
+"\t-m\tOne \\Fee line per month\n"
+"\t-j N\tRead at most N cards at once (default: one per CPU)\n"
+"\t-o dir\tWrite the fragments into dir, rather than the current directory\n"
+"\n"
+"Writes a LaTeX fragment invoicing the hours on each card since its last\n"
+"invoice or billed line, to dir/card.tex for a card named card.txt.  Cards\n"
+"with nothing yet to invoice get no fragment.  A %% stands for every card\n"
+"listed in ~/.xtimesheet.  With no cards given, all of those cards are\n"
+"invoiced.\n");
+}
+// }}}
+
+static	void	config(std::vector<std::string> &cards) {
+	// {{{
+	FILE	*fcfg;
+	char	*home, cfg_file[128], task_line[128], *cfg_task;
+
+	home = getenv("HOME");
+	if (NULL == home) {
+		fprintf(stderr, "No $HOME environment variable defined\n");
+		exit(EXIT_FAILURE);
+	}
+
+	strcpy(cfg_file, home);
+	strcat(cfg_file, "/.xtimesheet");
+	if (NULL != (fcfg = fopen(cfg_file, "r"))) {
+		while(fgets(task_line, sizeof(task_line), fcfg)) {
+			cfg_task = strtok(task_line, " \r\n");
+			if (cfg_task)
+				cards.push_back(cfg_task);
+		} fclose(fcfg);
+	}
+}
+// }}}
+
+static	char	*mkdate(char *ptr, time_t when) {
+	// {{{
+	struct	tm	datev;
+
+	// "%04d/%02d/%02d"
+	TIMECARD::localtime(when, datev);
+	ptr = OUTBUF::fixed(ptr, datev.tm_year+1900, 4);
+	*ptr++ = '/';
+	ptr = OUTBUF::fixed(ptr, datev.tm_mon+1, 2);
+	*ptr++ = '/';
+	ptr = OUTBUF::fixed(ptr, datev.tm_mday, 2);
+	*ptr = '\0';
+
+	return ptr;
+}
+// }}}
+
+// Writes the fragment to a temporary file, and renames it into place, so
+// that an older invoice is never left half overwritten
+static	bool	write(INVOICE &inv, const CALBUCKETS &cal) {
+	// {{{
+	std::string	tmp;
+	char		buf[64];
+	int		fd;
+	bool		ok;
+
+	inv.m_tex = outdir;
+	inv.m_tex += "/";
+	inv.m_tex += inv.m_stem;
+	inv.m_tex += ".tex";
+	tmp = inv.m_tex + ".XXXXXX";
+
+	fd = mkstemp(&tmp[0]);
+	if (fd < 0) {
+		fprintf(stderr, "ERR: Cannot create %s\n", tmp.c_str());
+		return false;
+	}
+
+	{
+		OUTBUF	out(fd);
+
+		out.put("% Project: ");
+		out.put(inv.m_name.c_str());
+		out.put("\n% Card: ");
+		out.put(inv.m_fname.c_str());
+		out.put("\n% From ");
+		out.put(buf, mkdate(buf, inv.m_first) - buf);
+		out.put(" through ");
+		out.put(buf, mkdate(buf, inv.m_last) - buf);
+		out.put('\n');
+
+		for(unsigned k=0; k<cal.size(level); k++) {
+			const CALBUCKET	&b = cal.bucket(level, k);
+
+			if (b.m_units > 0)
+				ROLLREPORT::fee(out, level, b, b.m_units);
+		}
+
+		// "%% Total: %.1f hours, $%.2f"
+		out.put("% Total: ");
+		out.put_tenths(BILLING::ROUNDING::tenths(inv.m_units));
+		out.put(" hours, $");
+		out.put_cents(inv.m_cents);
+		out.put('\n');
+		out.flush();
+		ok = !out.error();
+	}
+
+	if (0 != close(fd))
+		ok = false;
+	if (ok && 0 != rename(tmp.c_str(), inv.m_tex.c_str()))
+		ok = false;
+	if (!ok) {
+		fprintf(stderr, "ERR: Cannot write %s\n", inv.m_tex.c_str());
+		unlink(tmp.c_str());
+	}
+
+	return ok;
+}
+// }}}
+
+// Appends "billed YYYY/MM/DD" to a card of size bytes, unless it's changed
+static	bool	markbilled(INVOICE &inv, off_t size) {
+	// {{{
+	char	rec[32], *ptr = rec, last = '\n';
+	int	fd;
+
+	// A card that doesn't end its last line would otherwise have the
+	// mark tacked onto the end of it
+	fd = open(inv.m_fname.c_str(), O_RDONLY|O_CLOEXEC);
+	if (fd >= 0) {
+		if (size > 0 && 1 != pread(fd, &last, 1, size-1))
+			last = '\n';
+		close(fd);
+	}
+
+	if (last != '\n')
+		*ptr++ = '\n';
+	strcpy(ptr, "billed ");
+	ptr = mkdate(ptr + 7, time(NULL));
+	*ptr++ = '\n';
+
+	if (!TIMECARD::append_if(inv.m_fname.c_str(), size, rec, ptr-rec,
+			inv.m_changed)) {
+		if (!inv.m_changed)
+			fprintf(stderr, "ERR: Cannot mark %s as billed\n",
+				inv.m_fname.c_str());
+		return false;
+	}
+
+	return inv.m_billed = true;
+}
+// }}}
+
+static	void	invoice(INVOICE &inv) {
+	// {{{
+	CARDSCAN	scan;
+	CARDEVENT	ev;
+	CALBUCKETS	*cal;
+	struct	stat	sb;
+	double		rate = 225.0;
+	bool		any = false;
+
+	inv.m_ok = false;
+	inv.m_billed = inv.m_changed = false;
+	inv.m_units = 0;
+	inv.m_cents = 0;
+	inv.m_name = inv.m_stem;
+
+	// The size is taken first.  Anything appended from here on is read,
+	// yet never billed.
+	if (0 != stat(inv.m_fname.c_str(), &sb)
+			|| !scan.open(inv.m_fname.c_str())) {
+		fprintf(stderr, "ERR: Cannot read %s\n", inv.m_fname.c_str());
+		return;
+	}
+
+	// Everything up to an invoice has been billed, so each invoice
+	// starts the calendar over.  The rate carries on past it.
+	cal = new CALBUCKETS;
+	cal->rate(rate);
+	while(scan.next(ev)) {
+		switch(ev.m_kind) {
+		case CE_PROJECT: {
+			const char	*name = &ev.m_line[8];
+			unsigned	len;
+
+			while(*name && isspace(*name))
+				name++;
+			len = strlen(name);
+			while(len > 0 && isspace(name[len-1]))
+				len--;
+			if (len > 0)
+				inv.m_name.assign(name, len);
+			} break;
+		case CE_RATE:
+			rate = ev.m_rate;
+			cal->rate(rate);
+			break;
+		case CE_INVOICE:
+			delete cal;
+			cal = new CALBUCKETS;
+			cal->rate(rate);
+			any = false;
+			break;
+		case CE_INTERVAL:
+			cal->add(ev.m_start, ev.m_stop);
+			if (!any || ev.m_start < inv.m_first)
+				inv.m_first = ev.m_start;
+			if (!any || ev.m_stop > inv.m_last)
+				inv.m_last = ev.m_stop;
+			any = true;
+			break;
+		default:	break;
+		}
+	} cal->close();
+
+	// Never invoice part of a card: what was cut off may be unbilled work
+	if (scan.error()) {
+		delete cal;
+		return;
+	}
+
+	for(unsigned k=0; k<cal->size(level); k++) {
+		const CALBUCKET	&b = cal->bucket(level, k);
+
+		if (b.m_units == 0)
+			continue;
+		inv.m_units += b.m_units;
+		inv.m_cents += CENTS::fee<BILLING::ROUNDING>(
+					CENTS::from(b.m_rate), b.m_units);
+	}
+
+	if (inv.m_units == 0)
+		inv.m_ok = true;
+	else if (write(inv, *cal)) {
+		inv.m_ok = true;
+		if (bill) {
+			if (!scan.isplain())
+				fprintf(stderr, "ERR: %s is not a plain text "
+					"card, and can't be marked as billed\n",
+					inv.m_fname.c_str());
+			else
+				markbilled(inv, sb.st_size);
+		}
+	}
+
+	delete cal;
+}
+// }}}
+
+static	void	worker(std::vector<INVOICE> *invs,
+			std::atomic<unsigned> *next) {
+	// {{{
+	unsigned	k;
+
+	while((k = (*next)++) < invs->size())
+		invoice((*invs)[k]);
+}
+// }}}
+
+int main(int argc, char **argv) {
+	std::vector<std::string>	cards;
+	std::vector<INVOICE>		invs;
+	std::vector<std::thread>	threads;
+	std::map<std::string, unsigned>	stems;
+	std::atomic<unsigned>		next(0);
+	unsigned	nthreads = std::thread::hardware_concurrency(),
+			nfailed = 0, ninvoiced = 0, nbilled = 0;
+	unsigned long	units = 0;
+	int64_t		cents = 0;
+	bool		any = false;
+
+	for(int argn=1; argn<argc; argn++) {
+		if (argv[argn][0] == '-' && argv[argn][1] && !argv[argn][2]) {
+			switch(argv[argn][1]) {
+			case 'b': bill  = true; break;
+			case 'd': level = CB_DAY; break;
+			case 'w': level = CB_WEEK; break;
+			case 'm': level = CB_MONTH; break;
+			case 'j':
+				if (argn+1 >= argc || atoi(argv[argn+1]) <= 0) {
+					usage();
+					exit(EXIT_FAILURE);
+				}
+				nthreads = atoi(argv[++argn]);
+				break;
+			case 'o':
+				if (argn+1 >= argc) {
+					usage();
+					exit(EXIT_FAILURE);
+				}
+				outdir = argv[++argn];
+				break;
+			default:
+				usage();
+				exit(EXIT_FAILURE);
+			}
+		} else {
+			any = true;
+			if (argv[argn][0] == '%')
+				config(cards);
+			else
+				cards.push_back(argv[argn]);
+		}
+	}
+
+	if (!any)
+		config(cards);
+
+	invs.resize(cards.size());
+	for(unsigned k=0; k<cards.size(); k++) {
+		const char	*fname = cards[k].c_str(), *base, *ext;
+
+		base = strrchr(fname, '/');
+		base = (base) ? base+1 : fname;
+		ext  = strchr(base, '.');
+		invs[k].m_fname = cards[k];
+		invs[k].m_stem.assign(base,
+			(ext) ? (size_t)(ext-base) : strlen(base));
+
+		// Two cards can't both be written to the same file
+		if (stems.count(invs[k].m_stem)) {
+			fprintf(stderr, "ERR: %s and %s would both be invoiced "
+				"in %s/%s.tex\n",
+				cards[stems[invs[k].m_stem]].c_str(), fname,
+				outdir, invs[k].m_stem.c_str());
+			exit(EXIT_FAILURE);
+		} stems[invs[k].m_stem] = k;
+	}
+
+	if (nthreads < 1)
+		nthreads = 1;
+	if (nthreads > MXTHREADS)
+		nthreads = MXTHREADS;
+	if (nthreads > invs.size())
+		nthreads = invs.size();
+
+	for(unsigned k=0; k<nthreads; k++)
+		threads.push_back(std::thread(worker, &invs, &next));
+	for(unsigned k=0; k<threads.size(); k++)
+		threads[k].join();
+
+	// One line per card, in the order given
+	for(unsigned k=0; k<invs.size(); k++) {
+		const INVOICE	&inv = invs[k];
+
+		if (!inv.m_ok) {
+			nfailed++;
+			continue;
+		} else if (inv.m_units == 0)
+			continue;
+
+		printf("%-20s %7.1f hours, $%10.2f -> %s%s\n",
+			inv.m_name.c_str(),
+			BILLING::ROUNDING::tenths(inv.m_units) / 10.0,
+			inv.m_cents / 100.0, inv.m_tex.c_str(),
+			(inv.m_billed) ? ", billed"
+			: (inv.m_changed) ? ", NOT billed: changed since read"
+			: "");
+		ninvoiced++;
+		if (inv.m_billed)
+			nbilled++;
+		else if (bill)
+			nfailed++;
+		units += inv.m_units;
+		cents += inv.m_cents;
+	}
+
+	printf("%u of %u cards invoiced%s: %.1f hours, $%.2f\n",
+		ninvoiced, (unsigned)invs.size(),
+		(!bill || ninvoiced == 0) ? ""
+			: ((nbilled == ninvoiced) ? ", and billed"
+			: ", not all billed"),
+		BILLING::ROUNDING::tenths(units) / 10.0, cents / 100.0);
+
+	return (nfailed > 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,441 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename:	sw/tclint.cpp
+//
+// Project:	Xtimesheet, a very simple text-based timesheet tracking program
+// {{{
+// Purpose:	Checks time cards for lines the other tools would stumble
+//		over, or quietly misread, and reports each by file and line
+//	number.
+//
+//	Errors are lines whose time is lost or wrong:
+//		- intervals that stop before they start,
+//		- dates or times out of range (2024/02/30, or 0975),
+//		- lines that begin with a date, but can't be read as any line
+//		  the tools know, and
+//		- \tHHMM -- HHMM lines with no date above them.
+//	Warnings are lines that are likely mistakes:
+//		- dates that go backwards, which defeats the tools that skip
+//		  to the end of a card,
+//		- Start lines never followed by their interval, from a timer
+//		  that was never stopped, or whose stop was never logged,
+//		- a second Project: line, and
+//		- a Rate: line replaced by another before any time was logged.
+//
+//	Lines are checked in a single pass, by hand, without the date
+//	conversions the other tools need, so checking is quick.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2017-2024, Gisselquist Technology, LLC
+// {{{
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	GPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/gpl.html
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+__attribute__((unused))
+static const char *cpyright = "(C) 2024 Gisselquist Technology, LLC: " __FILE__;
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <time.h>
+#include <string>
+#include <vector>
+
+#include "cardfile.h"
+#include "tcbfile.h"
+#include "tzone.h"
+
+static	const	unsigned	MXLEN = 4096;
+
+static	bool	quiet = false;		// -q, only the summary
+
+static	unsigned long	nlines = 0, nerrors = 0, nwarnings = 0;
+
+// Where a card's checks have gotten to
+typedef	struct	{
+	const char	*m_fname;
+	unsigned	m_lineno;
+	long		m_day;		// Of the last date, -1 before any
+	char		m_date[32];	// ... as YYYY/MM/DD
+	unsigned	m_dateline;
+	unsigned	m_project, m_rate;	// Lines, zero if none yet
+	bool		m_logged;		// Any time since m_rate?
+	long		m_startday;		// Of a Start, -1 if none open
+	unsigned	m_startsec, m_startline;
+} LINTSTATE;
+
+static	void	report(const LINTSTATE &st, unsigned lineno, bool error,
+			const char *msg) {
+	// {{{
+	if (error)
+		nerrors++;
+	else
+		nwarnings++;
+	if (!quiet)
+		printf("%s:%u: %s: %s\n", st.m_fname, lineno,
+			(error) ? "error" : "warning", msg);
+}
+// }}}
+
+static	inline	bool	digits(const char *str, int len) {
+	// {{{
+	for(int k=0; k<len; k++)
+		if (str[k] < '0' || str[k] > '9')
+			return false;
+	return true;
+}
+// }}}
+
+static	inline	unsigned	num2(const char *str) {
+	return (str[0]-'0')*10 + (str[1]-'0');
+}
+
+// Seconds since midnight of HHMMSS, or HHMM, or ~0u if out of range.  24:00
+// is allowed, as the end of a day.
+static	unsigned	clocksecs(const char *str, bool secs) {
+	// {{{
+	unsigned	hh = num2(str), mm = num2(&str[2]),
+			ss = (secs) ? num2(&str[4]) : 0;
+
+	if (mm > 59 || ss > 59 || hh > 24 || (hh == 24 && (mm|ss) != 0))
+		return ~0u;
+	return (hh*60 + mm)*60 + ss;
+}
+// }}}
+
+// The day number of YYYY?MM?DD, or -1 if it's no such day
+static	long	date(LINTSTATE &st, const char *str, bool slashes) {
+	// {{{
+	static const unsigned	mdays[12] = {
+		31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+	unsigned	year, mon, mday, o = (slashes) ? 1 : 0;
+
+	// Most lines are on the same day as the line above
+	if (slashes && st.m_day >= 0 && 0 == memcmp(str, st.m_date, 10))
+		return st.m_day;
+
+	year = num2(str)*100 + num2(&str[2]);
+	mon  = num2(&str[4+o]);
+	mday = num2(&str[6+2*o]);
+	if (mon < 1 || mon > 12 || mday < 1 || mday > mdays[mon-1])
+		return -1;
+	if (mon == 2 && mday == 29 && ((year % 4) != 0
+			|| ((year % 100) == 0 && (year % 400) != 0)))
+		return -1;
+
+	return TZONE::days_from_civil(year, mon, mday);
+}
+// }}}
+
+// A dated line: dates must not go backwards
+static	void	dated(LINTSTATE &st, long day, const char *str, bool slashes) {
+	// {{{
+	if (day < st.m_day) {
+		char	msg[80];
+
+		snprintf(msg, sizeof(msg), "Date goes backwards, from %.10s"
+			" on line %u", st.m_date, st.m_dateline);
+		report(st, st.m_lineno, false, msg);
+	}
+
+	if (slashes)
+		memcpy(st.m_date, str, 10);
+	else {
+		long		year;
+		unsigned	mon, mday;
+
+		TZONE::civil_from_days(day, year, mon, mday);
+		snprintf(st.m_date, sizeof(st.m_date), "%04ld/%02u/%02u",
+			year % 10000, mon, mday);
+	}
+	st.m_day = day;
+	st.m_dateline = st.m_lineno;
+}
+// }}}
+
+// An interval from start to stop, in seconds, on a day
+static	void	interval(LINTSTATE &st, long day, unsigned start, unsigned stop) {
+	// {{{
+	if (st.m_startday >= 0) {
+		// The interval a Start began, or something after it
+		if (day != st.m_startday || start != st.m_startsec)
+			report(st, st.m_startline, false,
+				"Start is never followed by its interval");
+		st.m_startday = -1;
+	}
+
+	if (stop < start)
+		report(st, st.m_lineno, true, "Interval stops before it starts");
+	st.m_logged = true;
+}
+// }}}
+
+static	void	lint_line(LINTSTATE &st, const char *line) {
+	// {{{
+	unsigned	start, stop;
+	long		day;
+
+	if (line[0] >= '0' && line[0] <= '9') {
+		// {{{
+		if (digits(line, 4) && line[4] == '/') {
+			// YYYY/MM/DD HHMMSS -- HHMMSS, or -- Start
+			if (!(digits(&line[5], 2) && line[7] == '/'
+				&& digits(&line[8], 2) && isspace(line[10])
+				&& digits(&line[11], 6) && isspace(line[17])
+				&& line[18] == '-' && line[19] == '-'
+				&& isspace(line[20]))) {
+				report(st, st.m_lineno, true, "Unreadable "
+					"interval, its time would be lost");
+				return;
+			}
+
+			if (0 > (day = date(st, line, true))) {
+				report(st, st.m_lineno, true, "No such date");
+				return;
+			}
+			dated(st, day, line, true);
+
+			if (~0u == (start = clocksecs(&line[11], true))) {
+				report(st, st.m_lineno, true, "No such time");
+			} else if (0 == strncasecmp(&line[21], "start", 5)) {
+				if (st.m_startday >= 0)
+					report(st, st.m_startline, false,
+						"Start is never followed by its "
+						"interval");
+				st.m_startday  = day;
+				st.m_startsec  = start;
+				st.m_startline = st.m_lineno;
+			} else if (!digits(&line[21], 6)) {
+				report(st, st.m_lineno, true, "Unreadable "
+					"interval, its time would be lost");
+			} else if (~0u == (stop = clocksecs(&line[21], true))) {
+				report(st, st.m_lineno, true, "No such time");
+			} else
+				interval(st, day, start, stop);
+		} else if (digits(line, 14) && isspace(line[14])
+				&& line[15] == '-' && line[16] == '-'
+				&& digits(&line[18], 6)) {
+			// YYYYMMDDHHMMSS -- HHMMSS
+			if (0 > (day = date(st, line, false))) {
+				report(st, st.m_lineno, true, "No such date");
+				return;
+			}
+			dated(st, day, line, false);
+
+			if (~0u == (start = clocksecs(&line[8], true))
+				|| ~0u == (stop = clocksecs(&line[18], true)))
+				report(st, st.m_lineno, true, "No such time");
+			else
+				interval(st, day, start, stop);
+		} else if (line[0] == '2' && line[1] == '0'
+				&& digits(line, 8)) {
+			// YYYYMMDD, a date for the \tHHMM -- HHMM lines below
+			if (0 > (day = date(st, line, false)))
+				report(st, st.m_lineno, true, "No such date");
+			else
+				dated(st, day, line, false);
+		}
+		// }}}
+	} else if (line[0] == '\t' && digits(&line[1], 4)) {
+		// {{{
+		// \tHHMM -- HHMM
+		if (!(isspace(line[5]) && line[6] == '-' && line[7] == '-'
+				&& isspace(line[8]) && digits(&line[9], 4))) {
+			report(st, st.m_lineno, true,
+				"Unreadable interval, its time would be lost");
+		} else if (st.m_day < 0) {
+			report(st, st.m_lineno, true,
+				"Interval has no date line above it");
+		} else if (~0u == (start = clocksecs(&line[1], false))
+				|| ~0u == (stop = clocksecs(&line[9], false))) {
+			report(st, st.m_lineno, true, "No such time");
+		} else
+			interval(st, st.m_day, start, stop);
+		// }}}
+	} else if (0 == strncasecmp(line, "project:", 8)) {
+		// {{{
+		if (st.m_project) {
+			char	msg[80];
+
+			snprintf(msg, sizeof(msg), "Second Project: line, "
+				"after line %u", st.m_project);
+			report(st, st.m_lineno, false, msg);
+		} else
+			st.m_project = st.m_lineno;
+		// }}}
+	} else if (0 == strncasecmp(line, "rate:", 5)) {
+		// {{{
+		char	*end;
+
+		strtod(&line[5], &end);
+		if (end == &line[5])
+			report(st, st.m_lineno, true, "Rate: has no number");
+		else if (st.m_rate && !st.m_logged) {
+			char	msg[80];
+
+			snprintf(msg, sizeof(msg), "Rate: replaces line %u "
+				"before any time was logged at it", st.m_rate);
+			report(st, st.m_lineno, false, msg);
+		}
+		st.m_rate = st.m_lineno;
+		st.m_logged = false;
+		// }}}
+	}
+}
+// }}}
+
+// Checks one card, returning false if it can't be read, or not all of it
+static	bool	lint(const char *fname, char *line) {
+	// {{{
+	CARDFILE	fp;
+	LINTSTATE	st;
+	bool		partial = false;
+
+	if (TCBREADER::istcb(fname)) {
+		// Checked as it was converted
+		if (!quiet)
+			printf("%s: Binary card, skipped\n", fname);
+		return true;
+	}
+
+	if (!fp.open(fname)) {
+		fprintf(stderr, "ERR: Cannot read %s\n", fname);
+		return false;
+	}
+
+	memset(&st, 0, sizeof(st));
+	st.m_fname = fname;
+	st.m_day = st.m_startday = -1;
+
+	while(fp.gets(line, MXLEN)) {
+		bool	whole = (NULL != strchr(line, '\n'));
+
+		// The rest of a line too long to read at once is passed by
+		if (!partial) {
+			st.m_lineno++;
+			lint_line(st, line);
+		}
+		partial = !whole;
+	}
+
+	// A Start still open at the end of the card may be a timer that's
+	// still running, so it isn't reported
+	nlines += st.m_lineno;
+	return !fp.error();
+}
+// }}}
+
+void	usage(void) {
+	// {{{
+	fprintf(stderr,
+"USAGE: tclint [-q] [-t] [-W] [timesheet.txt ...] [%%]\n"
+"\n"
+"\t-q\tOnly print the summary\n"
+"\t-t\tPrint how long the checks took, on stderr\n"
+"\t-W\tExit with a non-zero status on warnings, not just errors\n"
+"\n"
+"Reports lines in time cards that the other tools would skip, misread, or\n"
+"that are likely mistakes, each as file:line: error|warning: message.  A %%\n"
+"stands for every card listed in ~/.xtimesheet.  With no cards given, all\n"
+"of those cards are checked.  Compressed cards are checked as they are.\n");
+}
+// }}}
+
+static	void	config(std::vector<std::string> &cards) {
+	// {{{
+	FILE	*fcfg;
+	char	*home, cfg_file[128], task_line[128], *cfg_task;
+
+	home = getenv("HOME");
+	if (NULL == home) {
+		fprintf(stderr, "No $HOME environment variable defined\n");
+		exit(EXIT_FAILURE);
+	}
+
+	strcpy(cfg_file, home);
+	strcat(cfg_file, "/.xtimesheet");
+	if (NULL != (fcfg = fopen(cfg_file, "r"))) {
+		while(fgets(task_line, sizeof(task_line), fcfg)) {
+			cfg_task = strtok(task_line, " \r\n");
+			if (cfg_task)
+				cards.push_back(cfg_task);
+		} fclose(fcfg);
+	}
+}
+// }}}
+
+int main(int argc, char **argv) {
+	std::vector<std::string>	cards;
+	bool	timing = false, strict = false, any = false;
+	unsigned	nfailed = 0;
+	struct	timespec	t0, t1;
+	double	secs;
+	char	*line;
+
+	for(int argn=1; argn<argc; argn++) {
+		if (argv[argn][0] == '-' && argv[argn][1] && !argv[argn][2]) {
+			switch(argv[argn][1]) {
+			case 'q': quiet  = true; break;
+			case 't': timing = true; break;
+			case 'W': strict = true; break;
+			default:
+				usage();
+				exit(EXIT_FAILURE);
+			}
+		} else {
+			any = true;
+			if (argv[argn][0] == '%')
+				config(cards);
+			else
+				cards.push_back(argv[argn]);
+		}
+	}
+
+	if (!any)
+		config(cards);
+
+	line = new char[MXLEN];
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for(unsigned k=0; k<cards.size(); k++)
+		if (!lint(cards[k].c_str(), line))
+			nfailed++;
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	delete[] line;
+
+	printf("%u cards, %lu lines: %lu errors, %lu warnings\n",
+		(unsigned)cards.size(), nlines, nerrors, nwarnings);
+	if (timing) {
+		secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec)*1e-9;
+		fprintf(stderr, "%.3fs, %.2fM lines/s\n", secs,
+			(secs > 0) ? nlines / secs / 1e6 : 0.0);
+	}
+
+	if (nfailed > 0 || nerrors > 0 || (strict && nwarnings > 0))
+		return EXIT_FAILURE;
+	return EXIT_SUCCESS;
+}
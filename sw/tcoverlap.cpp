@@ -0,0 +1,202 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename:	sw/tcoverlap.cpp
+//
+// Project:	Xtimesheet, a very simple text-based timesheet tracking program
+// {{{
+// Purpose:	Finds time claimed twice: intervals, in the same card or in
+//		different cards, that cover the same wall-clock time.  This
+//	happens when a timer is left running in one xtimesheet while another
+//	is started elsewhere.
+//
+//	The cards are merged into one stream, ordered by start time.  A
+//	sweep across that stream keeps a heap of the intervals still open,
+//	ordered by when they stop.  Each new interval first retires every
+//	open interval that stopped before it began; anything left open
+//	overlaps it.  With k cards, and so (normally) at most k intervals
+//	open at once, this takes O(n log k) time.
+//
+//	Every overlap is reported with both files, both line numbers, and
+//	the time claimed twice.  The exit status is non-zero if any are
+//	found, so this may be used as a check before invoicing.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2017-2024, Gisselquist Technology, LLC
+// {{{
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	GPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/gpl.html
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+__attribute__((unused))
+static const char *cpyright = "(C) 2024 Gisselquist Technology, LLC: " __FILE__;
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+#include "timecard.h"
+#include "cardmerge.h"
+
+typedef	struct	OPENIVL_S {
+	time_t		m_start, m_stop;
+	unsigned	m_src, m_lineno;
+} OPENIVL;
+
+// std::push_heap() builds a max heap.  Reverse the test, so the interval
+// that stops first is on top.
+static	bool	stops_later(const OPENIVL &a, const OPENIVL &b) {
+	return a.m_stop > b.m_stop;
+}
+
+static	void	config(CARDMERGE &merge) {
+	// {{{
+	FILE	*fcfg;
+	char	*home, cfg_file[128], task_line[128], *cfg_task;
+
+	home = getenv("HOME");
+	if (NULL == home) {
+		fprintf(stderr, "No $HOME environment variable defined\n");
+		exit(EXIT_FAILURE);
+	}
+
+	strcpy(cfg_file, home);
+	strcat(cfg_file, "/.xtimesheet");
+	if (NULL != (fcfg = fopen(cfg_file, "r"))) {
+		while(fgets(task_line, sizeof(task_line), fcfg)) {
+			cfg_task = strtok(task_line, " \r\n");
+			if (cfg_task && !merge.add(cfg_task))
+				fprintf(stderr, "WARNING: Cannot open %s\n",
+					cfg_task);
+		} fclose(fcfg);
+	}
+}
+// }}}
+
+void	usage(void) {
+	// {{{
+	fprintf(stderr,
+"USAGE: tcoverlap [-q] [timesheet.txt ...] [%%]\n"
+"\n"
+"\t-q\tOnly print the summary\n"
+"\n"
+"Reports every pair of intervals that claim the same time, whether in one\n"
+"card or two.  A %% stands for every card listed in ~/.xtimesheet.  With\n"
+"no cards given, all of those cards are checked.  Exits with a non-zero\n"
+"status if any overlap is found.\n");
+}
+// }}}
+
+int main(int argc, char **argv) {
+	CARDMERGE	merge;
+	CARDEVENT	ev;
+	unsigned	src, noverlaps = 0;
+	unsigned long	nintervals = 0;
+	time_t		overlap_secs = 0;
+	bool		quiet = false, any = false;
+	std::vector<OPENIVL>	open;
+	std::vector<time_t>	last;
+
+	for(int argn=1; argn<argc; argn++) {
+		if (argv[argn][0] == '-') {
+			if (argv[argn][1] == 'q')
+				quiet = true;
+			else {
+				usage();
+				exit(EXIT_FAILURE);
+			}
+		} else {
+			any = true;
+			if (argv[argn][0] == '%')
+				config(merge);
+			else if (!merge.add(argv[argn]))
+				fprintf(stderr, "WARNING: Cannot open %s\n",
+					argv[argn]);
+		}
+	}
+
+	if (!any)
+		config(merge);
+
+	last.assign(merge.size(), 0);
+	while(merge.next(ev, src)) {
+		OPENIVL	ivl;
+
+		if (ev.m_kind != CE_INTERVAL)
+			continue;
+		nintervals++;
+
+		// The sweep depends upon each card being in time order
+		if (ev.m_start < last[src])
+			fprintf(stderr, "WARNING: %s:%u is out of order.  "
+				"Overlaps with it may be missed\n",
+				merge.fname(src), ev.m_lineno);
+		else
+			last[src] = ev.m_start;
+
+		// Retire everything that stopped before this began
+		while(!open.empty() && open[0].m_stop <= ev.m_start) {
+			std::pop_heap(open.begin(), open.end(), stops_later);
+			open.pop_back();
+		}
+
+		// Anything still open overlaps this interval
+		for(unsigned k=0; k<open.size(); k++) {
+			const OPENIVL	&o = open[k];
+			time_t		dup;
+
+			dup = ((o.m_stop < ev.m_stop) ? o.m_stop : ev.m_stop)
+				- ev.m_start;
+			noverlaps++;
+			overlap_secs += dup;
+
+			if (!quiet)
+				printf("%s:%u: overlaps %s:%u by "
+					"%ld:%02ld:%02ld\n",
+					merge.fname(src), ev.m_lineno,
+					merge.fname(o.m_src), o.m_lineno,
+					(long)(dup / 3600),
+					(long)((dup / 60) % 60),
+					(long)(dup % 60));
+		}
+
+		ivl.m_start  = ev.m_start;
+		ivl.m_stop   = ev.m_stop;
+		ivl.m_src    = src;
+		ivl.m_lineno = ev.m_lineno;
+		open.push_back(ivl);
+		std::push_heap(open.begin(), open.end(), stops_later);
+	}
+
+	printf("%u overlap%s among %lu intervals in %u card%s, "
+		"%.1f hours claimed twice\n",
+		noverlaps, (noverlaps == 1) ? "" : "s", nintervals,
+		merge.size(), (merge.size() == 1) ? "" : "s",
+		overlap_secs / 3600.0);
+
+	return (noverlaps > 0 || merge.nfailed() > 0)
+		? EXIT_FAILURE : EXIT_SUCCESS;
+}
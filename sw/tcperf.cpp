@@ -0,0 +1,803 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename:	sw/tcperf.cpp
+//
+// Project:	Xtimesheet, a very simple text-based timesheet tracking program
+// {{{
+// Purpose:	Behind make perf.  Builds a fixed set of synthetic time cards,
+//		then runs the command line tools on them, end to end, as a
+//	user would.  Each run's wall time, peak RSS, and count of system calls
+//	is compared against a stored baseline.  A peak RSS or system call
+//	count that's grown by more than a tolerance is a regression.  Those
+//	two come out the same run after run, on any machine that's not been
+//	changed.  Wall time doesn't, so it's reported, but never fails a run.
+//
+//	The corpus is the same, byte for byte, every time it's built: one
+//	huge card, compressed copies of it, and 500 smaller cards listed in
+//	a ~/.xtimesheet of its own.  Every date is fixed, and the tools are
+//	given the dates to report on, so nothing depends on today's date.
+//
+//	Each test is run once to warm the cache, then timed several times,
+//	keeping the fastest: noise only ever adds time.  System calls are
+//	counted on one more run, under ptrace(), since tracing slows a run too
+//	much to time it.  brk(), mmap() and the like aren't counted.  How
+//	often malloc() asks for memory turns on the length of every path it
+//	copies, and so on where the tree happens to be checked out.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2017-2024, Gisselquist Technology, LLC
+// {{{
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	GPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/gpl.html
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+__attribute__((unused))
+static const char *cpyright = "(C) 2024 Gisselquist Technology, LLC: " __FILE__;
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <math.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ptrace.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <zlib.h>
+#ifdef	HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "tzone.h"
+
+// Bump this whenever the corpus changes, so old corpora are built again
+static	const	char	CORPUS_STAMP[] = "tcperf corpus 2";
+
+// Every card ends on this (Friday) date.  The tools are asked about its
+// week and month.
+static	const	long	LAST_YEAR = 2024;
+static	const	unsigned LAST_MONTH = 6, LAST_MDAY = 28;
+static	const	unsigned NCARDS = 500;
+
+// Differences smaller than these are noise, whatever the tolerance
+static	const	double	SLACK_MS = 2.0;
+static	const	long	SLACK_KB = 256;
+static	const	long	SLACK_CALLS = 8;
+
+typedef	struct	{
+	double	m_wall_ms;	// Fastest
+	long	m_maxrss_kb;	// Largest
+	long	m_syscalls;	// -1 if they couldn't be counted
+} PERFRESULT;
+
+typedef	std::map<std::string, PERFRESULT>	PERFSET;
+
+// The corpus
+// {{{
+
+// A fixed sequence of pseudo-random numbers (xorshift64)
+static	unsigned long	rng_state = 0x9e3779b97f4a7c15ul;
+
+static	unsigned	rnd(unsigned n) {
+	// {{{
+	rng_state ^= rng_state << 13;
+	rng_state ^= rng_state >> 7;
+	rng_state ^= rng_state << 17;
+	return (unsigned)(rng_state >> 32) % n;
+}
+// }}}
+
+// Writes one card covering [firstday, lastday], days counted from 1970/01/01.
+// A day is worked with odds of pct in 100, in between lo and hi intervals
+// spread over 0600 to midnight.  Invoices go out about every ninety days.
+static	void	gen_card(FILE *fp, const char *project, unsigned rate,
+			long firstday, long lastday, unsigned pct,
+			unsigned lo, unsigned hi) {
+	// {{{
+	long		next_invoice = firstday + 90;
+
+	fprintf(fp, "Project: %s\nRate: %u.00\n\n", project, rate);
+	for(long day = firstday; day <= lastday; day++) {
+		long		year;
+		unsigned	mon, mday, n, slot;
+
+		if (rnd(100) >= pct)
+			continue;
+
+		TZONE::civil_from_days(day, year, mon, mday);
+		if (day >= next_invoice) {
+			fprintf(fp, "Invoice %04ld/%02u/%02u\n", year, mon, mday);
+			next_invoice = day + 80 + rnd(20);
+		}
+
+		n = lo + rnd(hi-lo+1);
+		slot = 18*3600 / n;
+		for(unsigned k=0; k<n; k++) {
+			unsigned	start, len;
+
+			start = 6*3600 + k*slot + rnd(slot/4+1);
+			len   = 60 + rnd(slot/2);
+
+			fprintf(fp, "%04ld/%02u/%02u %02u%02u%02u -- %02u%02u%02u (%4.1f)\n",
+				year, mon, mday,
+				start/3600, (start/60)%60, start%60,
+				(start+len)/3600, ((start+len)/60)%60,
+				(start+len)%60, len / 3600.0);
+		}
+	}
+}
+// }}}
+
+static	bool	read_file(const char *fname, std::string &data) {
+	// {{{
+	FILE	*fp;
+	char	buf[65536];
+	size_t	nr;
+
+	data.clear();
+	if (NULL == (fp = fopen(fname, "r")))
+		return false;
+	while((nr = fread(buf, 1, sizeof(buf), fp)) > 0)
+		data.append(buf, nr);
+	fclose(fp);
+	return true;
+}
+// }}}
+
+static	bool	write_file(const char *fname, const void *data, size_t len) {
+	// {{{
+	FILE	*fp;
+	bool	ok;
+
+	if (NULL == (fp = fopen(fname, "w")))
+		return false;
+	ok = (len == fwrite(data, 1, len, fp));
+	return (0 == fclose(fp)) && ok;
+}
+// }}}
+
+static	bool	compress(const char *src) {
+	// {{{
+	std::string	data, fname;
+	gzFile		gz;
+
+	if (!read_file(src, data))
+		return false;
+
+	fname = std::string(src) + ".gz";
+	if (NULL == (gz = gzopen(fname.c_str(), "wb6")))
+		return false;
+	if ((int)data.size() != gzwrite(gz, data.data(), data.size())) {
+		gzclose(gz);
+		return false;
+	} if (Z_OK != gzclose(gz))
+		return false;
+
+#ifdef	HAVE_ZSTD
+	{
+		std::vector<char>	zbuf(ZSTD_compressBound(data.size()));
+		size_t	zlen;
+
+		zlen = ZSTD_compress(zbuf.data(), zbuf.size(),
+					data.data(), data.size(), 3);
+		if (ZSTD_isError(zlen))
+			return false;
+		fname = std::string(src) + ".zst";
+		if (!write_file(fname.c_str(), zbuf.data(), zlen))
+			return false;
+	}
+#endif
+	return true;
+}
+// }}}
+
+// Builds the corpus within dir, unless it's already there.  Only the scale
+// changes it.
+static	bool	build_corpus(const char *dir, unsigned scale) {
+	// {{{
+	char		stamp[64], fname[PATH_MAX], project[64];
+	std::string	old;
+	FILE		*fp, *fcfg;
+	long		last = TZONE::days_from_civil(LAST_YEAR, LAST_MONTH,
+						LAST_MDAY);
+
+	snprintf(stamp, sizeof(stamp), "%s, scale %u\n", CORPUS_STAMP, scale);
+	snprintf(fname, sizeof(fname), "%s/corpus.stamp", dir);
+	if (read_file(fname, old) && old == stamp)
+		return true;
+
+	printf("Building the corpus in %s\n", dir);
+	snprintf(fname, sizeof(fname), "%s/cards", dir);
+	if ((0 != mkdir(dir, 0755) && errno != EEXIST)
+		|| (0 != mkdir(fname, 0755) && errno != EEXIST)) {
+		fprintf(stderr, "ERR: Cannot make %s\n", fname);
+		return false;
+	}
+
+	// One huge card: thirty-five years, worked most days, many times a day
+	snprintf(fname, sizeof(fname), "%s/huge.txt", dir);
+	if (NULL == (fp = fopen(fname, "w"))) {
+		fprintf(stderr, "ERR: Cannot write %s\n", fname);
+		return false;
+	}
+	gen_card(fp, "Huge project", 150,
+		TZONE::days_from_civil(1990, 1, 1), last, 72,
+		8*scale, 16*scale);
+	fclose(fp);
+
+	if (!compress(fname)) {
+		fprintf(stderr, "ERR: Cannot compress %s\n", fname);
+		return false;
+	}
+
+	// Many small cards, listed in a ~/.xtimesheet.  Every fiftieth card
+	// is too large to be read with the others, and spans a decade.  The
+	// tools are run from within the corpus, so the list's paths are
+	// relative to it, and the same wherever it's built.
+	snprintf(fname, sizeof(fname), "%s/.xtimesheet", dir);
+	if (NULL == (fcfg = fopen(fname, "w"))) {
+		fprintf(stderr, "ERR: Cannot write %s\n", fname);
+		return false;
+	}
+	for(unsigned k=0; k<NCARDS; k++) {
+		long	end = last - ((k % 3 == 0) ? 0 : rnd(900)),
+			span = (k % 50 == 0) ? 3650 : 365 + rnd(730);
+
+		snprintf(fname, sizeof(fname), "%s/cards/p%03u.txt", dir, k);
+		if (NULL == (fp = fopen(fname, "w"))) {
+			fprintf(stderr, "ERR: Cannot write %s\n", fname);
+			fclose(fcfg);
+			return false;
+		}
+		snprintf(project, sizeof(project), "Project %03u", k);
+		gen_card(fp, project, 50 + rnd(200), end - span, end,
+			(k % 50 == 0) ? 70 : 25, scale, 3*scale);
+		fclose(fp);
+
+		fprintf(fcfg, "cards/p%03u.txt\n", k);
+	}
+	fclose(fcfg);
+
+	snprintf(fname, sizeof(fname), "%s/corpus.stamp", dir);
+	return write_file(fname, stamp, strlen(stamp));
+}
+// }}}
+// }}}
+
+// Running a test
+// {{{
+
+// Starts argv[0] from bindir within the corpus, with its output thrown away.
+// With trace set, the child stops for ptrace() once it's exec'd.
+static	pid_t	launch(const char *bindir, const char *dir,
+			const std::vector<std::string> &args, bool trace) {
+	// {{{
+	pid_t	pid;
+
+	if (0 == (pid = fork())) {
+		std::vector<char *>	argv;
+		std::string		path = std::string(bindir) + "/" + args[0];
+		int			fd;
+
+		for(unsigned k=0; k<args.size(); k++)
+			argv.push_back((char *)args[k].c_str());
+		argv.push_back(NULL);
+
+		if (0 != chdir(dir))
+			_exit(127);
+		setenv("HOME", ".", 1);
+		if (0 <= (fd = open("/dev/null", O_WRONLY))) {
+			dup2(fd, STDOUT_FILENO);
+			dup2(fd, STDERR_FILENO);
+			close(fd);
+		}
+		if (trace)
+			ptrace(PTRACE_TRACEME, 0, NULL, NULL);
+		execv(path.c_str(), argv.data());
+		_exit(127);
+	}
+
+	return pid;
+}
+// }}}
+
+// One run, timed.  Returns false if the tool failed.
+static	bool	timed(const char *bindir, const char *dir,
+			const std::vector<std::string> &args,
+			double &wall_ms, long &maxrss_kb) {
+	// {{{
+	struct	timespec	t0, t1;
+	struct	rusage		ru;
+	int	status;
+	pid_t	pid;
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	if (0 > (pid = launch(bindir, dir, args, false)))
+		return false;
+	if (pid != wait4(pid, &status, 0, &ru))
+		return false;
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	wall_ms = (t1.tv_sec - t0.tv_sec) * 1e3
+			+ (t1.tv_nsec - t0.tv_nsec) / 1e6;
+	maxrss_kb = ru.ru_maxrss;
+	return WIFEXITED(status) && 0 == WEXITSTATUS(status);
+}
+// }}}
+
+// Calls that only hand memory to malloc(), and so aren't counted
+static	bool	memcall(pid_t tid) {
+	// {{{
+	struct	__ptrace_syscall_info	info;
+
+	if (0 >= ptrace(PTRACE_GET_SYSCALL_INFO, tid,
+			(void *)sizeof(info), &info)
+			|| info.op != PTRACE_SYSCALL_INFO_ENTRY)
+		return false;
+
+	switch(info.entry.nr) {
+	case SYS_brk: case SYS_mmap: case SYS_munmap: case SYS_mremap:
+		return true;
+	default:
+		return false;
+	}
+}
+// }}}
+
+// One run, under ptrace(), counting system calls made by every thread,
+// but for memcall()s.  Returns -1 if they can't be counted.
+static	long	syscalls(const char *bindir, const char *dir,
+			const std::vector<std::string> &args) {
+	// {{{
+	std::map<pid_t, bool>	insys;	// Within a call, by thread
+	long	count = 0;
+	int	status;
+	pid_t	pid, tid;
+
+	if (0 > (pid = launch(bindir, dir, args, true)))
+		return -1;
+
+	// The first stop is at the exec
+	if (pid != waitpid(pid, &status, 0) || !WIFSTOPPED(status)) {
+		kill(pid, SIGKILL);
+		waitpid(pid, &status, 0);
+		return -1;
+	}
+	if (0 != ptrace(PTRACE_SETOPTIONS, pid, NULL, (void *)(long)
+			(PTRACE_O_TRACESYSGOOD | PTRACE_O_TRACECLONE
+			| PTRACE_O_EXITKILL))
+		|| 0 != ptrace(PTRACE_SYSCALL, pid, NULL, NULL)) {
+		kill(pid, SIGKILL);
+		waitpid(pid, &status, 0);
+		return -1;
+	}
+
+	while(0 < (tid = waitpid(-1, &status, __WALL))) {
+		int	sig = 0;
+
+		if (WIFEXITED(status) || WIFSIGNALED(status)) {
+			insys.erase(tid);
+			continue;
+		} else if (!WIFSTOPPED(status))
+			continue;
+
+		if (WSTOPSIG(status) == (SIGTRAP | 0x80)) {
+			// Stops come in pairs, on the way in and out
+			bool	&in = insys[tid];
+
+			if (!in && !memcall(tid))
+				count++;
+			in = !in;
+		} else if (WSTOPSIG(status) == SIGTRAP || (WSTOPSIG(status)
+				== SIGSTOP && insys.find(tid) == insys.end())) {
+			// A clone event, or a new thread's first stop
+		} else
+			sig = WSTOPSIG(status);
+
+		ptrace(PTRACE_SYSCALL, tid, NULL, (void *)(long)sig);
+	}
+
+	return count;
+}
+// }}}
+
+// Times reps runs, keeping the fastest, and folds them into r.  Returns false
+// if the tool failed.
+static	bool	retime(const char *bindir, const char *dir,
+			const std::vector<std::string> &args,
+			unsigned reps, PERFRESULT &r) {
+	// {{{
+	double	ms;
+	long	kb;
+
+	for(unsigned k=0; k<reps; k++) {
+		if (!timed(bindir, dir, args, ms, kb))
+			return false;
+		r.m_wall_ms   = std::min(r.m_wall_ms, ms);
+		r.m_maxrss_kb = std::max(r.m_maxrss_kb, kb);
+	}
+
+	return true;
+}
+// }}}
+
+// Runs one test: a warm up, reps timed runs, and a traced run.  Returns
+// false if the tool failed.
+static	bool	measure(const char *bindir, const char *dir,
+			const std::vector<std::string> &args,
+			unsigned reps, PERFRESULT &r) {
+	// {{{
+	double	ms;
+	long	kb;
+
+	r.m_wall_ms   = HUGE_VAL;
+	r.m_maxrss_kb = 0;
+	if (!timed(bindir, dir, args, ms, kb)
+			|| !retime(bindir, dir, args, reps, r))
+		return false;
+
+	r.m_syscalls = syscalls(bindir, dir, args);
+	return true;
+}
+// }}}
+// }}}
+
+// Baselines
+// {{{
+
+// Writes results as JSON:
+//	{ "scale": N, "tests": { "name": { "wall_ms": ... }, ... } }
+static	bool	write_json(const char *fname, unsigned scale,
+			const PERFSET &results) {
+	// {{{
+	FILE	*fp;
+
+	if (NULL == (fp = fopen(fname, "w")))
+		return false;
+
+	fprintf(fp, "{\n\t\"scale\": %u,\n\t\"tests\": {", scale);
+	for(PERFSET::const_iterator p = results.begin(); p != results.end();
+			p++) {
+		fprintf(fp, "%s\n\t\t\"%s\": { \"wall_ms\": %.3f, "
+			"\"maxrss_kb\": %ld, \"syscalls\": %ld }",
+			(p == results.begin()) ? "" : ",",
+			p->first.c_str(), p->second.m_wall_ms,
+			p->second.m_maxrss_kb, p->second.m_syscalls);
+	}
+	fprintf(fp, "\n\t}\n}\n");
+
+	return 0 == fclose(fp);
+}
+// }}}
+
+// A reader for just what write_json() writes
+class	JSONREADER {
+	const char	*m_ptr;
+public:
+	JSONREADER(const char *str) : m_ptr(str) {}
+
+	void	skip(void) {
+		while(*m_ptr && isspace(*m_ptr))
+			m_ptr++;
+	}
+
+	bool	expect(char ch) {
+		skip();
+		if (*m_ptr != ch)
+			return false;
+		m_ptr++;
+		return true;
+	}
+
+	bool	peek(char ch) {
+		skip();
+		return *m_ptr == ch;
+	}
+
+	bool	string(std::string &str) {
+		const char	*end;
+
+		if (!expect('"') || NULL == (end = strchr(m_ptr, '"')))
+			return false;
+		str.assign(m_ptr, end-m_ptr);
+		m_ptr = end+1;
+		return true;
+	}
+
+	bool	number(double &v) {
+		char	*end;
+
+		skip();
+		v = strtod(m_ptr, &end);
+		if (end == m_ptr)
+			return false;
+		m_ptr = end;
+		return true;
+	}
+};
+
+static	bool	read_json(const char *fname, unsigned &scale, PERFSET &results) {
+	// {{{
+	std::string	data, key;
+	double		v;
+
+	if (!read_file(fname, data))
+		return false;
+
+	JSONREADER	js(data.c_str());
+
+	scale = 0;
+	if (!js.expect('{'))
+		return false;
+	do {
+		if (!js.string(key) || !js.expect(':'))
+			return false;
+		if (key == "scale") {
+			if (!js.number(v))
+				return false;
+			scale = (unsigned)v;
+		} else if (key == "tests") {
+			if (!js.expect('{'))
+				return false;
+			while(!js.peek('}')) {
+				std::string	name;
+				PERFRESULT	r = { 0, 0, -1 };
+
+				if (!js.string(name) || !js.expect(':')
+						|| !js.expect('{'))
+					return false;
+				do {
+					if (!js.string(key) || !js.expect(':')
+							|| !js.number(v))
+						return false;
+					if (key == "wall_ms")
+						r.m_wall_ms = v;
+					else if (key == "maxrss_kb")
+						r.m_maxrss_kb = (long)v;
+					else if (key == "syscalls")
+						r.m_syscalls = (long)v;
+				} while(js.expect(','));
+				if (!js.expect('}'))
+					return false;
+				results[name] = r;
+				js.expect(',');
+			}
+			js.expect('}');
+		} else
+			return false;
+	} while(js.expect(','));
+
+	return js.expect('}');
+}
+// }}}
+
+// Has a measure grown by more than the tolerance (in percent), and the slack?
+static	bool	worse(double now, double base, double tol, double slack) {
+	return now > base * (1.0 + tol/100.0) + slack;
+}
+// }}}
+
+void	usage(void) {
+	// {{{
+	fprintf(stderr,
+"USAGE: tcperf [-d dir] [-b baseline.json] [-w results.json] [-t pct] [-n reps]\n"
+"\t\t[-s scale] bindir\n"
+"\n"
+"\t-d dir\tWhere to build the corpus.  It's only built once.  [perf]\n"
+"\t-b file\tCompare against this baseline, and exit with a non-zero\n"
+"\t\tstatus on any regression\n"
+"\t-w file\tWrite these results out, as a new baseline\n"
+"\t-t pct\tHow much peak RSS or system calls may grow before it's a\n"
+"\t\tregression.  Wall time is only reported.  [20]\n"
+"\t-n reps\tTimed runs per test, after one to warm up.  [5]\n"
+"\t-s scale\tMultiplies the intervals per day in the corpus.  [1]\n"
+"\n"
+"Times thisweek, thismonth, totalhrs, byday, bymonth, tc, and xtimesheet\n"
+"--reload, as found in bindir, on a synthetic corpus.  Tools that haven't\n"
+"been built are skipped.\n");
+}
+// }}}
+
+int main(int argc, char **argv) {
+	const char	*dir = "perf", *bindir = NULL,
+			*basefile = NULL, *outfile = NULL;
+	char		fullbin[PATH_MAX];
+	double		tol = 20.0;
+	unsigned	reps = 5, scale = 1, bscale = 0, nregress = 0, nfail = 0;
+	PERFSET		results, baseline;
+	std::vector<std::string>	allcards;
+	typedef	std::pair<std::string, std::vector<std::string> >	PERFTEST;
+	std::vector<PERFTEST>	tests;
+
+	for(int argn=1; argn<argc; argn++) {
+		if (argv[argn][0] == '-' && argv[argn][1] && !argv[argn][2]
+				&& argn+1 < argc) {
+			switch(argv[argn][1]) {
+			case 'd': dir      = argv[++argn]; break;
+			case 'b': basefile = argv[++argn]; break;
+			case 'w': outfile  = argv[++argn]; break;
+			case 't': tol   = atof(argv[++argn]); break;
+			case 'n': reps  = atoi(argv[++argn]); break;
+			case 's': scale = atoi(argv[++argn]); break;
+			default:
+				usage();
+				exit(EXIT_FAILURE);
+			}
+		} else if (NULL == bindir && argv[argn][0] != '-')
+			bindir = argv[argn];
+		else {
+			usage();
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	if (NULL == bindir || reps < 1 || scale < 1 || tol < 0) {
+		usage();
+		exit(EXIT_FAILURE);
+	}
+
+	// The tools are run from within the corpus
+	if (NULL == realpath(bindir, fullbin)) {
+		fprintf(stderr, "ERR: Cannot find %s\n", bindir);
+		exit(EXIT_FAILURE);
+	} bindir = fullbin;
+
+	if (basefile && !read_json(basefile, bscale, baseline)) {
+		fprintf(stderr, "ERR: Cannot read the baseline, %s\n", basefile);
+		exit(EXIT_FAILURE);
+	} else if (basefile && bscale != scale) {
+		fprintf(stderr, "ERR: %s was measured at scale %u, not %u\n",
+			basefile, bscale, scale);
+		exit(EXIT_FAILURE);
+	}
+
+	if (!build_corpus(dir, scale))
+		exit(EXIT_FAILURE);
+
+	// The tests, each a name and a command line
+	// {{{
+	tests.push_back(PERFTEST("thisweek-huge",
+				{ "thisweek", "20240626", "huge.txt" }));
+	tests.push_back(PERFTEST("thisweek-all",
+				{ "thisweek", "20240626", "%" }));
+	tests.push_back(PERFTEST("thismonth-huge",
+				{ "thismonth", "202406", "huge.txt" }));
+	tests.push_back(PERFTEST("thismonth-all",
+				{ "thismonth", "202406", "%" }));
+	tests.push_back(PERFTEST("totalhrs-huge", { "totalhrs", "huge.txt" }));
+	tests.push_back(PERFTEST("totalhrs-all", { "totalhrs", "%" }));
+	tests.push_back(PERFTEST("byday-huge", { "byday", "huge.txt" }));
+	tests.push_back(PERFTEST("byday-gz", { "byday", "huge.txt.gz" }));
+	tests.push_back(PERFTEST("bymonth-huge", { "bymonth", "huge.txt" }));
+#ifdef	HAVE_ZSTD
+	tests.push_back(PERFTEST("bymonth-zst", { "bymonth", "huge.txt.zst" }));
+#endif
+	allcards.push_back("bymonth");
+	for(unsigned k=0; k<NCARDS; k++) {
+		char	fname[32];
+
+		snprintf(fname, sizeof(fname), "cards/p%03u.txt", k);
+		allcards.push_back(fname);
+	}
+	tests.push_back(PERFTEST("bymonth-all", allcards));
+	tests.push_back(PERFTEST("tc-dashboard", { "tc", "week=20240626",
+			"month=202406", "total", "bymonth", "--", "%" }));
+	tests.push_back(PERFTEST("xtimesheet-reload",
+				{ "xtimesheet", "--reload", "huge.txt" }));
+	// }}}
+
+	printf("%-18s %10s %10s %10s %10s %10s %10s\n", "Test",
+		"Wall(ms)", "Base", "RSS(kB)", "Base", "Syscalls", "Base");
+	for(unsigned k=0; k<tests.size(); k++) {
+		const std::string	&name = tests[k].first;
+		std::string	path = std::string(bindir) + "/"
+					+ tests[k].second[0];
+		PERFSET::const_iterator	b = baseline.find(name);
+		PERFRESULT	r;
+		bool		slow, fat, chatty;
+
+		if (0 != access(path.c_str(), X_OK)) {
+			printf("%-18s (skipped, no %s)\n", name.c_str(),
+				path.c_str());
+			continue;
+		}
+
+		if (!measure(bindir, dir, tests[k].second, reps, r)) {
+			printf("%-18s FAILED\n", name.c_str());
+			nfail++;
+			continue;
+		}
+
+		if (b != baseline.end()) {
+			// Noted, but not counted: a busy machine slows a run
+			// as much as any change to the tools
+			slow = worse(r.m_wall_ms, b->second.m_wall_ms, tol,
+					SLACK_MS);
+			fat  = worse(r.m_maxrss_kb, b->second.m_maxrss_kb, tol,
+					SLACK_KB);
+			chatty = r.m_syscalls >= 0 && b->second.m_syscalls >= 0
+				&& worse(r.m_syscalls, b->second.m_syscalls,
+					tol, SLACK_CALLS);
+		} else
+			slow = fat = chatty = false;
+		results[name] = r;
+
+		printf("%-18s %10.1f", name.c_str(), r.m_wall_ms);
+		if (b != baseline.end())
+			printf(" %10.1f", b->second.m_wall_ms);
+		else
+			printf(" %10s", "-");
+		printf(" %10ld", r.m_maxrss_kb);
+		if (b != baseline.end())
+			printf(" %10ld", b->second.m_maxrss_kb);
+		else
+			printf(" %10s", "-");
+		printf(" %10ld", r.m_syscalls);
+		if (b != baseline.end())
+			printf(" %10ld", b->second.m_syscalls);
+		else
+			printf(" %10s", "-");
+
+		if (b == baseline.end()) {
+			printf("%s\n", (basefile) ? "  (new)" : "");
+		} else if (fat || chatty) {
+			printf("  REGRESSION:%s%s%s\n",
+				(fat) ? " memory" : "",
+				(chatty) ? " syscalls" : "",
+				(slow) ? ", and slower" : "");
+			nregress++;
+		} else
+			printf("%s\n", (slow) ? "  (slower)" : "");
+	}
+
+	if (outfile) {
+		if (!write_json(outfile, scale, results)) {
+			fprintf(stderr, "ERR: Cannot write %s\n", outfile);
+			exit(EXIT_FAILURE);
+		}
+		printf("Results written to %s\n", outfile);
+	}
+
+	if (nfail > 0 || nregress > 0) {
+		printf("%u failed, %u regressed beyond %.0f%%\n", nfail,
+			nregress, tol);
+		exit(EXIT_FAILURE);
+	}
+	if (basefile)
+		printf("No regressions beyond %.0f%%\n", tol);
+	return EXIT_SUCCESS;
+}
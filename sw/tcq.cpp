@@ -0,0 +1,1308 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename:	sw/tcq.cpp
+//
+// Project:	Xtimesheet, a very simple text-based timesheet tracking program
+// {{{
+// Purpose:	Ad-hoc questions about time cards, asked in a small query
+//		language rather than by writing another program.  Every
+//	interval of every card is read once into a table, a column at a time.
+//	The query is then compiled into a plan: a list of filters, each run
+//	over a batch of rows at a time, narrowing a selection vector, followed
+//	by grouping keys computed a batch at a time, and an aggregate.
+//	Batches whose dates can't pass the date filter are skipped outright.
+//
+//	Hours are as worked, before billing's rounding.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2017-2024, Gisselquist Technology, LLC
+// {{{
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	GPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/gpl.html
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+__attribute__((unused))
+static const char *cpyright = "(C) 2024 Gisselquist Technology, LLC: " __FILE__;
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "timecard.h"
+#include "tzone.h"
+#include "cardscan.h"
+#include "cardbatch.h"
+#include "histpyr.h"
+#include "strtab.h"
+#include "outbuf.h"
+
+// Cards from ~/.xtimesheet no larger than this are all read at once, and
+// parsed from memory
+static	const	size_t	BATCHLIMIT = 256*1024;
+
+static const char	*daystr[] = {
+	"Sunday", "Monday", "Tuesday", "Wednesday",
+	"Thursday", "Friday", "Saturday"
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// The table: every interval, a column at a time
+// {{{
+////////////////////////////////////////////////////////////////////////////////
+//
+class	TCTABLE {
+public:
+	static const unsigned	BATCH = 1024;
+
+	std::vector<int64_t>	m_start;
+	std::vector<int32_t>	m_secs, m_day;
+	std::vector<uint32_t>	m_project;	// An id in m_names
+	std::vector<uint32_t>	m_period;	// The invoice period
+
+	// Each invoice period's project, its number within its card, and
+	// whether it's still open (not yet invoiced)
+	std::vector<uint32_t>	m_pproject, m_pnum;
+	std::vector<uint8_t>	m_popen;
+
+	// The earliest and latest day within each batch of rows
+	std::vector<int32_t>	m_bmin, m_bmax;
+
+	STRTAB		m_names;
+	long		m_lo, m_hi;	// Days, over every row
+
+	TCTABLE(void) { m_lo = m_hi = 0; }
+
+	unsigned	size(void) const { return m_start.size(); }
+	unsigned	nperiods(void) const { return m_pnum.size(); }
+
+	// Returns false if the card couldn't be read, or not all of it
+	bool	load(const char *fname, const char *data = NULL, size_t len = 0);
+	void	finish(void);
+};
+
+const unsigned	TCTABLE::BATCH;
+
+bool	TCTABLE::load(const char *fname, const char *data, size_t len) {
+	// {{{
+	const TZONE	&tz = TZONE::local();
+	CARDSCAN	card;
+	CARDEVENT	ev;
+	std::string	name;
+	unsigned	nth = 0;
+	time_t		mid = 1, nextmid = 0;
+	int32_t		day = 0;
+	uint32_t	id;
+
+	if (!(data && card.open(data, len, fname)) && !card.open(fname)) {
+		fprintf(stderr, "ERR: Cannot read %s\n", fname);
+		return false;
+	}
+
+	m_pnum.push_back(0);
+	m_popen.push_back(1);
+
+	while(card.next(ev)) {
+		switch(ev.m_kind) {
+		case CE_PROJECT: {
+			const char	*ptr = &ev.m_line[8], *end;
+
+			while(isspace(*ptr))
+				ptr++;
+			end = ptr + strlen(ptr);
+			while(end > ptr && isspace(end[-1]))
+				end--;
+			if (end > ptr)
+				name.assign(ptr, end-ptr);
+			} break;
+		case CE_INVOICE:
+			m_popen.back() = 0;
+			m_pnum.push_back(++nth);
+			m_popen.push_back(1);
+			break;
+		case CE_INTERVAL:
+			if (ev.m_stop < ev.m_start)
+				break;
+			if (ev.m_start < mid || ev.m_start >= nextmid) {
+				struct	tm	tv;
+
+				tz.localtime(ev.m_start, tv);
+				day = TZONE::days_from_civil(tv.tm_year+1900,
+						tv.tm_mon+1, tv.tm_mday);
+				mid = tz.civil(tv.tm_year+1900, tv.tm_mon+1,
+						tv.tm_mday);
+				nextmid = tz.civil(tv.tm_year+1900, tv.tm_mon+1,
+						tv.tm_mday+1);
+			}
+
+			m_start.push_back(ev.m_start);
+			m_secs.push_back(ev.m_stop - ev.m_start);
+			m_day.push_back(day);
+			m_period.push_back(nperiods()-1);
+			break;
+		default:
+			break;
+		}
+	}
+
+	// A card without a Project: line goes by its file name
+	if (name.empty()) {
+		const char	*base = strrchr(fname, '/');
+
+		name = (base) ? base+1 : fname;
+	}
+
+	id = m_names.intern(name);
+	m_project.resize(size(), id);
+	m_pproject.resize(nperiods(), id);
+
+	// What was read of a card cut short is kept, but the query will
+	// be short the rest
+	return !card.error();
+}
+// }}}
+
+void	TCTABLE::finish(void) {
+	// {{{
+	m_bmin.clear();
+	m_bmax.clear();
+	for(unsigned base=0; base<size(); base+=BATCH) {
+		unsigned	end = std::min(base+BATCH, size());
+		int32_t		lo = m_day[base], hi = m_day[base];
+
+		for(unsigned k=base+1; k<end; k++) {
+			lo = std::min(lo, m_day[k]);
+			hi = std::max(hi, m_day[k]);
+		}
+
+		m_bmin.push_back(lo);
+		m_bmax.push_back(hi);
+		if (base == 0 || lo < m_lo)
+			m_lo = lo;
+		if (base == 0 || hi > m_hi)
+			m_hi = hi;
+	}
+}
+// }}}
+// }}}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// The plan
+// {{{
+////////////////////////////////////////////////////////////////////////////////
+//
+typedef	enum	{
+	QK_DAY, QK_WEEK, QK_MONTH, QK_QUARTER, QK_YEAR, QK_WEEKDAY,
+	QK_PROJECT, QK_INVOICE, QK_SESSION, QK_NKEYS
+} QKEY;
+
+typedef	enum	{
+	QA_SUM, QA_COUNT, QA_MAX, QA_MIN, QA_AVG, QA_FIRST, QA_LAST, QA_NAGGS
+} QAGG;
+
+typedef	enum	{ QO_EQ, QO_NE, QO_LT, QO_LE, QO_GT, QO_GE, QO_MATCH } QOP;
+
+static const char	*keystr[QK_NKEYS] = {
+	"day", "week", "month", "quarter", "year", "weekday",
+	"project", "invoice", "session" };
+static const char	*aggstr[QA_NAGGS] = {
+	"sum", "count", "max", "min", "avg", "first", "last" };
+
+// A predicate, run over a batch of rows at a time.  Each keeps those of
+// the nsel rows listed in sel that pass, and returns how many that is.
+class	QFILTER {
+public:
+	virtual	~QFILTER(void) {}
+	virtual	unsigned	apply(const TCTABLE &t, uint32_t *sel,
+					unsigned nsel) const = 0;
+	virtual	void	describe(FILE *fp) const = 0;
+};
+
+// lo <= day < hi
+class	QDAYRANGE : public QFILTER {
+public:
+	long	m_lo, m_hi;
+
+	QDAYRANGE(long lo, long hi) : m_lo(lo), m_hi(hi) {}
+
+	unsigned	apply(const TCTABLE &t, uint32_t *sel,
+				unsigned nsel) const {
+		// {{{
+		const int32_t	*day = t.m_day.data();
+		unsigned	n = 0;
+
+		for(unsigned k=0; k<nsel; k++) {
+			sel[n] = sel[k];
+			n += (day[sel[k]] >= m_lo && day[sel[k]] < m_hi);
+		}
+
+		return n;
+	}
+	// }}}
+
+	void	describe(FILE *fp) const {
+		// {{{
+		long		y[2];
+		unsigned	m[2], d[2];
+
+		TZONE::civil_from_days(m_lo, y[0], m[0], d[0]);
+		TZONE::civil_from_days(m_hi, y[1], m[1], d[1]);
+		fprintf(fp, "  filter  %04ld/%02u/%02u <= day < "
+			"%04ld/%02u/%02u  (batches outside skipped)\n",
+			y[0], m[0], d[0], y[1], m[1], d[1]);
+	}
+	// }}}
+};
+
+// lo <= seconds <= hi
+class	QSECSRANGE : public QFILTER {
+public:
+	int64_t	m_lo, m_hi;
+
+	QSECSRANGE(int64_t lo, int64_t hi) : m_lo(lo), m_hi(hi) {}
+
+	unsigned	apply(const TCTABLE &t, uint32_t *sel,
+				unsigned nsel) const {
+		// {{{
+		const int32_t	*secs = t.m_secs.data();
+		unsigned	n = 0;
+
+		for(unsigned k=0; k<nsel; k++) {
+			sel[n] = sel[k];
+			n += (secs[sel[k]] >= m_lo && secs[sel[k]] <= m_hi);
+		}
+
+		return n;
+	}
+	// }}}
+
+	void	describe(FILE *fp) const {
+		fprintf(fp, "  filter  %.4f <= hours <= %.4f\n",
+			m_lo / 3600.0, m_hi / 3600.0);
+	}
+};
+
+// Rows whose value in some column is in a set, held as a table of flags
+// indexed by that value.  The day column is first reduced to a weekday.
+class	QINSET : public QFILTER {
+public:
+	QKEY			m_key;	// QK_WEEKDAY, QK_PROJECT, or QK_INVOICE
+	std::vector<uint8_t>	m_in;
+	std::string		m_what;
+
+	unsigned	apply(const TCTABLE &t, uint32_t *sel,
+				unsigned nsel) const {
+		// {{{
+		const uint8_t	*in = m_in.data();
+		unsigned	n = 0;
+
+		if (m_key == QK_WEEKDAY) {
+			const int32_t	*day = t.m_day.data();
+
+			for(unsigned k=0; k<nsel; k++) {
+				sel[n] = sel[k];
+				n += in[TZONE::weekday(day[sel[k]])];
+			}
+		} else {
+			const uint32_t	*col = (m_key == QK_PROJECT)
+				? t.m_project.data() : t.m_period.data();
+
+			for(unsigned k=0; k<nsel; k++) {
+				sel[n] = sel[k];
+				n += in[col[sel[k]]];
+			}
+		}
+
+		return n;
+	}
+	// }}}
+
+	void	describe(FILE *fp) const {
+		unsigned	n = 0;
+
+		for(unsigned k=0; k<m_in.size(); k++)
+			n += m_in[k];
+		fprintf(fp, "  filter  %s %s  (%u of %u)\n", keystr[m_key],
+			m_what.c_str(), n, (unsigned)m_in.size());
+	}
+};
+
+// What's kept of each group
+typedef	struct	{
+	uint64_t	m_key;
+	uint64_t	m_count;
+	int64_t		m_sum, m_max, m_min, m_first, m_last;
+} QGROUP;
+
+// Groups, by their composite key, in an open addressed table
+class	QGROUPS {
+	std::vector<uint32_t>	m_slots;	// Index+1, or zero if empty
+public:
+	std::vector<QGROUP>	m_groups;
+
+	QGROUPS(void) { m_slots.assign(1024, 0); }
+
+	// A group known to be new, as every session is.  It isn't indexed,
+	// and can't be found again.
+	QGROUP	&add(uint64_t key) {
+		// {{{
+		QGROUP	g;
+
+		g.m_key = key;
+		g.m_count = 0;
+		g.m_sum = 0;
+		g.m_max = INT64_MIN;
+		g.m_min = INT64_MAX;
+		g.m_first = INT64_MAX;
+		g.m_last  = INT64_MIN;
+		m_groups.push_back(g);
+		return m_groups.back();
+	}
+	// }}}
+
+	QGROUP	&find(uint64_t key) {
+		// {{{
+		unsigned	mask = m_slots.size()-1,
+				k = (unsigned)((key * 0x9e3779b97f4a7c15ull) >> 32)
+					& mask;
+
+		while(m_slots[k] != 0) {
+			if (m_groups[m_slots[k]-1].m_key == key)
+				return m_groups[m_slots[k]-1];
+			k = (k+1) & mask;
+		}
+
+		add(key);
+		m_slots[k] = m_groups.size();
+
+		if (2*m_groups.size() > m_slots.size()) {
+			m_slots.assign(2*m_slots.size(), 0);
+			mask = m_slots.size()-1;
+			for(unsigned id=0; id<m_groups.size(); id++) {
+				k = (unsigned)((m_groups[id].m_key
+					* 0x9e3779b97f4a7c15ull) >> 32) & mask;
+				while(m_slots[k] != 0)
+					k = (k+1) & mask;
+				m_slots[k] = id+1;
+			}
+		}
+
+		return m_groups.back();
+	}
+	// }}}
+};
+
+class	QPLAN {
+	std::vector<QFILTER *>	m_filters;
+	QDAYRANGE	*m_days;	// Also used to skip whole batches
+	std::vector<QKEY>	m_keys;
+	std::vector<long>	m_base;	// Subtracted from each key
+	std::vector<uint64_t>	m_radix;	// Range of each key
+	QAGG		m_agg;
+
+	bool		m_having;
+	QOP		m_hop;
+	double		m_hval;
+	bool		m_byvalue, m_desc;
+	unsigned long	m_limit;
+
+	long	keyrange(const TCTABLE &t, QKEY key, long &base) const;
+	void	keys(const TCTABLE &t, QKEY key, long base,
+			const uint32_t *sel, unsigned nsel, uint64_t *ck,
+			uint64_t radix) const;
+	long	decode(uint64_t ck, unsigned kn) const;
+	double	value(const QGROUP &g) const;
+	void	label(OUTBUF &out, const TCTABLE &t, QKEY key, long v) const;
+	unsigned	labellen(const TCTABLE &t, QKEY key, long v) const;
+public:
+	QPLAN(void) {
+		m_days = NULL;
+		m_agg = QA_SUM;
+		m_having = m_byvalue = m_desc = false;
+		m_hop = QO_EQ;
+		m_hval = 0;
+		m_limit = 0;
+	}
+
+	~QPLAN(void) {
+		for(unsigned k=0; k<m_filters.size(); k++)
+			delete m_filters[k];
+	}
+
+	bool	compile(const char *query, const TCTABLE &t);
+	void	explain(FILE *fp, const TCTABLE &t) const;
+	void	run(const TCTABLE &t, OUTBUF &out);
+};
+// }}}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Compiling a query
+// {{{
+////////////////////////////////////////////////////////////////////////////////
+//
+class	QLEXER {
+	const char	*m_ptr;
+public:
+	std::string	m_tok;
+	bool		m_quoted;
+
+	QLEXER(const char *str) : m_ptr(str) { next(); }
+
+	// Moves on to the next token.  An empty token is the end.
+	void	next(void) {
+		// {{{
+		m_tok.clear();
+		m_quoted = false;
+		while(isspace(*m_ptr))
+			m_ptr++;
+		if (*m_ptr == '"' || *m_ptr == '\'') {
+			char	q = *m_ptr++;
+
+			while(*m_ptr && *m_ptr != q)
+				m_tok += *m_ptr++;
+			if (*m_ptr)
+				m_ptr++;
+			m_quoted = true;
+		} else if (strchr("=!<>~,", *m_ptr) && *m_ptr) {
+			m_tok += *m_ptr++;
+			if (*m_ptr == '=' && m_tok[0] != '~' && m_tok[0] != ',')
+				m_tok += *m_ptr++;
+		} else {
+			while(*m_ptr && !isspace(*m_ptr)
+					&& !strchr("=!<>~,\"'", *m_ptr))
+				m_tok += *m_ptr++;
+		}
+	}
+	// }}}
+
+	bool	end(void) const { return m_tok.empty() && !m_quoted; }
+	bool	is(const char *word) const {
+		return !m_quoted && 0 == strcasecmp(m_tok.c_str(), word); }
+	bool	accept(const char *word) {
+		if (!is(word))
+			return false;
+		next();
+		return true;
+	}
+};
+
+static	bool	parse_op(QLEXER &lx, QOP &op) {
+	// {{{
+	static const char	*ops[] = { "=", "!=", "<", "<=", ">", ">=", "~" };
+
+	for(int k=0; k<7; k++) {
+		if (lx.is(ops[k])) {
+			op = (QOP)k;
+			lx.next();
+			return true;
+		}
+	}
+
+	fprintf(stderr, "ERR: Expected a comparison, not \"%s\"\n",
+		lx.m_tok.c_str());
+	return false;
+}
+// }}}
+
+// A date, or a year or month, as a range of days [lo, hi).  today, and
+// today-N or today+N, are also taken.
+static	bool	parse_date(const char *str, long &lo, long &hi) {
+	// {{{
+	int	y = 0, m = 0, d = 0;
+	char	extra;
+
+	if (0 == strncasecmp(str, "today", 5)) {
+		struct	tm	tv;
+		long		n = 0;
+
+		TZONE::local().localtime(time(NULL), tv);
+		if (str[5] && 1 != sscanf(&str[5], "%ld%c", &n, &extra))
+			return false;
+		lo = TZONE::days_from_civil(tv.tm_year+1900, tv.tm_mon+1,
+				tv.tm_mday) + n;
+		hi = lo + 1;
+		return true;
+	}
+
+	if (3 == sscanf(str, "%d/%d/%d%c", &y, &m, &d, &extra)
+		|| (strlen(str) == 8 && TIMECARD().digitstr(str, 8)
+			&& 3 == sscanf(str, "%4d%2d%2d", &y, &m, &d))) {
+		lo = TZONE::days_from_civil(y, m, d);
+		hi = lo + 1;
+	} else if (2 == sscanf(str, "%d/%d%c", &y, &m, &extra)) {
+		lo = TZONE::days_from_civil(y, m, 1);
+		hi = TZONE::days_from_civil(y + m/12, m%12+1, 1);
+	} else if (strlen(str) == 4 && TIMECARD().digitstr(str, 4)) {
+		y = atoi(str);
+		lo = TZONE::days_from_civil(y, 1, 1);
+		hi = TZONE::days_from_civil(y+1, 1, 1);
+	} else
+		return false;
+
+	return (m >= 0 && m <= 12 && d >= 0 && d <= 31);
+}
+// }}}
+
+bool	QPLAN::compile(const char *query, const TCTABLE &t) {
+	// {{{
+	QLEXER		lx(query);
+	long		dlo = -(1l<<40), dhi = (1l<<40);
+	int64_t		slo = 0, shi = INT64_MAX;
+	bool		anydays = false, anysecs = false;
+
+	// The aggregate
+	for(int a=0; a<QA_NAGGS; a++)
+		if (lx.accept(aggstr[a]))
+			m_agg = (QAGG)a;
+	if (lx.accept("hours"))
+		m_agg = QA_SUM;
+
+	// Filters
+	if (lx.accept("where")) do {
+		QOP	op;
+
+		if (lx.accept("date") || lx.accept("year")
+				|| lx.accept("month")) {
+			// {{{
+			long	lo, hi;
+
+			if (!parse_op(lx, op))
+				return false;
+			if (!parse_date(lx.m_tok.c_str(), lo, hi)) {
+				fprintf(stderr, "ERR: Bad date, \"%s\"\n",
+					lx.m_tok.c_str());
+				return false;
+			} lx.next();
+
+			switch(op) {
+			case QO_EQ:	dlo = std::max(dlo, lo);
+					dhi = std::min(dhi, hi); break;
+			case QO_LT:	dhi = std::min(dhi, lo); break;
+			case QO_LE:	dhi = std::min(dhi, hi); break;
+			case QO_GT:	dlo = std::max(dlo, hi); break;
+			case QO_GE:	dlo = std::max(dlo, lo); break;
+			default:
+				fprintf(stderr, "ERR: Dates take =, <, <=, >, "
+					"or >=\n");
+				return false;
+			}
+			anydays = true;
+			// }}}
+		} else if (lx.accept("hours")) {
+			// {{{
+			double	h;
+			int64_t	s;
+
+			if (!parse_op(lx, op))
+				return false;
+			h = atof(lx.m_tok.c_str());
+			s = (int64_t)(h * 3600 + 0.5);
+			lx.next();
+
+			switch(op) {
+			case QO_EQ:	slo = std::max(slo, s);
+					shi = std::min(shi, s); break;
+			case QO_LT:	shi = std::min(shi, s-1); break;
+			case QO_LE:	shi = std::min(shi, s); break;
+			case QO_GT:	slo = std::max(slo, s+1); break;
+			case QO_GE:	slo = std::max(slo, s); break;
+			default:
+				fprintf(stderr, "ERR: Hours take =, <, <=, >, "
+					"or >=\n");
+				return false;
+			}
+			anysecs = true;
+			// }}}
+		} else if (lx.is("weekday") || lx.is("project")
+				|| lx.is("invoice")) {
+			// {{{
+			QINSET	*f = new QINSET;
+			std::string	arg;
+			bool	neg;
+
+			f->m_key = lx.is("weekday") ? QK_WEEKDAY
+				: lx.is("project") ? QK_PROJECT : QK_INVOICE;
+			m_filters.push_back(f);
+			lx.next();
+			if (!parse_op(lx, op))
+				return false;
+			if (op != QO_EQ && op != QO_NE && !(op == QO_MATCH
+					&& f->m_key == QK_PROJECT)) {
+				fprintf(stderr, "ERR: %s takes =, !=%s\n",
+					keystr[f->m_key],
+					(f->m_key == QK_PROJECT) ? ", or ~":"");
+				return false;
+			}
+			neg = (op == QO_NE);
+			arg = lx.m_tok;
+			lx.next();
+			f->m_what = std::string((op == QO_NE) ? "!= "
+				: (op == QO_MATCH) ? "~ " : "= ") + arg;
+
+			switch(f->m_key) {
+			case QK_WEEKDAY:
+				f->m_in.assign(7, neg);
+				for(int d=0; d<7; d++)
+					if (arg.size() >= 3 && 0 == strncasecmp(
+						daystr[d], arg.c_str(),
+						arg.size()))
+						f->m_in[d] = !neg;
+				break;
+			case QK_PROJECT:
+				f->m_in.assign(t.m_names.size(), neg);
+				for(unsigned p=0; p<t.m_names.size(); p++) {
+					const char	*nm = t.m_names.str(p);
+					bool	hit;
+
+					if (op == QO_MATCH)
+						hit = (NULL != strcasestr(nm,
+							arg.c_str()));
+					else
+						hit = (0 == strcasecmp(nm,
+							arg.c_str()));
+					if (hit)
+						f->m_in[p] = !neg;
+				}
+				break;
+			default: {
+				bool	open = (0 == strcasecmp(arg.c_str(),
+							"open"));
+				unsigned	n = atoi(arg.c_str());
+
+				if (!open && !TIMECARD().digitstr(arg.c_str(),
+						arg.size())) {
+					fprintf(stderr, "ERR: An invoice is a "
+						"number, or open\n");
+					return false;
+				}
+
+				f->m_in.assign(t.nperiods(), neg);
+				for(unsigned p=0; p<t.nperiods(); p++)
+					if ((open) ? t.m_popen[p]
+							: t.m_pnum[p] == n)
+						f->m_in[p] = !neg;
+				} break;
+			}
+			// }}}
+		} else {
+			fprintf(stderr, "ERR: Can't filter on \"%s\"\n",
+				lx.m_tok.c_str());
+			return false;
+		}
+	} while(lx.accept("and"));
+
+	// The cheapest, and most selective, filters run first
+	if (anysecs)
+		m_filters.insert(m_filters.begin(), new QSECSRANGE(slo, shi));
+	if (anydays) {
+		// Nothing's outside of the table anyway
+		dlo = std::max(dlo, t.m_lo);
+		dhi = std::max(dlo, std::min(dhi, t.m_hi+1));
+		m_days = new QDAYRANGE(dlo, dhi);
+		m_filters.insert(m_filters.begin(), m_days);
+	}
+
+	// Grouping
+	if (lx.accept("group")) {
+		uint64_t	total = 1;
+
+		lx.accept("by");
+		do {
+			int	k;
+
+			for(k=0; k<QK_NKEYS; k++)
+				if (lx.accept(keystr[k]))
+					break;
+			if (k >= QK_NKEYS) {
+				fprintf(stderr, "ERR: Can't group by \"%s\"\n",
+					lx.m_tok.c_str());
+				return false;
+			}
+
+			long	base, range = keyrange(t, (QKEY)k, base);
+
+			m_keys.push_back((QKEY)k);
+			m_base.push_back(base);
+			m_radix.push_back(range);
+			if (total > UINT64_MAX / range) {
+				fprintf(stderr, "ERR: Too many keys to group by\n");
+				return false;
+			}
+			total *= range;
+		} while(lx.accept(","));
+	}
+
+	if (lx.accept("having")) {
+		// {{{
+		long	lo, hi;
+
+		if (!lx.accept("value"))
+			lx.accept(aggstr[m_agg]);
+		if (!parse_op(lx, m_hop) || m_hop == QO_MATCH)
+			return false;
+		if (m_agg == QA_FIRST || m_agg == QA_LAST) {
+			if (!parse_date(lx.m_tok.c_str(), lo, hi)) {
+				fprintf(stderr, "ERR: Bad date, \"%s\"\n",
+					lx.m_tok.c_str());
+				return false;
+			} m_hval = lo;
+		} else
+			m_hval = atof(lx.m_tok.c_str());
+		lx.next();
+		m_having = true;
+		// }}}
+	}
+
+	if (lx.accept("order")) {
+		lx.accept("by");
+		if (lx.accept("value") || lx.accept(aggstr[m_agg]))
+			m_byvalue = true;
+		else
+			lx.accept("key");
+		if (lx.accept("desc"))
+			m_desc = true;
+		else
+			lx.accept("asc");
+	}
+
+	if (lx.accept("limit")) {
+		m_limit = strtoul(lx.m_tok.c_str(), NULL, 10);
+		lx.next();
+	}
+
+	if (!lx.end()) {
+		fprintf(stderr, "ERR: Unexpected \"%s\"\n", lx.m_tok.c_str());
+		return false;
+	}
+
+	return true;
+}
+// }}}
+
+void	QPLAN::explain(FILE *fp, const TCTABLE &t) const {
+	// {{{
+	fprintf(fp, "PLAN\n");
+	fprintf(fp, "  scan    %u rows, %u at a time\n", t.size(),
+		TCTABLE::BATCH);
+	for(unsigned k=0; k<m_filters.size(); k++)
+		m_filters[k]->describe(fp);
+	for(unsigned k=0; k<m_keys.size(); k++)
+		fprintf(fp, "  key     %s  (%lu values)\n", keystr[m_keys[k]],
+			(unsigned long)m_radix[k]);
+	fprintf(fp, "  %-7s hours\n", aggstr[m_agg]);
+	if (m_having) {
+		static const char *ops[] = { "=", "!=", "<", "<=", ">", ">=" };
+
+		fprintf(fp, "  having  value %s %g\n", ops[m_hop], m_hval);
+	}
+	fprintf(fp, "  order   by %s%s\n", (m_byvalue) ? "value" : "key",
+		(m_desc) ? ", descending" : "");
+	if (m_limit)
+		fprintf(fp, "  limit   %lu\n", m_limit);
+}
+// }}}
+// }}}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Running the plan
+// {{{
+////////////////////////////////////////////////////////////////////////////////
+//
+
+// The number of values a key takes, and the least of them
+long	QPLAN::keyrange(const TCTABLE &t, QKEY key, long &base) const {
+	// {{{
+	base = 0;
+	switch(key) {
+	case QK_DAY:	base = t.m_lo; return t.m_hi - t.m_lo + 1;
+	case QK_WEEK:
+		base = HISTPYRAMID::period(HL_WEEK, t.m_lo);
+		return HISTPYRAMID::period(HL_WEEK, t.m_hi) - base + 1;
+	case QK_MONTH:
+		base = HISTPYRAMID::period(HL_MONTH, t.m_lo);
+		return HISTPYRAMID::period(HL_MONTH, t.m_hi) - base + 1;
+	case QK_QUARTER:
+		base = HISTPYRAMID::period(HL_MONTH, t.m_lo) / 3;
+		return HISTPYRAMID::period(HL_MONTH, t.m_hi) / 3 - base + 1;
+	case QK_YEAR:
+		base = HISTPYRAMID::period(HL_YEAR, t.m_lo);
+		return HISTPYRAMID::period(HL_YEAR, t.m_hi) - base + 1;
+	case QK_WEEKDAY:	return 7;
+	case QK_PROJECT:	return std::max(1u, t.m_names.size());
+	case QK_INVOICE:	return std::max(1u, t.nperiods());
+	default:		return std::max(1u, t.size());
+	}
+}
+// }}}
+
+// Folds one key, for each selected row, into the composite keys
+void	QPLAN::keys(const TCTABLE &t, QKEY key, long base, const uint32_t *sel,
+		unsigned nsel, uint64_t *ck, uint64_t radix) const {
+	// {{{
+	const int32_t	*day = t.m_day.data();
+
+	switch(key) {
+	case QK_DAY:
+		for(unsigned k=0; k<nsel; k++)
+			ck[k] = ck[k] * radix + (day[sel[k]] - base);
+		break;
+	case QK_WEEK:
+		for(unsigned k=0; k<nsel; k++)
+			ck[k] = ck[k] * radix
+				+ (HISTPYRAMID::period(HL_WEEK, day[sel[k]])
+					- base);
+		break;
+	case QK_MONTH:
+	case QK_QUARTER:
+	case QK_YEAR: {
+		// Rows come in date order, within each card.  Only work out
+		// the civil date when the day changes.
+		long		last = -(1l<<40), v = 0, y;
+		unsigned	m, d;
+
+		for(unsigned k=0; k<nsel; k++) {
+			if (day[sel[k]] != last) {
+				last = day[sel[k]];
+				TZONE::civil_from_days(last, y, m, d);
+				v = (key == QK_YEAR) ? y
+					: (key == QK_MONTH) ? y*12+m-1
+					: (y*12+m-1)/3;
+			}
+			ck[k] = ck[k] * radix + (v - base);
+		}} break;
+	case QK_WEEKDAY:
+		for(unsigned k=0; k<nsel; k++)
+			ck[k] = ck[k] * radix + TZONE::weekday(day[sel[k]]);
+		break;
+	case QK_PROJECT:
+		for(unsigned k=0; k<nsel; k++)
+			ck[k] = ck[k] * radix + t.m_project[sel[k]];
+		break;
+	case QK_INVOICE:
+		for(unsigned k=0; k<nsel; k++)
+			ck[k] = ck[k] * radix + t.m_period[sel[k]];
+		break;
+	default:
+		for(unsigned k=0; k<nsel; k++)
+			ck[k] = ck[k] * radix + sel[k];
+		break;
+	}
+}
+// }}}
+
+// Pulls the kn'th key back out of a composite key
+long	QPLAN::decode(uint64_t ck, unsigned kn) const {
+	// {{{
+	for(unsigned k=m_keys.size()-1; k>kn; k--)
+		ck /= m_radix[k];
+	return (long)(ck % m_radix[kn]) + m_base[kn];
+}
+// }}}
+
+// Hours, a count, or a day number
+double	QPLAN::value(const QGROUP &g) const {
+	// {{{
+	switch(m_agg) {
+	case QA_COUNT:	return (double)g.m_count;
+	case QA_MAX:	return g.m_max / 3600.0;
+	case QA_MIN:	return g.m_min / 3600.0;
+	case QA_AVG:	return g.m_sum / 3600.0 / g.m_count;
+	case QA_FIRST:	return g.m_first;
+	case QA_LAST:	return g.m_last;
+	default:	return g.m_sum / 3600.0;
+	}
+}
+// }}}
+
+static	void	put_date(OUTBUF &out, long day) {
+	// {{{
+	long		y;
+	unsigned	m, d;
+
+	TZONE::civil_from_days(day, y, m, d);
+	out.put_fixed(y, 4);
+	out.put('/');
+	out.put_fixed(m, 2);
+	out.put('/');
+	out.put_fixed(d, 2);
+}
+// }}}
+
+void	QPLAN::label(OUTBUF &out, const TCTABLE &t, QKEY key, long v) const {
+	// {{{
+	switch(key) {
+	case QK_DAY:
+		put_date(out, v);
+		break;
+	case QK_WEEK: {
+		// The ISO week, which is that of its Thursday, and its Monday
+		long		monday = HISTPYRAMID::begins(HL_WEEK, v), y;
+		unsigned	m, d;
+
+		TZONE::civil_from_days(monday + 3, y, m, d);
+		out.put_fixed(y, 4);
+		out.put("-W", 2);
+		out.put_fixed((monday + 3 - TZONE::days_from_civil(y,1,1))/7+1,
+				2);
+		out.put(' ');
+		put_date(out, monday);
+		} break;
+	case QK_MONTH:
+		out.put_fixed(v / 12, 4);
+		out.put('/');
+		out.put_fixed(v % 12 + 1, 2);
+		break;
+	case QK_QUARTER:
+		out.put_fixed(v / 4, 4);
+		out.put("-Q", 2);
+		out.put((char)('1' + v % 4));
+		break;
+	case QK_YEAR:
+		out.put_fixed(v, 4);
+		break;
+	case QK_WEEKDAY:
+		out.put_right(daystr[v], 9);
+		break;
+	case QK_PROJECT:
+		out.put(t.m_names.str(v));
+		break;
+	case QK_INVOICE:
+		out.put(t.m_names.str(t.m_pproject[v]));
+		if (t.m_popen[v])
+			out.put(" (open)");
+		else {
+			out.put(" #");
+			out.put_uint(t.m_pnum[v] + 1);
+		}
+		break;
+	default: {
+		// A session: its start, length, and project
+		struct	tm	tv;
+
+		TZONE::local().localtime(t.m_start[v], tv);
+		put_date(out, t.m_day[v]);
+		out.put(' ');
+		out.put_fixed(tv.tm_hour, 2);
+		out.put_fixed(tv.tm_min, 2);
+		out.put_fixed(tv.tm_sec, 2);
+		out.put(' ');
+		out.put(t.m_names.str(t.m_project[v]));
+		} break;
+	}
+}
+// }}}
+
+// The width of a label naming a project, or zero for those always the same
+// width
+unsigned	QPLAN::labellen(const TCTABLE &t, QKEY key, long v) const {
+	// {{{
+	unsigned	len;
+
+	switch(key) {
+	case QK_PROJECT:
+		return strlen(t.m_names.str(v));
+	case QK_INVOICE:
+		len = strlen(t.m_names.str(t.m_pproject[v]));
+		if (t.m_popen[v])
+			return len + 7;		// " (open)"
+		len += 3;			// " #", and a digit
+		for(unsigned n=t.m_pnum[v]+1; n >= 10; n /= 10)
+			len++;
+		return len;
+	case QK_SESSION:
+		// YYYY/MM/DD HHMMSS, then the project
+		return 18 + strlen(t.m_names.str(t.m_project[v]));
+	default:
+		return 0;
+	}
+}
+// }}}
+
+void	QPLAN::run(const TCTABLE &t, OUTBUF &out) {
+	// {{{
+	QGROUPS		groups;
+	uint32_t	sel[TCTABLE::BATCH];
+	uint64_t	ck[TCTABLE::BATCH];
+	std::vector<const QGROUP *>	rows;
+	bool		unique = false;	// Every row its own group?
+
+	for(unsigned k=0; k<m_keys.size(); k++)
+		if (m_keys[k] == QK_SESSION)
+			unique = true;
+
+	for(unsigned base=0, b=0; base<t.size(); base+=TCTABLE::BATCH, b++) {
+		unsigned	nsel = std::min(TCTABLE::BATCH, t.size()-base);
+
+		if (m_days && (t.m_bmax[b] < m_days->m_lo
+				|| t.m_bmin[b] >= m_days->m_hi))
+			continue;
+
+		for(unsigned k=0; k<nsel; k++)
+			sel[k] = base + k;
+		for(unsigned f=0; f<m_filters.size() && nsel > 0; f++)
+			nsel = m_filters[f]->apply(t, sel, nsel);
+		if (nsel == 0)
+			continue;
+
+		memset(ck, 0, nsel * sizeof(ck[0]));
+		for(unsigned k=0; k<m_keys.size(); k++)
+			keys(t, m_keys[k], m_base[k], sel, nsel, ck, m_radix[k]);
+
+		// Runs of rows with the same key, as within a day, share
+		// one lookup
+		for(unsigned k=0; k<nsel; ) {
+			QGROUP		&g = (unique) ? groups.add(ck[k])
+						: groups.find(ck[k]);
+			unsigned	end = k;
+
+			for(; end<nsel && ck[end] == ck[k]; end++) {
+				int64_t	secs = t.m_secs[sel[end]];
+				long	day = t.m_day[sel[end]];
+
+				g.m_sum += secs;
+				g.m_max = std::max(g.m_max, secs);
+				g.m_min = std::min(g.m_min, secs);
+				g.m_first = std::min(g.m_first, (int64_t)day);
+				g.m_last  = std::max(g.m_last, (int64_t)day);
+			}
+
+			g.m_count += end - k;
+			k = end;
+		}
+	}
+
+	for(unsigned k=0; k<groups.m_groups.size(); k++) {
+		const QGROUP	&g = groups.m_groups[k];
+
+		if (m_having) {
+			double	v = value(g);
+			bool	pass;
+
+			switch(m_hop) {
+			case QO_EQ:	pass = (v == m_hval); break;
+			case QO_NE:	pass = (v != m_hval); break;
+			case QO_LT:	pass = (v <  m_hval); break;
+			case QO_LE:	pass = (v <= m_hval); break;
+			case QO_GT:	pass = (v >  m_hval); break;
+			default:	pass = (v >= m_hval); break;
+			}
+			if (!pass)
+				continue;
+		}
+
+		rows.push_back(&g);
+	}
+
+	// Keys are mixed radix, first key most significant, so sorting by
+	// composite key sorts by the keys in order.  Keys are unique, so
+	// the order is total, and only as many rows as will be shown need
+	// to be sorted.
+	auto	before = [this](const QGROUP *a, const QGROUP *b) {
+			if (m_byvalue) {
+				double	va = value(*a), vb = value(*b);
+
+				if (va != vb)
+					return (m_desc) ? va > vb : va < vb;
+			} else if (m_desc)
+				return a->m_key > b->m_key;
+			return a->m_key < b->m_key;
+		};
+	if (m_limit && rows.size() > m_limit) {
+		std::partial_sort(rows.begin(), rows.begin() + m_limit,
+			rows.end(), before);
+		rows.resize(m_limit);
+	} else
+		std::sort(rows.begin(), rows.end(), before);
+
+	// Labels naming projects are padded to the longest shown, so the
+	// values line up
+	std::vector<unsigned>	width(m_keys.size(), 0);
+	for(unsigned r=0; r<rows.size(); r++)
+		for(unsigned k=0; k<m_keys.size(); k++)
+			width[k] = std::max(width[k], labellen(t, m_keys[k],
+						decode(rows[r]->m_key, k)));
+
+	for(unsigned r=0; r<rows.size(); r++) {
+		const QGROUP	&g = *rows[r];
+
+		for(unsigned k=0; k<m_keys.size(); k++) {
+			long	v = decode(g.m_key, k);
+
+			label(out, t, m_keys[k], v);
+			for(unsigned n=labellen(t, m_keys[k], v); n<width[k]; n++)
+				out.put(' ');
+			out.put("  ", 2);
+		}
+
+		switch(m_agg) {
+		case QA_COUNT:	out.put_uint(g.m_count); break;
+		case QA_FIRST:	put_date(out, g.m_first); break;
+		case QA_LAST:	put_date(out, g.m_last); break;
+		default: {
+			// Hours, to the hundredth
+			double	v = value(g) * 100.0 + 0.5;
+
+			out.put_cents((int64_t)v, 8);
+			} break;
+		}
+		out.put('\n');
+	}
+}
+// }}}
+// }}}
+
+void	usage(void) {
+	// {{{
+	fprintf(stderr,
+"USAGE: tcq [-p] [-t] 'query' timesheet.txt ... [%%]\n"
+"\n"
+"\t-p\tPrint the plan the query compiles to\n"
+"\t-t\tReport the time spent loading and running, to stderr\n"
+"\n"
+"A %% stands for every card listed in ~/.xtimesheet.  Queries take the form\n"
+"\n"
+"\t[AGGREGATE] [where FILTER [and FILTER]...] [group by KEY [, KEY]...]\n"
+"\t\t[having value OP X] [order by key|value [desc]] [limit N]\n"
+"\n"
+"AGGREGATE is one of sum (the default), count, max, min, or avg, all of\n"
+"the hours of each interval, or first or last, the dates of the earliest\n"
+"and latest.  Each FILTER is one of\n"
+"\n"
+"\tdate OP DATE\twith DATE as YYYY, YYYY/MM, YYYY/MM/DD, or today[-N]\n"
+"\thours OP N\tthe length of an interval\n"
+"\tweekday = DAY\tor !=\n"
+"\tproject = NAME\tor != or ~, where ~ matches any part of the name\n"
+"\tinvoice = N\tor open, the time since a card's last invoice, or !=\n"
+"\n"
+"OP is one of =, !=, <, <=, >, or >=.  KEY is one of day, week, month,\n"
+"quarter, year, weekday, project, invoice, or session (each interval on\n"
+"its own).  Names with spaces may be quoted.  For example,\n"
+"\n"
+"\ttcq 'where project = \"Client X\" and date = 2023 group by weekday' %%\n"
+"\ttcq 'max group by session order by value desc limit 10' %%\n"
+"\ttcq 'last group by project having value < today-30' %%\n");
+}
+// }}}
+
+static	double	now(void) {
+	// {{{
+	struct	timespec	ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+// }}}
+
+int main(int argc, char **argv) {
+	TCTABLE		table;
+	QPLAN		plan;
+	OUTBUF		out;
+	const char	*query = NULL;
+	bool		explain = false, timing = false;
+	unsigned	nfailed = 0;	// Cards that couldn't all be read
+	double		t0 = now(), t1, t2;
+
+	for(int argn=1; argn<argc; argn++) {
+		if (argv[argn][0] == '-' && argv[argn][1]) {
+			if (argv[argn][1] == 'p')
+				explain = true;
+			else if (argv[argn][1] == 't')
+				timing = true;
+			else {
+				usage();
+				exit(EXIT_FAILURE);
+			}
+		} else if (NULL == query) {
+			query = argv[argn];
+		} else if (access(argv[argn], R_OK)==0) {
+			if (!table.load(argv[argn]))
+				nfailed++;
+		} else if (argv[argn][0] == '%') {
+			// {{{
+			FILE	*fcfg;
+			char *home, cfg_file[128], cfg_task[128];
+			CARDBATCH	batch;
+
+			home = getenv("HOME");
+			if (!home)
+				continue;
+			strcpy(cfg_file, home);
+			strcat(cfg_file, "/.xtimesheet");
+			if (NULL != (fcfg = fopen(cfg_file, "r"))) {
+				while(fgets(cfg_task, sizeof(cfg_task), fcfg)) {
+					int	sln = strlen(cfg_task);
+					while(sln > 0 && isspace(cfg_task[sln-1]))
+						cfg_task[--sln] = '\0';
+					if (sln > 0)
+						batch.add(cfg_task);
+				} fclose(fcfg);
+			}
+
+			batch.read([&](unsigned k, const char *d, size_t len) {
+				if (!table.load(batch.name(k), d, len))
+					nfailed++;
+			}, BATCHLIMIT);
+			// }}}
+		} else
+			fprintf(stderr, "WARNING: Cannot access %s\n", argv[argn]);
+	}
+
+	if (NULL == query) {
+		usage();
+		exit(EXIT_FAILURE);
+	}
+
+	table.finish();
+	t1 = now();
+
+	if (!plan.compile(query, table))
+		exit(EXIT_FAILURE);
+	if (explain)
+		plan.explain(stdout, table);
+	fflush(stdout);
+
+	plan.run(table, out);
+	out.flush();
+	t2 = now();
+
+	if (timing)
+		fprintf(stderr, "%u intervals, %u projects: loaded in %.3fs, "
+			"queried in %.3fs\n", table.size(),
+			table.m_names.size(), t1 - t0, t2 - t1);
+
+	return (out.error() || nfailed > 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,175 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename:	sw/tcstatus.cpp
+//
+// Project:	Xtimesheet, a very simple text-based timesheet tracking program
+// {{{
+// Purpose:	Prints what xtimesheet is working on, for a status bar, from
+//		the status page it publishes (see tcstatus.h).  Nothing is
+//	read from any time card.
+//
+//	Run once, it prints a single line.  With -i, it maps the page just
+//	once, and prints a line every so many seconds, for status bars that
+//	read a running command's output.  Each line then costs a few loads
+//	from the page, and the write.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2017-2024, Gisselquist Technology, LLC
+// {{{
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	GPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/gpl.html
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+__attribute__((unused))
+static const char *cpyright = "(C) 2024 Gisselquist Technology, LLC: " __FILE__;
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "tcstatus.h"
+
+// A page not written in this long was left by an xtimesheet that died.
+// The window rewrites it every few seconds.
+static	const	time_t	STALE = 30;
+
+void	usage(void) {
+	// {{{
+	fprintf(stderr,
+"USAGE: tcstatus [-s|-v] [-i secs]\n"
+"\n"
+"\t-s\tShort: only the project and its running time, or \"idle\"\n"
+"\t-v\tEvery field of the page, one per line\n"
+"\t-i secs\tKeep printing, every secs seconds\n"
+"\n"
+"Prints the project xtimesheet is working on, how long its timer has been\n"
+"running, and the hours worked on it today, this week, and since its last\n"
+"invoice.  Exits with a non-zero status if xtimesheet isn't running.\n");
+}
+// }}}
+
+static	void	hhmm(char *buf, time_t secs) {
+	// {{{
+	sprintf(buf, "%ld:%02ld", (long)(secs / 3600), (long)((secs / 60) % 60));
+}
+// }}}
+
+// Prints one sample of the page.  Returns false if no one's publishing.
+static	bool	show(const TCSTATUS *page, char mode) {
+	// {{{
+	TCSTATUS	st;
+	time_t		now = time(NULL), running = 0;
+	char		elapsed[32];
+
+	if (0 != tcstatus_read(page, &st) || st.m_pid == 0
+			|| now - st.m_published > STALE) {
+		printf("xtimesheet is not running\n");
+		return false;
+	}
+
+	if (st.m_last_start != 0 && now > st.m_last_start)
+		running = now - st.m_last_start;
+	hhmm(elapsed, running);
+
+	if (mode == 's') {
+		if (st.m_last_start != 0)
+			printf("%s %s\n", st.m_project, elapsed);
+		else
+			printf("idle\n");
+	} else if (mode == 'v') {
+		printf("project:   %s\n", st.m_project);
+		printf("card:      %s\n", st.m_card);
+		printf("pid:       %d\n", (int)st.m_pid);
+		printf("published: %ld\n", (long)st.m_published);
+		printf("running:   %u\n", (unsigned)st.m_running);
+		printf("start:     %ld\n", (long)st.m_last_start);
+		printf("elapsed:   %ld\n", (long)running);
+		printf("today:     %ld\n", (long)(st.m_today + running));
+		printf("alltoday:  %ld\n", (long)(st.m_alltoday + running));
+		printf("week:      %ld\n", (long)(st.m_week + running));
+		printf("invoice:   %.1f hours, $%.2f\n",
+			st.m_invtenths / 10.0, st.m_invcents / 100.0);
+	} else {
+		printf("%s %s | today %.1f | week %.1f | uninvoiced %.1f\n",
+			st.m_project, (st.m_last_start != 0) ? elapsed : "idle",
+			(st.m_today + running) / 3600.0,
+			(st.m_week + running) / 3600.0,
+			st.m_invtenths / 10.0);
+	}
+
+	return true;
+}
+// }}}
+
+int main(int argc, char **argv) {
+	const TCSTATUS	*page;
+	char		mode = 0;
+	int		interval = 0;
+	bool		ok;
+
+	for(int argn=1; argn<argc; argn++) {
+		if (argv[argn][0] == '-' && argv[argn][1] && !argv[argn][2]) {
+			switch(argv[argn][1]) {
+			case 's':
+			case 'v': mode = argv[argn][1]; break;
+			case 'i':
+				if (argn+1 >= argc || atoi(argv[argn+1]) <= 0) {
+					usage();
+					exit(EXIT_FAILURE);
+				}
+				interval = atoi(argv[++argn]);
+				break;
+			default:
+				usage();
+				exit(EXIT_FAILURE);
+			}
+		} else {
+			usage();
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	// Until xtimesheet has run at least once, there's nothing to map.
+	// Run every so often, keep looking for it.
+	while(NULL == (page = tcstatus_map())) {
+		printf("xtimesheet is not running\n");
+		if (interval == 0)
+			return EXIT_FAILURE;
+		fflush(stdout);
+		sleep(interval);
+	}
+
+	do {
+		ok = show(page, mode);
+		if (interval > 0) {
+			fflush(stdout);
+			sleep(interval);
+		}
+	} while(interval > 0);
+
+	return (ok) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
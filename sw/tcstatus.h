@@ -0,0 +1,168 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename:	sw/tcstatus.h
+//
+// Project:	Xtimesheet, a very simple text-based timesheet tracking program
+// {{{
+// Purpose:	The status page: what xtimesheet is working on, published in
+//		a POSIX shared memory segment for status bars and the like.
+//	This header is plain C, so that anything can read the page without
+//	linking against the rest of xtimesheet.
+//
+//	A reader maps the page once, with tcstatus_map(), and then samples
+//	it with tcstatus_read() as often as it likes.  Sampling is a handful
+//	of loads--no system calls, no files, and nothing to parse.
+//
+//	The page is guarded by a sequence lock.  The writer makes m_seq odd
+//	before changing anything, and even again once it's done.  A reader
+//	copies the page, and keeps the copy only if m_seq was the same even
+//	number both before and after.  Readers never hold up the writer.
+//
+//	Only one xtimesheet publishes at a time: whichever holds a flock()
+//	on the segment.  The segment outlives it.  When it closes, it sets
+//	m_pid to zero, so readers can tell no one's publishing.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2017-2024, Gisselquist Technology, LLC
+// {{{
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	GPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/gpl.html
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+#ifndef	TCSTATUS_H
+#define	TCSTATUS_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#define	TCSTATUS_MAGIC		0x74637374u	// "tcst"
+// Changes whenever the layout below does
+#define	TCSTATUS_VERSION	1
+#define	TCSTATUS_NAMELEN	128
+#define	TCSTATUS_CARDLEN	256
+// A reader that catches the writer mid-write spins for a few tries, and
+// then yields, in case the writer's waiting on its CPU.  It gives up on a
+// writer that's stuck in the middle of a write altogether after
+// TCSTATUS_TRIES.
+#define	TCSTATUS_SPINS		100
+#define	TCSTATUS_TRIES		10000
+
+// Seconds are those logged as of m_published.  The time since m_last_start,
+// on the active card's running timer, is not included in m_today,
+// m_alltoday, or m_week, so a reader can add it in as the clock runs
+// without waiting on the writer.  The invoice totals are billing units,
+// which can't be added to that way.  They include the running timer, as of
+// m_published.
+typedef	struct	TCSTATUS_S {
+	uint32_t	m_seq;		// Odd while being written
+	uint32_t	m_magic;	// TCSTATUS_MAGIC
+	uint32_t	m_version;	// TCSTATUS_VERSION
+	int32_t		m_pid;		// The writer, zero once it's gone
+	int64_t		m_published;	// When last written
+	int64_t		m_last_start;	// Active card's timer start, or zero
+	uint32_t	m_running;	// Timers running, over every card
+	uint32_t	m_invtenths;	// Hours since the last invoice, x10
+	int64_t		m_invcents;	// Their fee, in cents
+	int64_t		m_today;	// Seconds today, on the active card
+	int64_t		m_alltoday;	// Seconds today, on every card
+	int64_t		m_week;		// Since Sunday, on the active card
+	char		m_project[TCSTATUS_NAMELEN];	// The active card's
+	char		m_card[TCSTATUS_CARDLEN];	// Its path
+} TCSTATUS;
+
+// The segment's name, one per user, for shm_open()
+static inline void	tcstatus_name(char *buf, size_t len) {
+	snprintf(buf, len, "/xtimesheet-%u", (unsigned)getuid());
+}
+
+// Maps the page, read only.  Returns NULL if no xtimesheet has ever
+// published one.  The mapping stays good for as long as the reader runs.
+static inline const TCSTATUS	*tcstatus_map(void) {
+	char		name[64];
+	struct	stat	sb;
+	void		*page;
+	int		fd;
+
+	tcstatus_name(name, sizeof(name));
+	fd = shm_open(name, O_RDONLY, 0);
+	if (fd < 0)
+		return NULL;
+	if (0 != fstat(fd, &sb) || sb.st_size < (off_t)sizeof(TCSTATUS)) {
+		close(fd);
+		return NULL;
+	}
+
+	page = mmap(NULL, sizeof(TCSTATUS), PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+
+	return (page == MAP_FAILED) ? NULL : (const TCSTATUS *)page;
+}
+
+// Copies a consistent snapshot of the page into st.  Returns zero on
+// success, or -1 if the page isn't of this version, or a write never
+// finished.  Whether anyone is still publishing is up to the caller, from
+// m_pid and m_published.
+static inline int	tcstatus_read(const TCSTATUS *page, TCSTATUS *st) {
+	uint32_t	s0, s1;
+	int		tries;
+
+	for(tries=0; tries<TCSTATUS_TRIES; tries++) {
+		if (tries >= TCSTATUS_SPINS)
+			sched_yield();
+		s0 = __atomic_load_n(&page->m_seq, __ATOMIC_ACQUIRE);
+		if (s0 & 1)
+			continue;
+		memcpy(st, page, sizeof(TCSTATUS));
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		s1 = __atomic_load_n(&page->m_seq, __ATOMIC_RELAXED);
+		if (s0 != s1)
+			continue;
+
+		if (st->m_magic != TCSTATUS_MAGIC
+				|| st->m_version != TCSTATUS_VERSION)
+			return -1;
+		st->m_project[TCSTATUS_NAMELEN-1] = '\0';
+		st->m_card[TCSTATUS_CARDLEN-1] = '\0';
+		return 0;
+	}
+
+	return -1;
+}
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	// TCSTATUS_H
@@ -40,10 +40,26 @@
 __attribute__((unused))
 static const char *cpyright = "(C) 2022 Gisselquist Technology, LLC: " __FILE__;
 
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#ifdef	__linux__
+#include <sys/vfs.h>
+#include <linux/magic.h>
+#endif
+#include <mutex>
+#include <string>
+
 #include "timecard.h"
 
 const bool	DEBUG = false;
 
+static	TIMECARD::APPENDLOCK	append_how = TIMECARD::AL_AUTO;
+static	TIMECARD::APPENDSTATS	append_st;
+static	std::mutex		append_mtx;
+
 bool	TIMECARD::istimecard(const char *fname) {
 	// {{{
 	char		cbuf[64];
@@ -82,92 +98,57 @@ bool	TIMECARD::digitstr(const char *str, int len) {
 
 time_t	TIMECARD::get_midnight(const char *ln) {
 	// {{{
-	struct	tm	datev;
+	int		year, mon, mday;
 	unsigned	v;
 	const	char	*ptr = ln;
 
-	memset(&datev, 0, sizeof(datev));
-
 	v =          (ptr[0]-'0');
 	v = v * 10 + (ptr[1]-'0');
 	v = v * 10 + (ptr[2]-'0');
 	v = v * 10 + (ptr[3]-'0');
-	datev.tm_year = v - 1900;
+	year = v;
 
 	ptr += 4; if (*ptr == '/') ptr++;
 
 	v  = (ptr[0]-'0')*10;
 	v += (ptr[1]-'0');
-	datev.tm_mon = v - 1;
+	mon = v;
 
 	ptr += 2; if (*ptr == '/') ptr++;
 
 	v  = (ptr[0]-'0')*10;
 	v += (ptr[1]-'0');
-	datev.tm_mday = v;
+	mday = v;
 
-	return mktime(&datev);
+	return TZONE::local().civil(year, mon, mday);
 }
 // }}}
 
 time_t	TIMECARD::get_midnight(time_t when) {
 	// {{{
-	struct	tm	datev;
-	localtime_r(&when, &datev);
-
-	/*
-	printf("1. LOCALTIME: %04d/%02d/%02d %02d:%02d:%02d --> %ld (%ld)\n",
-		datev.tm_year+1900, datev.tm_mon+1, datev.tm_mday,
-		datev.tm_hour, datev.tm_min, datev.tm_sec,
-		mktime(&datev), mktime(&datev)-when);
-	*/
-	datev.tm_hour = 0;
-	datev.tm_min = 0;
-	datev.tm_sec = 0;
-	datev.tm_isdst = 0;
-
-	/*
-	printf("2. LOCALTIME: %04d/%02d/%02d %02d:%02d:%02d --> %ld (%ld)\n",
-		datev.tm_year+1900, datev.tm_mon+1, datev.tm_mday,
-		datev.tm_hour, datev.tm_min, datev.tm_sec,
-		mktime(&datev), mktime(&datev)-when);
-	*/
-
-	return mktime(&datev);
+	return TZONE::local().midnight(when);
 }
 // }}}
 
 time_t	TIMECARD::get_month(time_t when) {
 	// {{{
+	const TZONE	&tz = TZONE::local();
 	struct	tm	datev;
-	localtime_r(&when, &datev);
-
-	/*
-	printf("1. LOCALTIME: %04d/%02d/%02d %02d:%02d:%02d --> %ld (%ld)\n",
-		datev.tm_year+1900, datev.tm_mon+1, datev.tm_mday,
-		datev.tm_hour, datev.tm_min, datev.tm_sec,
-		mktime(&datev), mktime(&datev)-when);
-	*/
-	datev.tm_hour = 0;
-	datev.tm_min = 0;
-	datev.tm_sec = 0;
-	datev.tm_isdst = 0;
-	//
-	datev.tm_mday = 1;
-
-	/*
-	printf("2. LOCALTIME: %04d/%02d/%02d %02d:%02d:%02d --> %ld (%ld)\n",
-		datev.tm_year+1900, datev.tm_mon+1, datev.tm_mday,
-		datev.tm_hour, datev.tm_min, datev.tm_sec,
-		mktime(&datev), mktime(&datev)-when);
-	*/
-
-	return mktime(&datev);
+
+	tz.localtime(when, datev);
+	return tz.civil(datev.tm_year+1900, datev.tm_mon+1, 1);
+}
+// }}}
+
+void	TIMECARD::localtime(time_t when, struct tm &datev) {
+	// {{{
+	TZONE::local().localtime(when, datev);
 }
 // }}}
 
 bool	TIMECARD::parse(const char *line, time_t &lnstart, time_t &lnstop) {
 	// {{{
+	m_reversed = false;
 	if ((digitstr(line, 4))&&(line[4] == '/')
 		&&(digitstr(&line[5], 2))&&(line[7] == '/')
 		&&(digitstr(&line[8], 2))&&(isspace(line[10]))
@@ -203,9 +184,10 @@ bool	TIMECARD::parse(const char *line, time_t &lnstart, time_t &lnstop) {
 		lnstart = midnight + sstart;
 		lnstop  = midnight + sstop;
 
-		if (sstop < sstart)
-			printf("FAIL: %s\n", line);
-		assert(sstop >= sstart);
+		if (sstop < sstart) {
+			m_reversed = true;
+			return false;
+		}
 		if (false) {
 			struct	tm	datev;
 			localtime_r(&midnight, &datev);
@@ -224,7 +206,7 @@ bool	TIMECARD::parse(const char *line, time_t &lnstart, time_t &lnstop) {
 		&&(isspace(line[14]))
 		&&(line[15] == '-')
 		&&(line[16] == '-')
-		&&(isspace(line[27]))) {
+		&&(isspace(line[24]))) {
 		// YYYYMMDDHHMMSS -- HHMMSS\n
 		time_t		midnight;
 		midnight = get_midnight(line);
@@ -247,7 +229,10 @@ bool	TIMECARD::parse(const char *line, time_t &lnstart, time_t &lnstop) {
 
 		lnstart = midnight + sstart;
 		lnstop  = midnight + sstop;
-		assert(sstop >= sstart);
+		if (sstop < sstart) {
+			m_reversed = true;
+			return false;
+		}
 
 		if (false) {
 			struct	tm	datev;
@@ -296,7 +281,10 @@ bool	TIMECARD::parse(const char *line, time_t &lnstart, time_t &lnstop) {
 		sstop += (line[11]-'0')*10+line[12]-'0'; // Minutes
 		sstop *= 60; // No seconds
 
-		assert(sstop > sstart);
+		if (sstop < sstart) {
+			m_reversed = true;
+			return false;
+		}
 
 		lnstart = sstart;
 		lnstop  = sstop;
@@ -316,56 +304,229 @@ bool	TIMECARD::parse(const char *line, time_t &lnstart, time_t &lnstop) {
 }
 // }}}
 
-void	TIMECARD::log(const char *fname, time_t t_start, time_t t_stop) {
+// Does O_APPEND only pretend to be atomic here?
+static	bool	remotefs(int fd) {
 	// {{{
-	FILE	*fp;
-	struct	tm	tp_start, tp_stop;
-	double	hrs;
+#ifdef	__linux__
+	struct	statfs	sb;
 
-	// Don't log anything less than a second of work
-	if (t_start == t_stop)
-		return;
+	if (0 != fstatfs(fd, &sb))
+		return true;
 
-	assert(get_midnight(t_start) == get_midnight(t_stop));
+	switch((unsigned long)sb.f_type) {
+	case NFS_SUPER_MAGIC:
+	case SMB_SUPER_MAGIC:
+	case 0xff534d42ul:	// CIFS
+	case 0xfe534d42ul:	// SMB2
+	case 0x65735546ul:	// FUSE, as sshfs
+	case CEPH_SUPER_MAGIC:
+		return true;
+	default:
+		return false;
+	}
+#else
+	return false;
+#endif
+}
+// }}}
 
-	hrs = (t_stop-t_start) / 3600.0;
+// An exclusive lock on the whole card, released when fd is closed.  Open
+// file description locks are tried first, then flock() on kernels without
+// them.
+static	bool	lockcard(int fd, bool &contended) {
+	// {{{
+	struct	flock	fl;
+	int	r;
+
+	contended = false;
+#ifdef	F_OFD_SETLK
+	memset(&fl, 0, sizeof(fl));
+	fl.l_type   = F_WRLCK;
+	fl.l_whence = SEEK_SET;
+	if (0 == fcntl(fd, F_OFD_SETLK, &fl))
+		return true;
+	if (errno == EAGAIN || errno == EACCES) {
+		contended = true;
+		do {
+			r = fcntl(fd, F_OFD_SETLKW, &fl);
+		} while(r != 0 && errno == EINTR);
+		return (r == 0);
+	}
+#endif
 
-	localtime_r(&t_start, &tp_start);
-	localtime_r(&t_stop, &tp_stop);
-	fp = fopen(fname, "a");
+	if (0 == flock(fd, LOCK_EX|LOCK_NB))
+		return true;
+	if (errno != EWOULDBLOCK)
+		return false;
+	contended = true;
+	do {
+		r = flock(fd, LOCK_EX);
+	} while(r != 0 && errno == EINTR);
+	return (r == 0);
+}
+// }}}
 
-	/*
-	fprintf(fp, "%04d%02d%02d%02d%02d%02d -- %02d%02d%02d (%4.1f)\n",
-		tp_start.tm_year+1900, tp_start.tm_mon+1,
-		tp_start.tm_mday,
-		tp_start.tm_hour, tp_start.tm_min, tp_start.tm_sec,
-		tp_stop.tm_hour, tp_stop.tm_min, tp_stop.tm_sec, hrs);
-	*/
+bool	TIMECARD::append(const char *fname, const char *rec, size_t len) {
+	// {{{
+	bool	changed;
 
-	fprintf(fp, "%04d/%02d/%02d %02d%02d%02d -- %02d%02d%02d (%4.1f)\n",
-		tp_start.tm_year+1900, tp_start.tm_mon+1,
-		tp_start.tm_mday,
-		tp_start.tm_hour, tp_start.tm_min, tp_start.tm_sec,
-		tp_stop.tm_hour, tp_stop.tm_min, tp_stop.tm_sec, hrs);
+	return append_if(fname, -1, rec, len, changed);
+}
+// }}}
+
+bool	TIMECARD::append_if(const char *fname, off_t size, const char *rec,
+		size_t len, bool &changed) {
+	// {{{
+	struct	timespec	t0, t1;
+	struct	stat	sb;
+	bool	lock, locked = false, contended = false, ok = true,
+		shorted = false;
+	double	waited = 0;
+	size_t	done = 0;
+	int	fd;
+
+	changed = false;
+	fd = ::open(fname, O_WRONLY|O_APPEND|(size < 0 ? O_CREAT : 0)|O_CLOEXEC,
+			0666);
+	if (fd < 0) {
+		std::lock_guard<std::mutex>	guard(append_mtx);
+		append_st.m_failed++;
+		return false;
+	}
+
+	lock = (size >= 0) || (append_how == AL_ALWAYS)
+		|| (append_how == AL_AUTO && (len > PIPE_BUF || remotefs(fd)));
+	if (lock) {
+		clock_gettime(CLOCK_MONOTONIC, &t0);
+		// Failing to lock, write anyway.  O_APPEND alone is still
+		// better than losing the record.
+		locked = lockcard(fd, contended);
+		clock_gettime(CLOCK_MONOTONIC, &t1);
+		waited = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec)*1e-9;
+	}
+
+	// Anyone appending without the lock could still slip in between
+	// this check and the write, but only just
+	if (size >= 0 && (0 != fstat(fd, &sb) || sb.st_size != size)) {
+		changed = true;
+		::close(fd);
+		return false;
+	}
+
+	while(done < len) {
+		ssize_t	nw = write(fd, &rec[done], len - done);
+
+		if (nw < 0) {
+			if (errno == EINTR)
+				continue;
+			ok = false;
+			break;
+		}
+
+		done += nw;
+		if (done < len)
+			shorted = true;
+	}
+
+	// Closing releases the lock
+	if (0 != ::close(fd))
+		ok = false;
+
+	{
+		std::lock_guard<std::mutex>	guard(append_mtx);
+
+		append_st.m_appends++;
+		if (locked)
+			append_st.m_locked++;
+		if (contended)
+			append_st.m_contended++;
+		if (shorted)
+			append_st.m_short++;
+		if (!ok)
+			append_st.m_failed++;
+		append_st.m_waited += waited;
+		if (waited > append_st.m_maxwait)
+			append_st.m_maxwait = waited;
+	}
+
+	return ok;
+}
+// }}}
+
+void	TIMECARD::append_locking(APPENDLOCK how) {
+	append_how = how;
+}
+
+TIMECARD::APPENDSTATS	TIMECARD::append_stats(void) {
+	// {{{
+	std::lock_guard<std::mutex>	guard(append_mtx);
+
+	return append_st;
+}
+// }}}
+
+void	TIMECARD::log(const char *fname, time_t t_start, time_t t_stop) {
+	// {{{
+	std::string	recs;
+	char	rec[80];
+	int	len;
+
+	// Don't log anything less than a second of work
+	if (t_start >= t_stop)
+		return;
+
+	// No record may cross midnight, since a line holds only one date.
+	// An interval that does is logged as one record per day, all but the
+	// last stopping at 240000.
+	while(t_start < t_stop) {
+		struct	tm	tp_start, tp_stop;
+		time_t	next, stop;
+		double	hrs;
+
+		// Days are 23 to 25 hours long, so 36 hours after midnight is
+		// always on the next day
+		next = get_midnight(get_midnight(t_start) + 36*3600);
+		stop = (t_stop < next) ? t_stop : next;
+		hrs  = (stop-t_start) / 3600.0;
+
+		localtime(t_start, tp_start);
+		if (stop == next) {
+			tp_stop.tm_hour = 24;
+			tp_stop.tm_min  = tp_stop.tm_sec = 0;
+		} else
+			localtime(stop, tp_stop);
+
+		len = snprintf(rec, sizeof(rec),
+			"%04d/%02d/%02d %02d%02d%02d -- %02d%02d%02d (%4.1f)\n",
+			tp_start.tm_year+1900, tp_start.tm_mon+1,
+			tp_start.tm_mday,
+			tp_start.tm_hour, tp_start.tm_min, tp_start.tm_sec,
+			tp_stop.tm_hour, tp_stop.tm_min, tp_stop.tm_sec, hrs);
+		recs.append(rec, len);
+		t_start = stop;
+	}
 
-	fclose(fp);
+	// Every line, in one write, so none can be torn by another writer
+	if (!append(fname, recs.data(), recs.size()))
+		fprintf(stderr, "ERR: Could not log work to %s\n", fname);
 }
 // }}}
 
 void	TIMECARD::note_start(const char *fname, time_t t_start) {
 	// {{{
-	FILE	*fp;
 	struct	tm	tp_start;
+	char	rec[80];
+	int	len;
 
-	localtime_r(&t_start, &tp_start);
-	fp = fopen(fname, "a");
+	localtime(t_start, tp_start);
 
-	fprintf(fp, "%04d/%02d/%02d %02d%02d%02d -- Start\n",
+	len = snprintf(rec, sizeof(rec), "%04d/%02d/%02d %02d%02d%02d -- Start\n",
 		tp_start.tm_year+1900, tp_start.tm_mon+1,
 		tp_start.tm_mday,
 		tp_start.tm_hour, tp_start.tm_min, tp_start.tm_sec);
 
-	fclose(fp);
+	if (!append(fname, rec, len))
+		fprintf(stderr, "ERR: Could not note the start in %s\n", fname);
 }
 // }}}
 
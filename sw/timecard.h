@@ -47,19 +47,52 @@
 #include <ctype.h>
 #include <assert.h>
 
+#include "tzone.h"
+
 extern long	timezone; // seconds west of UTC
 
 class	TIMECARD {
+	bool	m_reversed;
 public:
-	TIMECARD(void) {}
+	TIMECARD(void) : m_reversed(false) {}
+	virtual	~TIMECARD(void) {}
 
 	bool	istimecard(const char *fname);
 	bool	parse(const char *line, time_t &lnstart, time_t &lnstop);
-	void	log(const char *fname, time_t t_start, time_t t_stop);
-	void	note_start(const char *fname, time_t t_start);
+	// Did the last parse() turn its line away for stopping before it
+	// started?  Such a line, as a hand edit might leave, is no interval
+	// at all, but it's worth a warning.
+	bool	reversed(void) const { return m_reversed; }
+	// Append to a card.  A subclass may send these elsewhere, such as to
+	// another thread.
+	virtual	void	log(const char *fname, time_t t_start, time_t t_stop);
+	virtual	void	note_start(const char *fname, time_t t_start);
+
+	// Appends whole records to a card that others may be appending to
+	// at the same time.  Each call is a single O_APPEND write, which a
+	// local filesystem never interleaves with anyone else's.  A lock is
+	// taken only when that isn't enough: for records longer than
+	// PIPE_BUF, or on network filesystems, where O_APPEND is emulated.
+	typedef	enum	{ AL_AUTO, AL_ALWAYS, AL_NEVER } APPENDLOCK;
+	typedef	struct	{
+		unsigned long	m_appends, m_locked, m_contended,
+				m_short, m_failed;
+		double		m_waited, m_maxwait;	// Seconds, on locks
+	} APPENDSTATS;
+
+	static	bool	append(const char *fname, const char *rec, size_t len);
+	// Appends only if the card is still size bytes long, as it was when
+	// it was read, so that a record summing up the card can't also
+	// sweep up anything logged since.  The card is always locked.  If
+	// it's changed, nothing is written, and changed is set.
+	static	bool	append_if(const char *fname, off_t size,
+				const char *rec, size_t len, bool &changed);
+	static	void	append_locking(APPENDLOCK how);
+	static	APPENDSTATS	append_stats(void);
 	time_t	get_midnight(const char *ln);
 	time_t	get_midnight(time_t when);
 	time_t	get_month(time_t when);	// Get first of month
+	static	void	localtime(time_t when, struct tm &datev);
 	bool	digitstr(const char *str, int len);
 	static	char	*trimtask(char *task_name);
 };
@@ -0,0 +1,183 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename:	sw/timers.cpp
+//
+// Project:	Xtimesheet, a very simple text-based timesheet tracking program
+// {{{
+// Purpose:	Implements the TIMERSET, a set of concurrently running timers
+//		spread across any number of time cards.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2017-2024, Gisselquist Technology, LLC
+// {{{
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	GPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/gpl.html
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+__attribute__((unused))
+static const char *cpyright = "(C) 2024 Gisselquist Technology, LLC: " __FILE__;
+
+#include "timers.h"
+
+TIMERSET::TIMERSET(void) {
+	// {{{
+	m_ntimers = 0;
+	m_maxtimers = 8;
+	m_timer = new TIMER[m_maxtimers];
+
+	m_ncards = 0;
+	m_maxcards = 8;
+	m_cards = new char *[m_maxcards];
+}
+// }}}
+
+TIMERSET::~TIMERSET(void) {
+	// {{{
+	for(unsigned k=0; k<m_ncards; k++)
+		delete[] m_cards[k];
+	delete[] m_cards;
+	delete[] m_timer;
+}
+// }}}
+
+unsigned	TIMERSET::card(const char *fname) {
+	// {{{
+	for(unsigned k=0; k<m_ncards; k++)
+		if (strcmp(m_cards[k], fname)==0)
+			return k;
+
+	if (m_ncards >= m_maxcards) {
+		char	**old = m_cards;
+
+		m_maxcards *= 2;
+		m_cards = new char *[m_maxcards];
+		memcpy(m_cards, old, m_ncards * sizeof(char *));
+		delete[] old;
+	}
+
+	m_cards[m_ncards] = new char[strlen(fname)+1];
+	strcpy(m_cards[m_ncards], fname);
+	return m_ncards++;
+}
+// }}}
+
+const char	*TIMERSET::fname(unsigned card) const {
+	// {{{
+	if (card >= m_ncards)
+		return NULL;
+	return m_cards[card];
+}
+// }}}
+
+int	TIMERSET::find(unsigned card) const {
+	// {{{
+	for(unsigned k=0; k<m_ntimers; k++)
+		if (m_timer[k].m_card == card)
+			return (int)k;
+	return -1;
+}
+// }}}
+
+time_t	TIMERSET::started(unsigned card) const {
+	// {{{
+	int	k = find(card);
+
+	return (k < 0) ? 0 : m_timer[k].m_start;
+}
+// }}}
+
+void	TIMERSET::start(unsigned card, time_t now) {
+	// {{{
+	assert(card < m_ncards);
+	if (running(card))
+		return;
+
+	if (m_ntimers >= m_maxtimers) {
+		TIMER	*old = m_timer;
+
+		m_maxtimers *= 2;
+		m_timer = new TIMER[m_maxtimers];
+		memcpy(m_timer, old, m_ntimers * sizeof(TIMER));
+		delete[] old;
+	}
+
+	m_timer[m_ntimers].m_start = now;
+	m_timer[m_ntimers].m_card  = card;
+	m_ntimers++;
+
+	note_start(m_cards[card], now);
+}
+// }}}
+
+time_t	TIMERSET::stop(unsigned card, time_t now) {
+	// {{{
+	int	k = find(card);
+	time_t	t_start;
+
+	if (k < 0)
+		return 0;
+
+	t_start = m_timer[k].m_start;
+
+	// Keep the array packed: move the last timer into this slot
+	m_timer[k] = m_timer[--m_ntimers];
+
+	// TIMECARD::log() splits an interval through midnight into one
+	// record per day, and writes them all at once
+	log(m_cards[card], t_start, now);
+
+	return now - t_start;
+}
+// }}}
+
+time_t	TIMERSET::stop_all(time_t now) {
+	// {{{
+	time_t	secs = 0;
+
+	while(m_ntimers > 0)
+		secs += stop(m_timer[m_ntimers-1].m_card, now);
+
+	return secs;
+}
+// }}}
+
+time_t	TIMERSET::elapsed(unsigned card, time_t now) const {
+	// {{{
+	int	k = find(card);
+
+	return (k < 0) ? 0 : now - m_timer[k].m_start;
+}
+// }}}
+
+time_t	TIMERSET::elapsed(time_t now) const {
+	// {{{
+	time_t	secs = 0;
+
+	for(unsigned k=0; k<m_ntimers; k++)
+		secs += now - m_timer[k].m_start;
+
+	return secs;
+}
+// }}}
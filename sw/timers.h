@@ -0,0 +1,80 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename:	sw/timers.h
+//
+// Project:	Xtimesheet, a very simple text-based timesheet tracking program
+// {{{
+// Purpose:	Keeps track of any number of concurrently running work
+//		intervals, one per time card, so that a single process (and a
+//	single tick) can bill several projects at once.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2017-2024, Gisselquist Technology, LLC
+// {{{
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	GPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/gpl.html
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+#ifndef	TIMERS_H
+#define	TIMERS_H
+
+#include "timecard.h"
+
+// One running interval.  Only running timers are kept, packed into a
+// single array, so the tick only ever walks the timers that are active.
+typedef	struct	TIMER_S {
+	time_t		m_start;
+	unsigned	m_card;		// Index into the card table
+} TIMER;
+
+class	TIMERSET : public TIMECARD {
+	TIMER		*m_timer;
+	unsigned	m_ntimers, m_maxtimers;
+	char		**m_cards;
+	unsigned	m_ncards, m_maxcards;
+
+	int	find(unsigned card) const;
+public:
+	TIMERSET(void);
+	~TIMERSET(void);
+
+	// Returns the index of a time card, adding it if it's not yet known
+	unsigned	card(const char *fname);
+	const char	*fname(unsigned card) const;
+
+	bool	running(unsigned card) const { return find(card) >= 0; }
+	time_t	started(unsigned card) const;
+	unsigned	active(void) const { return m_ntimers; }
+
+	void	start(unsigned card, time_t now);
+	time_t	stop(unsigned card, time_t now);
+	time_t	stop_all(time_t now);
+
+	// Seconds accumulated so far, on one card or on all of them
+	time_t	elapsed(unsigned card, time_t now) const;
+	time_t	elapsed(time_t now) const;
+};
+
+#endif	// TIMERS_H
@@ -0,0 +1,586 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename:	sw/tzone.cpp
+//
+// Project:	Xtimesheet, a very simple text-based timesheet tracking program
+// {{{
+// Purpose:	Reads the local zoneinfo file (RFC 8536, TZif versions 1-4),
+//		and converts between local civil time and the epoch without
+//	any help from the C library.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2017-2024, Gisselquist Technology, LLC
+// {{{
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	GPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/gpl.html
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+__attribute__((unused))
+static const char *cpyright = "(C) 2024 Gisselquist Technology, LLC: " __FILE__;
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "tzone.h"
+
+static const char	ZONEINFO[] = "/usr/share/zoneinfo";
+static const unsigned	MAXFILE = 65536;
+
+// floor_div -- division, rounding towards minus infinity
+// {{{
+static inline int64_t	floor_div(int64_t a, int64_t b) {
+	return (a >= 0) ? a / b : -((-a + b - 1) / b);
+}
+// }}}
+
+// be32, be64 -- TZif files are big-endian
+// {{{
+static inline int32_t	be32(const unsigned char *p) {
+	return (int32_t)(((uint32_t)p[0]<<24) | ((uint32_t)p[1]<<16)
+			| ((uint32_t)p[2]<< 8) | (uint32_t)p[3]);
+}
+
+static inline int64_t	be64(const unsigned char *p) {
+	return (int64_t)(((uint64_t)(uint32_t)be32(p)<<32)
+			| (uint64_t)(uint32_t)be32(p+4));
+}
+// }}}
+
+TZONE::TZONE(void) {
+	// {{{
+	const char	*tz = getenv("TZ");
+	char		path[PATH_MAX];
+
+	clear();
+
+	if (NULL == tz) {
+		load_file("/etc/localtime");
+		return;
+	}
+
+	if (tz[0] == ':')
+		tz++;
+	if (tz[0] == '\0')
+		return;	// UTC
+
+	if (tz[0] == '/') {
+		if (load_file(tz))
+			return;
+	} else if (NULL == strstr(tz, "..")
+			&& (int)sizeof(path) > snprintf(path, sizeof(path),
+						"%s/%s", ZONEINFO, tz)
+			&& load_file(path))
+		return;
+
+	// Otherwise, TZ may be a POSIX rule, such as EST5EDT,M3.2.0,M11.1.0
+	if (!parse_rule(tz))
+		clear();
+}
+// }}}
+
+const TZONE	&TZONE::local(void) {
+	// {{{
+	// C++ guarantees this is initialized exactly once, even if several
+	// threads get here at the same time.
+	static	TZONE	tz;
+
+	return tz;
+}
+// }}}
+
+void	TZONE::clear(void) {
+	// {{{
+	m_ntrans = 0;
+	m_ntypes = 1;
+	m_gmtoff[0] = 0;
+	m_isdst[0]  = false;
+	m_abbr[0]   = 0;
+	strcpy(m_chars, "UTC");
+	m_nchars = 4;
+
+	m_has_rule = false;
+	m_rule_dst = false;
+	m_std_off  = m_dst_off = 0;
+	m_std_abbr = m_dst_abbr = 0;
+}
+// }}}
+
+bool	TZONE::load_file(const char *fname) {
+	// {{{
+	unsigned char	*buf;
+	int		fd;
+	ssize_t		nr, len = 0;
+	bool		r;
+
+	if (0 > (fd = open(fname, O_RDONLY)))
+		return false;
+
+	buf = new unsigned char[MAXFILE];
+	while(len < (ssize_t)MAXFILE
+		&& 0 < (nr = read(fd, buf+len, MAXFILE-len)))
+		len += nr;
+	close(fd);
+
+	r = load_tzif(buf, (unsigned)len);
+	delete[] buf;
+
+	if (!r)
+		clear();
+	return r;
+}
+// }}}
+
+bool	TZONE::load_tzif(const unsigned char *buf, unsigned len) {
+	// {{{
+	const unsigned char	*p = buf, *end = buf + len;
+	unsigned	isutcnt, isstdcnt, leapcnt, timecnt, typecnt, charcnt,
+			tsize = 4, first;
+	char		version;
+
+	if (len < 44 || 0 != memcmp(buf, "TZif", 4))
+		return false;
+	version = (char)buf[4];
+
+	for(int pass=0; pass < 2; pass++) {
+		if (end - p < 44 || 0 != memcmp(p, "TZif", 4))
+			return false;
+		isutcnt  = be32(p+20);
+		isstdcnt = be32(p+24);
+		leapcnt  = be32(p+28);
+		timecnt  = be32(p+32);
+		typecnt  = be32(p+36);
+		charcnt  = be32(p+40);
+		p += 44;
+
+		if ((uint64_t)(end-p) < (uint64_t)timecnt*(tsize+1)
+				+ typecnt*6 + charcnt + leapcnt*(tsize+4)
+				+ isstdcnt + isutcnt)
+			return false;
+
+		// Version 2+ files repeat everything with 64-bit times.  Skip
+		// the 32-bit data in favor of the second copy.
+		if (pass > 0 || version < '2')
+			break;
+		p += timecnt*5 + typecnt*6 + charcnt + leapcnt*8
+				+ isstdcnt + isutcnt;
+		tsize = 8;
+	}
+
+	if (typecnt == 0 || typecnt > MAXTYPES)
+		return false;
+
+	// If there are more transitions than we have room for, keep the
+	// most recent ones.
+	first = (timecnt > MAXTRANS) ? timecnt - MAXTRANS : 0;
+	m_ntrans = timecnt - first;
+	for(unsigned k=0; k<m_ntrans; k++) {
+		const unsigned char *tp = p + (first+k)*tsize;
+		m_trans[k] = (tsize == 8) ? be64(tp) : be32(tp);
+		m_type[k]  = p[timecnt*tsize + first + k];
+		if (m_type[k] >= typecnt)
+			return false;
+	} p += timecnt * (tsize+1);
+
+	m_ntypes = typecnt;
+	for(unsigned k=0; k<typecnt; k++, p+= 6) {
+		m_gmtoff[k] = be32(p);
+		m_isdst[k]  = (p[4] != 0);
+		m_abbr[k]   = (p[5] < charcnt && p[5] < MAXCHARS-1) ? p[5] : 0;
+	}
+
+	m_nchars = (charcnt < MAXCHARS-1) ? charcnt : MAXCHARS-1;
+	memcpy(m_chars, p, m_nchars);
+	m_chars[m_nchars++] = '\0';
+	p += charcnt + leapcnt*(tsize+4) + isstdcnt + isutcnt;
+
+	// The footer, a POSIX TZ rule between newlines, covers all times
+	// after the last transition
+	if (tsize == 8 && p < end && *p == '\n') {
+		const unsigned char *nl = (const unsigned char *)
+					memchr(p+1, '\n', end-p-1);
+		char	rule[128];
+
+		if (nl && nl - p - 1 > 0 && nl - p - 1 < (int)sizeof(rule)) {
+			memcpy(rule, p+1, nl-p-1);
+			rule[nl-p-1] = '\0';
+			if (!parse_rule(rule))
+				m_has_rule = false;
+		}
+	}
+
+	return true;
+}
+// }}}
+
+unsigned	TZONE::add_abbr(const char *abbr, unsigned len) {
+	// {{{
+	unsigned	idx = m_nchars;
+
+	if (m_nchars + len + 1 > MAXCHARS)
+		return 0;
+	memcpy(&m_chars[m_nchars], abbr, len);
+	m_nchars += len;
+	m_chars[m_nchars++] = '\0';
+
+	return idx;
+}
+// }}}
+
+// POSIX TZ rule parsing helpers
+// {{{
+static	const char	*rule_name(const char *p, const char *&name,
+				unsigned &len) {
+	if (*p == '<') {
+		name = ++p;
+		while(*p && *p != '>')
+			p++;
+		if (*p != '>')
+			return NULL;
+		len = p - name;
+		return p+1;
+	}
+
+	name = p;
+	while(isalpha(*p))
+		p++;
+	len = p - name;
+	return (len >= 3) ? p : NULL;
+}
+
+static	const char	*rule_time(const char *p, long &secs) {
+	bool	neg = false;
+	long	v;
+
+	if (*p == '+' || *p == '-')
+		neg = (*p++ == '-');
+	if (!isdigit(*p))
+		return NULL;
+
+	for(v=0; isdigit(*p); p++)
+		v = v * 10 + (*p - '0');
+	secs = v * 3600;
+	for(long scale = 60; *p == ':' && scale >= 1; scale /= 60) {
+		p++;
+		for(v=0; isdigit(*p); p++)
+			v = v * 10 + (*p - '0');
+		secs += v * scale;
+	}
+
+	if (neg)
+		secs = -secs;
+	return p;
+}
+
+static	const char	*rule_number(const char *p, int &v) {
+	if (!isdigit(*p))
+		return NULL;
+	for(v=0; isdigit(*p); p++)
+		v = v * 10 + (*p - '0');
+	return p;
+}
+// }}}
+
+bool	TZONE::parse_rule(const char *str) {
+	// {{{
+	const char	*p = str, *name;
+	unsigned	len;
+	long		secs;
+
+	// std offset
+	if (NULL == (p = rule_name(p, name, len)))
+		return false;
+	m_std_abbr = add_abbr(name, len);
+	if (NULL == (p = rule_time(p, secs)))
+		return false;
+	m_std_off = -secs;	// POSIX offsets count hours *west*
+
+	m_has_rule = true;
+	m_rule_dst = false;
+	if (*p == '\0')
+		return true;
+
+	// dst [offset]
+	if (NULL == (p = rule_name(p, name, len)))
+		return false;
+	m_dst_abbr = add_abbr(name, len);
+	m_dst_off  = m_std_off + 3600;
+	if (*p && *p != ',') {
+		if (NULL == (p = rule_time(p, secs)))
+			return false;
+		m_dst_off = -secs;
+	}
+
+	if (*p == '\0') {
+		// No rule given, use the US rules as glibc does
+		p = ",M3.2.0,M11.1.0";
+	}
+
+	// ,start[/time],end[/time]
+	for(int k=0; k<2; k++) {
+		RULEDATE	&r = (k == 0) ? m_dst_start : m_dst_end;
+
+		if (*p++ != ',')
+			return false;
+
+		r.m_mon = r.m_week = r.m_day = 0;
+		if (*p == 'J') {
+			r.m_kind = 'J';
+			if (NULL == (p = rule_number(p+1, r.m_day)))
+				return false;
+		} else if (*p == 'M') {
+			r.m_kind = 'M';
+			if (NULL == (p = rule_number(p+1, r.m_mon)) || *p++ != '.'
+				|| NULL == (p = rule_number(p, r.m_week))
+				|| *p++ != '.'
+				|| NULL == (p = rule_number(p, r.m_day)))
+				return false;
+			if (r.m_mon < 1 || r.m_mon > 12 || r.m_week < 1
+					|| r.m_week > 5 || r.m_day > 6)
+				return false;
+		} else {
+			r.m_kind = 'n';
+			if (NULL == (p = rule_number(p, r.m_day)))
+				return false;
+		}
+
+		r.m_secs = 2 * 3600;
+		if (*p == '/' && NULL == (p = rule_time(p+1, r.m_secs)))
+			return false;
+	}
+
+	m_rule_dst = true;
+	return (*p == '\0');
+}
+// }}}
+
+long	TZONE::days_from_civil(long year, unsigned mon, unsigned mday) {
+	// {{{
+	// Algorithm from Howard Hinnant's "chrono-compatible low-level date
+	// algorithms", counting in 400 year eras that start in March
+	long		era;
+	unsigned	yoe, doy, doe;
+
+	year -= (mon <= 2);
+	era = (year >= 0 ? year : year-399) / 400;
+	yoe = (unsigned)(year - era * 400);
+	doy = (153*(mon + (mon > 2 ? -3 : 9)) + 2)/5 + mday-1;
+	doe = yoe * 365 + yoe/4 - yoe/100 + doy;
+
+	return era * 146097 + (long)doe - 719468;
+}
+// }}}
+
+void	TZONE::civil_from_days(long days, long &year, unsigned &mon,
+		unsigned &mday) {
+	// {{{
+	long		era;
+	unsigned	doe, yoe, doy, mp;
+
+	days += 719468;
+	era = (days >= 0 ? days : days - 146096) / 146097;
+	doe = (unsigned)(days - era * 146097);
+	yoe = (doe - doe/1460 + doe/36524 - doe/146096) / 365;
+	doy = doe - (365*yoe + yoe/4 - yoe/100);
+	mp  = (5*doy + 2)/153;
+
+	mday = doy - (153*mp+2)/5 + 1;
+	mon  = (mp < 10) ? mp+3 : mp-9;
+	year = (long)yoe + era * 400 + (mon <= 2);
+}
+// }}}
+
+time_t	TZONE::rule_utc(long year, const RULEDATE &r, long off) const {
+	// {{{
+	long	days = days_from_civil(year, 1, 1);
+
+	if (r.m_kind == 'J') {
+		// Julian day 1-365, never counting February 29th
+		bool	leap = (year % 4 == 0)
+				&& ((year % 100 != 0) || (year % 400 == 0));
+		days += r.m_day - 1;
+		if (leap && r.m_day >= 60)
+			days++;
+	} else if (r.m_kind == 'M') {
+		// Day d of week w of month m, where week 5 means the last
+		long	first = days_from_civil(year, r.m_mon, 1), next;
+		int	mday;
+
+		next = (r.m_mon == 12) ? days_from_civil(year+1, 1, 1)
+				: days_from_civil(year, r.m_mon+1, 1);
+		mday = 1 + (r.m_day - (int)weekday(first) + 7) % 7
+				+ 7 * (r.m_week - 1);
+		while(mday > next - first)
+			mday -= 7;
+		days = first + mday - 1;
+	} else
+		days += r.m_day;
+
+	return (time_t)days * 86400 + r.m_secs - off;
+}
+// }}}
+
+long	TZONE::rule_offset(time_t when, bool &isdst, const char *&abbr) const {
+	// {{{
+	long		year;
+	unsigned	mon, mday;
+	time_t		start, end;
+
+	if (!m_rule_dst) {
+		isdst = false;
+		abbr  = &m_chars[m_std_abbr];
+		return m_std_off;
+	}
+
+	civil_from_days(floor_div(when + m_std_off, 86400), year, mon, mday);
+
+	// The change to daylight time is given in standard time, and the
+	// change back in daylight time
+	start = rule_utc(year, m_dst_start, m_std_off);
+	end   = rule_utc(year, m_dst_end,   m_dst_off);
+
+	if (start < end)	// Northern hemisphere
+		isdst = (when >= start && when < end);
+	else			// Southern hemisphere
+		isdst = !(when >= end && when < start);
+
+	abbr = &m_chars[isdst ? m_dst_abbr : m_std_abbr];
+	return isdst ? m_dst_off : m_std_off;
+}
+// }}}
+
+long	TZONE::offset(time_t when, bool *isdst, const char **abbr) const {
+	// {{{
+	unsigned	lo, hi, type;
+	bool		dst;
+	const char	*name;
+	long		off;
+
+	if (m_has_rule && (m_ntrans == 0 || when >= m_trans[m_ntrans-1])) {
+		off = rule_offset(when, dst, name);
+		if (isdst) *isdst = dst;
+		if (abbr)  *abbr  = name;
+		return off;
+	}
+
+	if (m_ntrans == 0 || when < m_trans[0])
+		type = 0;
+	else {
+		// Find the last transition at or before when
+		lo = 0; hi = m_ntrans;
+		while(hi - lo > 1) {
+			unsigned mid = (lo + hi) / 2;
+			if (m_trans[mid] <= when)
+				lo = mid;
+			else
+				hi = mid;
+		}
+		type = m_type[lo];
+	}
+
+	if (isdst) *isdst = m_isdst[type];
+	if (abbr)  *abbr  = &m_chars[m_abbr[type]];
+	return m_gmtoff[type];
+}
+// }}}
+
+void	TZONE::localtime(time_t when, struct tm &tv) const {
+	// {{{
+	bool		dst;
+	const char	*abbr;
+	long		off = offset(when, &dst, &abbr), year;
+	int64_t		local = (int64_t)when + off, days, secs;
+	unsigned	mon, mday;
+
+	days = floor_div(local, 86400);
+	secs = local - days * 86400;
+	civil_from_days(days, year, mon, mday);
+
+	memset(&tv, 0, sizeof(tv));
+	tv.tm_year  = year - 1900;
+	tv.tm_mon   = mon - 1;
+	tv.tm_mday  = mday;
+	tv.tm_hour  = secs / 3600;
+	tv.tm_min   = (secs / 60) % 60;
+	tv.tm_sec   = secs % 60;
+	tv.tm_wday  = weekday(days);
+	tv.tm_yday  = days - days_from_civil(year, 1, 1);
+	tv.tm_isdst = dst;
+	tv.tm_gmtoff= off;
+	tv.tm_zone  = abbr;
+}
+// }}}
+
+time_t	TZONE::from_local(int64_t local) const {
+	// {{{
+	long	early, late;
+	time_t	t;
+
+	// Zones don't change more than once a day, so the offsets a day on
+	// either side cover every choice we might need to make
+	early = offset(local - 86400);
+	late  = offset(local + 86400);
+	t = local - early;
+
+	if (early != late) {
+		time_t	t2 = local - late;
+		bool	ok1 = (offset(t) == early), ok2 = (offset(t2) == late);
+
+		if (ok1 && ok2)		// Repeated hour, take the first
+			t = (t < t2) ? t : t2;
+		else if (ok2)
+			t = t2;
+		// else a skipped hour: read the time by the old offset, just
+		// like mktime() does
+	}
+
+	return t;
+}
+// }}}
+
+time_t	TZONE::civil(int year, int mon, int mday, int hour, int min,
+		int sec) const {
+	// {{{
+	int64_t	local, mq = floor_div(mon-1, 12);
+
+	local = days_from_civil(year + mq, (unsigned)(mon - 1 - 12*mq) + 1, 1)
+			+ mday - 1;
+	local = local * 86400 + hour * 3600 + min * 60 + sec;
+
+	return from_local(local);
+}
+// }}}
+
+time_t	TZONE::midnight(time_t when) const {
+	// {{{
+	int64_t	local = (int64_t)when + offset(when);
+
+	return from_local(floor_div(local, 86400) * 86400);
+}
+// }}}
@@ -0,0 +1,114 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename:	sw/tzone.h
+//
+// Project:	Xtimesheet, a very simple text-based timesheet tracking program
+// {{{
+// Purpose:	A self-contained local time engine.  The system's zoneinfo
+//		(TZif) file is read once, and from then on all conversions
+//	between civil (local) dates and times and the epoch are done with
+//	simple arithmetic and a binary search of the transition table.  Unlike
+//	mktime() and localtime_r(), nothing here takes a lock, allocates
+//	memory, or touches any global libc timezone state.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2017-2024, Gisselquist Technology, LLC
+// {{{
+// This program is free software (firmware): you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or (at
+// your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTIBILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program.  (It's in the $(ROOT)/doc directory, run make with no
+// target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	GPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/gpl.html
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+#ifndef	TZONE_H
+#define	TZONE_H
+
+#include <stdint.h>
+#include <time.h>
+
+class	TZONE {
+public:
+	static const unsigned	MAXTRANS = 2048, MAXTYPES = 64,
+				MAXCHARS = 256;
+private:
+	// One end of a POSIX TZ daylight savings rule, such as M3.2.0/2
+	typedef	struct	{
+		char	m_kind;		// 'J', 'M', or 'n'
+		int	m_mon, m_week, m_day;
+		long	m_secs;		// Local time of day of the change
+	} RULEDATE;
+
+	// The transition table, and the local time types it refers to
+	unsigned	m_ntrans, m_ntypes;
+	int64_t		m_trans[MAXTRANS];
+	unsigned char	m_type[MAXTRANS];
+	long		m_gmtoff[MAXTYPES];
+	bool		m_isdst[MAXTYPES];
+	unsigned char	m_abbr[MAXTYPES];
+	char		m_chars[MAXCHARS];
+	unsigned	m_nchars;
+
+	// The POSIX TZ rule, for times beyond the end of the table
+	bool		m_has_rule, m_rule_dst;
+	long		m_std_off, m_dst_off;
+	unsigned char	m_std_abbr, m_dst_abbr;
+	RULEDATE	m_dst_start, m_dst_end;
+
+	void	clear(void);
+	bool	load_file(const char *fname);
+	bool	load_tzif(const unsigned char *buf, unsigned len);
+	bool	parse_rule(const char *str);
+	unsigned	add_abbr(const char *abbr, unsigned len);
+	long	rule_offset(time_t when, bool &isdst, const char *&abbr) const;
+	time_t	rule_utc(long year, const RULEDATE &r, long off) const;
+	time_t	from_local(int64_t local) const;
+
+public:
+	TZONE(void);
+
+	// The local time zone, as given by $TZ or /etc/localtime.  This is
+	// loaded on first use, and then shared (read-only) by all threads.
+	static	const TZONE	&local(void);
+
+	// Seconds east of UTC in effect at the given time
+	long	offset(time_t when, bool *isdst = NULL,
+			const char **abbr = NULL) const;
+
+	// Replacements for localtime_r() and mktime().  civil() takes a
+	// one-based month, and normalizes days and months out of range, so
+	// civil(y, m, d-7) is one week before civil(y,m,d).
+	void	localtime(time_t when, struct tm &tv) const;
+	time_t	civil(int year, int mon, int mday,
+			int hour = 0, int min = 0, int sec = 0) const;
+	time_t	midnight(time_t when) const;
+
+	// Calendar arithmetic, counting days from 1970/01/01
+	static	long	days_from_civil(long year, unsigned mon, unsigned mday);
+	static	void	civil_from_days(long days, long &year, unsigned &mon,
+				unsigned &mday);
+	static	unsigned	weekday(long days) {
+		return (unsigned)(((days % 7) + 11) % 7);
+	}
+};
+
+#endif	// TZONE_H
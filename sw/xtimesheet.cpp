@@ -49,9 +49,10 @@ static const char *cpyright = "(C) 2022 Gisselquist Technology, LLC: " __FILE__;
 #include <ctype.h>
 #include <assert.h>
 #include <signal.h>
+#include <sys/stat.h>
 
 #include <string>
-#include <unordered_map>
+#include <vector>
 #include <iostream>
 
 #include <gtk/gtk.h>
@@ -60,15 +61,22 @@ static const char *cpyright = "(C) 2022 Gisselquist Technology, LLC: " __FILE__;
 #include "gladef.h"
 #include "sm_splash.cpp"
 #include "timecard.h"
+#include "billing.h"
+#include "cardscan.h"
+#include "cardio.h"
+#include "cardbatch.h"
+#include "histpyr.h"
+#include "strtab.h"
+#include "tzone.h"
+#include "timers.h"
+#include "statuspage.h"
 
 extern long	timezone; // seconds west of UTC
 
-typedef	std::string		STRING;
-typedef	std::unordered_map<STRING,STRING> TASKTBL;
-typedef	std::pair<STRING,STRING> TBLVALUE;
-typedef	TASKTBL::iterator	TBLINDEX;
-
-TASKTBL	task_tbl;
+// Every project name and card path, each stored once.  task_tbl takes the
+// id of a project's name to the id of its card's path.
+STRTAB			strtab;
+std::vector<unsigned>	task_tbl;
 
 // #define	DBGPRINTF	printf
 #define	DBGPRINTF	null
@@ -76,69 +84,230 @@ static	void	null(...) {}
 
 void	tbl_register_fname(const char *choice, const char *fname) {
 	// {{{
-	TBLINDEX	last;
-	STRING		s_choice(choice), s_fname(fname);
-
-	last = task_tbl.find(s_choice);
-	if (last == task_tbl.end()) {
-		task_tbl.insert(TBLVALUE(s_choice, s_fname));
-		return;
-	}
+	unsigned	c = strtab.intern(choice), f = strtab.intern(fname);
 
-	if (last->second.compare(fname) != 0)
-		last->second = s_fname;
+	if (c >= task_tbl.size())
+		task_tbl.resize(strtab.size(), STRTAB::NONE);
+	task_tbl[c] = f;
 }
 // }}}
 
 const char *tbl_lookup_fname(const char *choice) {
 	// {{{
-	STRING	ch;
-	TBLINDEX	idx;
+	unsigned	c = strtab.find(choice);
 
-	idx = task_tbl.find(STRING(choice));
-	if (idx == task_tbl.end())
+	if (c >= task_tbl.size() || task_tbl[c] == STRTAB::NONE)
 		return NULL;
-	return idx->second.c_str();
+	return strtab.str(task_tbl[c]);
 }
 // }}}
 
+class	CARDSTATE {
+// {{{
+	// Everything the GUI knows about one card, kept resident so that
+	// switching back to a card only costs reading whatever has been
+	// appended to it since.
+public:
+	const char	*m_fname, *m_name;	// Both interned in strtab
+	unsigned	m_sumunits, m_daily_s, m_invunits;
+	double		m_hourly_rate;
+	int64_t		m_invcents;	// Already invoiced, in CENTS
+	HISTPYRAMID	m_hist;
+	unsigned long	m_used;		// When last selected, for eviction
+	unsigned long	m_serial;	// Tells this state from any before it
+
+	// Where reading left off
+	bool		m_scanned;	// Has anything been read?
+	off_t		m_size;		// Bytes read, as whole lines
+	off_t		m_seen;		// The card's size, when last read
+	ino_t		m_ino;
+	time_t		m_thisday, m_lastdate;
+	std::string	m_tail;		// The last bytes read
+
+	// Reads go through the I/O thread.  Only one is outstanding at a
+	// time, and intervals logged since it was posted are counted in
+	// m_inflight until they've been read back.
+	bool		m_pending, m_again;
+	unsigned	m_inflight;
+
+	CARDSTATE(const char *fname, unsigned long serial) {
+		// {{{
+		m_fname = fname;
+		m_name = NULL;
+		m_used = 0;
+		m_serial = serial;
+		m_pending = m_again = false;
+		m_inflight = 0;
+		restart();
+	}
+	// }}}
+
+	// restart -- forget everything read, so the card is read again
+	// {{{
+	void	restart(void) {
+		m_sumunits = m_daily_s = m_invunits = 0;
+		m_hourly_rate = 225.0;
+		m_invcents = 0;
+		m_hist.clear();
+		m_scanned = false;
+		m_size = m_seen = 0;
+		m_ino = 0;
+		m_thisday = m_lastdate = 0;
+		m_tail.clear();
+	}
+	// }}}
+
+	// Seconds worked today, including anything not yet read back
+	unsigned	daily(void) const { return m_daily_s + m_inflight; }
+
+	// Roughly, the memory this state holds
+	size_t	bytes(void) const {
+		return sizeof(*this) + m_hist.bytes();
+	}
+};
+// }}}
+
+class	ASYNCTIMERS : public TIMERSET {
+// {{{
+	// Timers whose intervals are written out by the I/O thread
+	CARDIO	*m_io;
+public:
+	ASYNCTIMERS(CARDIO *io) { m_io = io; }
+
+	void	log(const char *fname, time_t t_start, time_t t_stop) {
+		CARDREQ	*req = new CARDREQ(CR_LOG, fname);
+
+		req->m_start = t_start;
+		req->m_stop  = t_stop;
+		m_io->post(req);
+	}
+
+	void	note_start(const char *fname, time_t t_start) {
+		CARDREQ	*req = new CARDREQ(CR_START, fname);
+
+		req->m_start = t_start;
+		m_io->post(req);
+	}
+};
+// }}}
+
 class	XTIMESHEET : public TIMECARD {
 // {{{
+	typedef	std::pair<time_t,time_t>		INTERVAL;
+
+	// Resident card states are evicted, least recently selected first,
+	// once together they hold more than this
+	static const size_t	MAXRESIDENT = 16 << 20;
+
+	// Finished read requests are kept to be posted again, unless they
+	// carried a lot of data
+	static const unsigned	MAXSPARE = 4;
+	static const size_t	MAXSPAREDATA = 64 << 10;
+
+	std::vector<CARDSTATE *>	m_states;	// By id of the path
+	std::vector<CARDREQ *>		m_spare;
+	unsigned long	m_clock, m_serial;
+
+	// Today's time over every card, as last counted by the I/O thread,
+	// and what's been logged since the count was asked for
+	unsigned long	m_tallied, m_tallyinflight;
+	bool		m_tallying;
+
+	// Intervals logged while m_allhist is being built
+	std::vector<INTERVAL>	m_allqueue;
+	bool		m_allpending;
 public:
-	time_t		m_last_start, m_today;
-	bool		m_currently_working;
-	char		*m_fname, *m_name;
-	unsigned	m_sumunits, m_daily_s, m_invunits, m_allhrs;
-	double		m_hourly_rate, m_invamount;
+	CARDIO		m_io;		// Before m_timers, which uses it
+	ASYNCTIMERS	m_timers;
+	unsigned	m_card;		// Our index into m_timers
+	CARDSTATE	*m_cur;		// The card we're on
+	time_t		m_today;
+	HISTPYRAMID	m_allhist;	// Every card
+	bool		m_allbuilt;	// Has m_allhist been read in?
+	STATUSPAGE	m_status;	// For status bars, per tcstatus.h
 
 	// XTIMESHEET
 	// {{{
-	XTIMESHEET(void) {
-		m_last_start = 0;
-		m_currently_working = false;
+	XTIMESHEET(void) : m_timers(&m_io) {
+		m_clock = m_serial = 0;
+		m_tallied = m_tallyinflight = 0;
+		m_tallying = false;
+		m_allpending = false;
+		m_card = 0;
+		m_cur = NULL;
 		m_today = get_midnight(time(NULL));
-		m_fname = NULL;
-		m_name = NULL;
-		m_sumunits = m_daily_s = m_allhrs = 0;
-		m_hourly_rate = 225.0;
-		m_invamount = 0.0;
+		m_allbuilt = false;
+		m_spare.reserve(MAXSPARE);
 	}
 	// }}}
 
-	// load
+	~XTIMESHEET(void) {
+		m_io.shutdown();
+		for(unsigned k=0; k<m_states.size(); k++)
+			delete m_states[k];
+		for(unsigned k=0; k<m_spare.size(); k++)
+			delete m_spare[k];
+	}
+
+	// load -- switch to a card, reading only what's new within it
 	// {{{
 	void	load(const char *fname) {
-		m_hourly_rate = 225.0;
+		unsigned	id = strtab.intern(fname);
+
+		if (id >= m_states.size())
+			m_states.resize(strtab.size(), NULL);
+		if (NULL == m_states[id]) {
+			m_cur = m_states[id] = new CARDSTATE(strtab.str(id),
+						++m_serial);
+			add_card(fname);
+		} else
+			m_cur = m_states[id];
+		m_cur->m_used = ++m_clock;
+
+		m_card = m_timers.card(m_cur->m_fname);
+		reload();
+		evict();
+	}
+	// }}}
+
+	// evict -- drop the least recently used states, while too large
+	// {{{
+	void	evict(void) {
+		size_t		total = 0;
+		unsigned	nresident = 0;
+
+		for(unsigned k=0; k<m_states.size(); k++) {
+			if (m_states[k]) {
+				total += m_states[k]->bytes();
+				nresident++;
+			}
+		}
 
-		if (m_fname)
-			delete[] m_fname;
-		m_fname = new char[strlen(fname)+2];
-		strcpy(m_fname, fname);
+		while(total > MAXRESIDENT && nresident > 1) {
+			unsigned	oldest = STRTAB::NONE;
 
-		assert(access(fname, R_OK)==0);
-		assert(access(fname, W_OK)==0);
+			for(unsigned k=0; k<m_states.size(); k++) {
+				if (!m_states[k] || m_states[k] == m_cur)
+					continue;
+				if (oldest == STRTAB::NONE || m_states[k]->m_used
+						< m_states[oldest]->m_used)
+					oldest = k;
+			}
 
-		reload();
+			// Any read still outstanding will find the serial
+			// number gone, and be dropped
+			total -= m_states[oldest]->bytes();
+			delete m_states[oldest];
+			m_states[oldest] = NULL;
+			nresident--;
+		}
+	}
+	// }}}
+
+	// working -- are we currently on the clock for this card?
+	// {{{
+	bool	working(void) const {
+		return m_timers.running(m_card);
 	}
 	// }}}
 
@@ -171,102 +340,547 @@ public:
 	}
 	// }}}
 
-	// reload
+	// project -- a Project: line names this card
 	// {{{
-	void	reload(void) {
-		const	unsigned MXLEN=4096;
-		FILE		*fp;
-		char	*line;
-		time_t	thisday = 0, lnstart=0, lnstop=0;
+	void	project(CARDSTATE *st, const char *line) {
+		std::string_view	name(&line[8]);
+
+		while(!name.empty() && isspace(name.front()))
+			name.remove_prefix(1);
+		if (name.size() > 1) {
+			while(isspace(name.back()))
+				name.remove_suffix(1);
+			st->m_name = strtab.str(strtab.intern(name));
+		}
+		if (st->m_name)
+			tbl_register_fname(st->m_name, st->m_fname);
+	}
+	// }}}
 
-		m_today = get_midnight(time(NULL));
-		// Don't clear m_allhrs here.
-		m_sumunits = m_daily_s = 0;
-		m_invunits = 0;
-
-		line = new char[MXLEN];
-		fp = fopen(m_fname, "r");
-		while(fgets(line, MXLEN, fp)) {
-			if (strncasecmp(line, "rate:", 5)==0) {
-				char *rate = &line[5];
-				replace_char(rate);
-				m_hourly_rate = atof(rate);
-			} else if (strncasecmp(line, "project:", 8)==0) {
-				char	*ptr;
-				ptr = &line[8];
-				while(isspace(*ptr))
-					ptr++;
-				if (strlen(ptr) > 1) {
-					if (m_name)
-						delete[] m_name;
-					m_name = new char[strlen(ptr)+2];
-					strcpy(m_name, ptr);
-					while(isspace(m_name[strlen(m_name)-1]))
-						m_name[strlen(m_name)-1]='\0';
-				}
-				tbl_register_fname(m_name, m_fname);
-			} else if((strncasecmp(line, "invoice", 8)==0)
-				||(strncasecmp(line, "billed",  7)==0)) {
-				m_invunits += m_sumunits;
-				m_sumunits = 0;
-				m_invamount += (m_sumunits * m_hourly_rate)/10.0;
-			} else if (parse(line, lnstart, lnstop)) {
-				time_t		midnight;
-				if (lnstart > 24*3600) {
-					midnight = get_midnight(lnstart);
-					if (midnight != thisday) {
-						m_sumunits  += (m_daily_s+180)/60/6;
-						m_daily_s = 0;
-						thisday = midnight;
-					}
+	// rate -- parse a Rate: line, in the local convention for decimals
+	// {{{
+	double	rate(const char *line) {
+		char	buf[64];
+
+		strncpy(buf, &line[5], sizeof(buf)-1);
+		buf[sizeof(buf)-1] = '\0';
+		replace_char(buf);
+		return atof(buf);
+	}
+	// }}}
+
+	// update -- ask the I/O thread for whatever's been added to a card
+	// {{{
+	void	update(CARDSTATE *st) {
+		CARDREQ	*req;
+
+		if (st->m_pending) {
+			// Ask again once this one is back
+			st->m_again = true;
+			return;
+		}
+
+		if (m_spare.empty())
+			req = new CARDREQ(CR_READ, st->m_fname);
+		else {
+			req = m_spare.back();
+			m_spare.pop_back();
+			req->reset(CR_READ, st->m_fname);
+		}
+		req->m_scanned = st->m_scanned;
+		req->m_ino     = st->m_ino;
+		req->m_size    = st->m_size;
+		req->m_seen    = st->m_seen;
+		req->m_tail    = st->m_tail;
+		req->m_serial  = st->m_serial;
+		req->m_logged  = st->m_inflight;
+		st->m_pending  = true;
+		m_io.post(req);
+	}
+	// }}}
+
+	// line -- account for one line read from a card
+	// {{{
+	void	line(CARDSTATE *st, const char *line) {
+		time_t	lnstart=0, lnstop=0;
+
+		if (strncasecmp(line, "rate:", 5)==0) {
+			st->m_hourly_rate = rate(line);
+		} else if (strncasecmp(line, "project:", 8)==0) {
+			project(st, line);
+		} else if((strncasecmp(line, "invoice", 7)==0)
+			||(strncasecmp(line, "billed",  6)==0)) {
+			// Close out the day, so only time after the
+			// invoice counts against the next one
+			st->m_sumunits += BILLING::ROUNDING::units(st->m_daily_s);
+			st->m_daily_s = 0;
+			st->m_thisday = 0;
+
+			st->m_invunits += st->m_sumunits;
+			st->m_invcents += CENTS::fee<BILLING::ROUNDING>(
+				CENTS::from(st->m_hourly_rate),
+				st->m_sumunits);
+			st->m_sumunits = 0;
+		} else if (parse(line, lnstart, lnstop)) {
+			time_t		midnight;
+			if (lnstart > 24*3600) {
+				midnight = get_midnight(lnstart);
+				if (midnight != st->m_thisday) {
+					st->m_sumunits  += BILLING::ROUNDING::units(st->m_daily_s);
+					st->m_daily_s = 0;
+					st->m_thisday = midnight;
 				}
+				st->m_lastdate = midnight;
+				st->m_hist.add(lnstart, lnstop);
+			} else if (st->m_lastdate)
+				st->m_hist.add(st->m_lastdate+lnstart,
+					st->m_lastdate+lnstop);
+
+			st->m_daily_s += lnstop-lnstart;
+		}
+	}
+	// }}}
 
-				m_daily_s += lnstop-lnstart;
+	// apply -- take in what the I/O thread read from a card
+	// {{{
+	// Returns the card's state, or NULL if it's since been evicted
+	CARDSTATE	*apply(CARDREQ *req) {
+		unsigned	id = strtab.find(req->m_fname);
+		CARDSTATE	*st;
+
+		if (id >= m_states.size() || NULL == (st = m_states[id])
+				|| st->m_serial != req->m_serial)
+			return NULL;
+
+		st->m_pending = false;
+		st->m_inflight -= req->m_logged;
+		if (req->m_error) {
+			fprintf(stderr, "ERR: Cannot read %s\n", st->m_fname);
+		} else {
+			char	*ptr, *end, *nl;
+
+			if (req->m_restart)
+				st->restart();
+
+			// Lines keep their newlines, as fgets() would leave
+			// them, and are terminated in place one at a time
+			ptr = &req->m_data[0];
+			end = ptr + req->m_data.size();
+			while(ptr < end) {
+				char	save;
+
+				nl = (char *)memchr(ptr, '\n', end-ptr);
+				nl = (nl) ? nl+1 : end;
+				save = *nl;
+				*nl = '\0';
+				line(st, ptr);
+				*nl = save;
+				ptr = nl;
 			}
+
+			st->m_scanned = true;
+			st->m_ino  = req->m_ino;
+			st->m_size = req->m_size;
+			st->m_seen = req->m_seen;
+			st->m_tail = req->m_tail;
+		}
+		settle(st);
+
+		if (st->m_again) {
+			st->m_again = false;
+			update(st);
+		}
+
+		return st;
+	}
+	// }}}
+
+	// settle -- bill any day before today, leaving m_daily_s for today
+	// {{{
+	void	settle(CARDSTATE *st) {
+		if (st->m_thisday != m_today) {
+			st->m_sumunits  += BILLING::ROUNDING::units(st->m_daily_s);
+			st->m_daily_s = 0;
+			st->m_thisday = m_today;
 		}
-		fclose(fp);
+	}
+	// }}}
+
+	// collect -- take in everything the I/O thread has finished
+	// {{{
+	// Returns true if anything on display may have changed
+	bool	collect(void) {
+		CARDREQ	*req;
+		bool	changed = false;
+
+		while(NULL != (req = m_io.result())) {
+			switch(req->m_kind) {
+			case CR_READ:
+				if (apply(req) == m_cur)
+					changed = true;
+				break;
+			case CR_TALLY:
+				m_tallied = req->m_secs;
+				m_tallyinflight -= req->m_logged;
+				m_tallying = false;
+				changed = true;
+				break;
+			case CR_HISTORY:
+				std::swap(m_allhist, *req->m_hist);
+				for(unsigned k=0; k<m_allqueue.size(); k++)
+					m_allhist.add(m_allqueue[k].first,
+						m_allqueue[k].second);
+				m_allqueue.clear();
+				m_allpending = false;
+				m_allbuilt = true;
+				changed = true;
+				break;
+			default:
+				break;
+			}
 
-		if (m_today != thisday) {
-			m_sumunits  += (m_daily_s+180)/60/6;
-			m_daily_s = 0;
+			if (req->m_kind == CR_READ && m_spare.size() < MAXSPARE
+				&& req->m_data.capacity() <= MAXSPAREDATA)
+				m_spare.push_back(req);
+			else
+				delete req;
 		}
 
-		delete[] line;
+		return changed;
+	}
+	// }}}
+
+	// add_card -- count a card towards the all-projects total for today
+	// {{{
+	void	add_card(const char *fname) {
+		m_io.post(new CARDREQ(CR_ADDCARD, fname));
+	}
+	// }}}
+
+	// count_today -- ask for a new count of today's time, over every card
+	// {{{
+	void	count_today(void) {
+		CARDREQ	*req;
+
+		if (m_tallying)
+			return;
+
+		req = new CARDREQ(CR_TALLY);
+		req->m_logged = m_tallyinflight;
+		m_tallying = true;
+		m_io.post(req);
+	}
+	// }}}
+
+	// alltoday -- seconds logged today, over every card, as last counted
+	// {{{
+	unsigned long	alltoday(void) const {
+		return m_tallied + m_tallyinflight;
+	}
+	// }}}
+
+	// history -- build the every-card history from a list of cards
+	// {{{
+	// Each card is read once, by the I/O thread.  From then on, toggle()
+	// keeps the history current, as reading a card does its own.
+	void	history(const std::vector<std::string> &cards) {
+		CARDREQ	*req;
+
+		if (m_allbuilt || m_allpending)
+			return;
+
+		req = new CARDREQ(CR_HISTORY);
+		req->m_cards = cards;
+		m_allpending = true;
+		m_io.post(req);
+	}
+	// }}}
+
+	// reload
+	// {{{
+	void	reload(void) {
+		m_today = get_midnight(time(NULL));
+		update(m_cur);
 	}
 	// }}}
 
 	// toggle
 	// {{{
+	// Neither starting nor stopping waits on the disk.  A stopped
+	// interval counts at once, while the I/O thread writes it out and
+	// reads it back.
 	void	toggle(void) {
-		if (!m_currently_working) {
-			reload();
+		time_t	now = time(NULL);
 
-			m_currently_working = true;
-			if (m_last_start != 0) {
-				// Clear our total hourly count for the day
-				// on the first task start of any new day.
-				m_today = get_midnight(time(NULL));
-				if (m_last_start < m_today)
-					m_allhrs = 0;
-			}
-			time(&m_last_start);
-			TIMECARD::note_start(m_fname, m_last_start);
+		if (!working()) {
+			reload();
+			m_timers.start(m_card, now);
 		} else {
-			time_t	now = time(NULL);
-			log(m_last_start, now);
-			m_currently_working = false;
+			time_t	start = m_timers.started(m_card),
+				secs = m_timers.stop(m_card, now);
+
+			m_cur->m_inflight += secs;
+			m_tallyinflight += secs;
+			if (m_allbuilt)
+				m_allhist.add(start, now);
+			else if (m_allpending)
+				m_allqueue.push_back(INTERVAL(start, now));
 
-			m_daily_s += (now - m_last_start);
-			m_allhrs  += (now - m_last_start);
-			m_last_start = 0;
+			reload();
 		}
 	}
 	// }}}
 
-	void	log(time_t t_start, time_t t_stop) {
-		TIMECARD::log(m_fname, t_start, t_stop);
+	// stop_all -- log every running timer, not just our own
+	// {{{
+	void	stop_all(void) {
+		if (working())
+			toggle();
+		m_timers.stop_all(time(NULL));
 	}
+	// }}}
 
+	// publish -- update the status page with where things stand
+	// {{{
+	void	publish(time_t now) {
+		TCSTATUS	st;
+		struct	tm	tv;
+		time_t		running = 0;
+		unsigned	units;
+		long		day;
+
+		memset(&st, 0, sizeof(st));
+		if (working()) {
+			st.m_last_start = m_timers.started(m_card);
+			running = now - st.m_last_start;
+		}
+		st.m_running = m_timers.active();
+
+		strncpy(st.m_project, (m_cur->m_name) ? m_cur->m_name
+			: m_cur->m_fname, TCSTATUS_NAMELEN-1);
+		strncpy(st.m_card, m_cur->m_fname, TCSTATUS_CARDLEN-1);
+
+		st.m_today = m_cur->daily();
+		st.m_alltoday = alltoday() + m_timers.elapsed(now) - running;
+
+		// Sunday through today, as thisweek counts it.  Whatever's
+		// still in flight was logged today.
+		TZONE::local().localtime(now, tv);
+		day = TZONE::days_from_civil(tv.tm_year+1900, tv.tm_mon+1,
+				tv.tm_mday);
+		st.m_week = m_cur->m_inflight;
+		for(int k=0; k<=tv.tm_wday; k++)
+			st.m_week += m_cur->m_hist.secs(HL_DAY, day-k);
+
+		units = m_cur->m_sumunits
+			+ BILLING::ROUNDING::units(m_cur->daily() + running);
+		st.m_invtenths = BILLING::ROUNDING::tenths(units);
+		st.m_invcents = CENTS::fee<BILLING::ROUNDING>(
+				CENTS::from(m_cur->m_hourly_rate), units);
+
+		m_status.publish(st);
+	}
+	// }}}
+};
+// }}}
+
+class	HISTCHART {
+// {{{
+	// The chart shows hours per day, week, month or year, whichever
+	// leaves each bar at least a few pixels wide.  Everything drawn comes
+	// from a HISTPYRAMID, so panning and zooming never reads a card, and
+	// drawing costs no more than the number of bars on the screen.
+	Gtk::DrawingArea	*m_area;
+	const HISTPYRAMID	*m_hist;
+	double	m_left, m_span;		// In days since 1970/01/01
+	double	m_dragx;
+
+	static	const char	*level_name(HISTLEVEL lvl) {
+		// {{{
+		static const char *names[HL_NLEVELS] = {
+			"day", "week", "month", "year" };
+		return names[lvl];
+	}
+	// }}}
+
+	static	long	today(void) {
+		// {{{
+		struct	tm	tv;
+
+		TZONE::local().localtime(time(NULL), tv);
+		return TZONE::days_from_civil(tv.tm_year+1900, tv.tm_mon+1,
+				tv.tm_mday);
+	}
+	// }}}
+
+	// clamp -- keep the span between a week and thirty years
+	// {{{
+	void	clamp(void) {
+		if (m_span < 7.0)
+			m_span = 7.0;
+		if (m_span > 30*365.25)
+			m_span = 30*365.25;
+	}
+	// }}}
+public:
+	HISTCHART(void) {
+		// {{{
+		m_area = NULL;
+		m_hist = NULL;
+		m_span = 60.0;
+		m_left = today() + 1 - m_span;
+		m_dragx = 0.0;
+	}
+	// }}}
+
+	// attach -- draw into a given area, and take its mouse events
+	// {{{
+	void	attach(Gtk::DrawingArea *area) {
+		m_area = area;
+		m_area->add_events(Gdk::SCROLL_MASK | Gdk::BUTTON_PRESS_MASK
+				| Gdk::BUTTON1_MOTION_MASK);
+		m_area->signal_draw().connect(
+				sigc::mem_fun(this, &HISTCHART::on_draw));
+		m_area->signal_scroll_event().connect(
+				sigc::mem_fun(this, &HISTCHART::on_scroll));
+		m_area->signal_button_press_event().connect(
+				sigc::mem_fun(this, &HISTCHART::on_press));
+		m_area->signal_motion_notify_event().connect(
+				sigc::mem_fun(this, &HISTCHART::on_motion));
+	}
+	// }}}
+
+	// set -- chart a (new) history, keeping the present view
+	// {{{
+	void	set(const HISTPYRAMID *hist) {
+		m_hist = hist;
+		redraw();
+	}
+	// }}}
+
+	void	redraw(void) {
+		if (m_area)
+			m_area->queue_draw();
+	}
+
+	// on_draw
+	// {{{
+	bool	on_draw(const Cairo::RefPtr<Cairo::Context> &cr) {
+		int		width  = m_area->get_allocated_width(),
+				height = m_area->get_allocated_height();
+		double		ppd = width / m_span;	// Pixels per day
+		HISTLEVEL	lvl;
+		long		first, last;
+		unsigned long	most = 0;
+		char		buf[128];
+
+		cr->set_source_rgb(1.0, 1.0, 1.0);
+		cr->paint();
+		if (!m_hist || width <= 0 || height <= 0)
+			return true;
+
+		if (ppd >= 4.0)
+			lvl = HL_DAY;
+		else if (ppd * 7 >= 4.0)
+			lvl = HL_WEEK;
+		else if (ppd * 30 >= 4.0)
+			lvl = HL_MONTH;
+		else
+			lvl = HL_YEAR;
+
+		first = HISTPYRAMID::period(lvl, (long)floor(m_left));
+		last  = HISTPYRAMID::period(lvl, (long)floor(m_left + m_span));
+		for(long p=first; p<=last; p++)
+			if (m_hist->secs(lvl, p) > most)
+				most = m_hist->secs(lvl, p);
+
+		// Leave a line at the top for the legend
+		double	top = 14.0, scale = (most > 0)
+				? (height - top) / (double)most : 0.0;
+
+		cr->set_source_rgb(0.2, 0.4, 0.8);
+		for(long p=first; p<=last; p++) {
+			unsigned long	secs = m_hist->secs(lvl, p);
+			double		x0, x1, h;
+
+			if (secs == 0)
+				continue;
+			x0 = (HISTPYRAMID::begins(lvl, p) - m_left) * ppd;
+			x1 = (HISTPYRAMID::begins(lvl, p+1) - m_left) * ppd;
+			if (x1 - x0 > 2.0)
+				x1 -= 1.0;	// A gap between bars
+			h = secs * scale;
+			cr->rectangle(x0, height - h, x1 - x0, h);
+		}
+		cr->fill();
+
+		// Legend: the scale, and the dates at either edge
+		long		year;
+		unsigned	mon, mday;
+		int		n;
+
+		TZONE::civil_from_days((long)floor(m_left), year, mon, mday);
+		n = snprintf(buf, sizeof(buf), "%04ld/%02u/%02u", year, mon, mday);
+		TZONE::civil_from_days((long)floor(m_left + m_span) - 1,
+				year, mon, mday);
+		snprintf(&buf[n], sizeof(buf)-n,
+			" - %04ld/%02u/%02u, peak %.1f hours/%s",
+			year, mon, mday, most / 3600.0, level_name(lvl));
+		cr->set_source_rgb(0.0, 0.0, 0.0);
+		cr->move_to(2.0, 11.0);
+		cr->show_text(buf);
+
+		return true;
+	}
+	// }}}
+
+	// on_scroll -- zoom in or out, about the day under the pointer
+	// {{{
+	bool	on_scroll(GdkEventScroll *ev) {
+		int	width = m_area->get_allocated_width();
+		double	at, frac;
+
+		if (width <= 0)
+			return false;
+
+		frac = ev->x / width;
+		at = m_left + frac * m_span;
+		if (ev->direction == GDK_SCROLL_UP)
+			m_span *= 0.8;
+		else if (ev->direction == GDK_SCROLL_DOWN)
+			m_span *= 1.25;
+		else
+			return false;
+		clamp();
+		m_left = at - frac * m_span;
+
+		redraw();
+		return true;
+	}
+	// }}}
+
+	// on_press, on_motion -- pan by dragging with the first button
+	// {{{
+	bool	on_press(GdkEventButton *ev) {
+		if (ev->button != 1)
+			return false;
+		m_dragx = ev->x;
+		return true;
+	}
+
+	bool	on_motion(GdkEventMotion *ev) {
+		int	width = m_area->get_allocated_width();
+
+		if (width <= 0 || 0 == (ev->state & GDK_BUTTON1_MASK))
+			return false;
+
+		m_left -= (ev->x - m_dragx) * m_span / width;
+		m_dragx = ev->x;
+
+		redraw();
+		return true;
+	}
+	// }}}
 };
 // }}}
 
@@ -292,7 +906,12 @@ public:
 	Gtk::ToggleButton	*m_working_btn;
 	Gtk::ProgressBar	*m_daily_prg;
 	Gtk::Image		*m_splash;
-	bool			m_terminate_now;
+	Gtk::DrawingArea	*m_history;
+	Gtk::CheckButton	*m_hist_all;
+	HISTCHART		m_chart;
+	Glib::Dispatcher	m_iodone;	// From the I/O thread
+	std::vector<std::string>	m_cards;	// From ~/.xtimesheet
+	bool			m_terminate_now, m_parallel, m_syncing;
 
 	// APPDATA
 	// {{{
@@ -310,7 +929,11 @@ public:
 		m_alltoday   = NULL;
 		m_working_btn= NULL;
 		m_daily_prg  = NULL;
+		m_history    = NULL;
+		m_hist_all   = NULL;
 		m_terminate_now = false;
+		m_parallel   = false;
+		m_syncing    = false;
 	}
 	// }}}
 
@@ -321,12 +944,12 @@ public:
 
 		DBGPRINTF("SET-VALUES\n");
 		m_taskfile->set_title("Select a timecard");
-		if (m_xts && m_xts->m_fname && m_xts->m_fname[0]) {
+		if (m_xts && m_xts->m_cur && m_xts->m_cur->m_fname && m_xts->m_cur->m_fname[0]) {
 			TSKMODEL	model;
 			Gtk::TreeModel::iterator p, here;
 
-			DBGPRINTF("\tSetting filename to %s\n", m_xts->m_fname);
-			m_taskfile->set_filename(m_xts->m_fname);
+			DBGPRINTF("\tSetting filename to %s\n", m_xts->m_cur->m_fname);
+			m_taskfile->set_filename(m_xts->m_cur->m_fname);
 
 			model = list_model();
 			p = model->children().begin();
@@ -334,14 +957,18 @@ public:
 
 			p = model->children().begin();
 
-			if (!model->iter_is_valid(p)) {
-				DBGPRINTF("\tADDING.1 \"%s\"\n", m_xts->m_name);
-				m_taskchoice->prepend(strdup(m_xts->m_name));
+			if (!m_xts->m_cur->m_name) {
+				// The card hasn't been read yet.  Its name will
+				// come with it, and set_values() again.
+				DBGPRINTF("\tADDING.0: Not yet read\n");
+			} else if (!model->iter_is_valid(p)) {
+				DBGPRINTF("\tADDING.1 \"%s\"\n", m_xts->m_cur->m_name);
+				m_taskchoice->prepend(strdup(m_xts->m_cur->m_name));
 				m_taskchoice->set_active(0);
 			} else if (model->iter_is_valid(here) && here == p
-				&& m_xts && m_xts->m_name && m_xts->m_name[0]
+				&& m_xts && m_xts->m_cur->m_name && m_xts->m_cur->m_name[0]
 				&& m_taskchoice->get_active_text().compare(
-						m_xts->m_name)==0) {
+						m_xts->m_cur->m_name)==0) {
 				// Already active, no action required
 				DBGPRINTF("\tADDING.2: No action\n");
 				// m_taskchoice->set_active(0);
@@ -354,7 +981,7 @@ public:
 					Glib::ustring	this_text;
 					p->get_value(0, this_text);
 					DBGPRINTF("\tADDING.3: this_text = %s\n", this_text.c_str());
-					if (this_text == m_xts->m_name) {
+					if (this_text == m_xts->m_cur->m_name) {
 						if (found) {
 							DBGPRINTF("\tADDING.3: Removing \"%s\"\n", this_text.c_str());
 							p = model->erase(p);
@@ -366,31 +993,33 @@ public:
 				}
 
 				if (!found) {
-					DBGPRINTF("\tADDING.4 %s\n", m_xts->m_name);
-					m_taskchoice->prepend(strdup(m_xts->m_name));
+					DBGPRINTF("\tADDING.4 %s\n", m_xts->m_cur->m_name);
+					m_taskchoice->prepend(strdup(m_xts->m_cur->m_name));
 					m_taskchoice->set_active(0);
 				}
 			}
 
-			sprintf(buf, "$ %.2f", m_xts->m_hourly_rate);
+			sprintf(buf, "$ %.2f", m_xts->m_cur->m_hourly_rate);
 			m_hourlyrate->set_text(buf);
 
-			sprintf(buf, "%.1f", (m_xts->m_invunits + m_xts->m_sumunits+((m_xts->m_daily_s+180)/360)) / 10.0);
+			unsigned	today = BILLING::ROUNDING::units(m_xts->m_cur->daily());
+			sprintf(buf, "%.1f", BILLING::ROUNDING::tenths(m_xts->m_cur->m_invunits + m_xts->m_cur->m_sumunits + today) / 10.0);
 			m_prjhours->set_text(buf);
 
 			// Same thing, but without the invoiced units
-			sprintf(buf, "%.1f", (m_xts->m_sumunits+((m_xts->m_daily_s+180)/360)) / 10.0);
+			sprintf(buf, "%.1f", BILLING::ROUNDING::tenths(m_xts->m_cur->m_sumunits + today) / 10.0);
 			m_invhours->set_text(buf);
 
-			double	 v = m_xts->m_invamount + (m_xts->m_sumunits * m_xts->m_hourly_rate / 10.0);
-			sprintf(buf, "%.2f", v);
+			int64_t	rate = CENTS::from(m_xts->m_cur->m_hourly_rate),
+				cents = CENTS::fee<BILLING::ROUNDING>(rate,
+						m_xts->m_cur->m_sumunits);
+			sprintf(buf, "%.2f", CENTS::to_double(m_xts->m_cur->m_invcents + cents));
 			m_totalcost->set_text(buf);
 
-			v = (m_xts->m_sumunits * m_xts->m_hourly_rate / 10.0);
-			sprintf(buf, "%.2f", v);
+			sprintf(buf, "%.2f", CENTS::to_double(cents));
 			m_invcost->set_text(buf);
 
-			v = m_xts->m_daily_s / 3600.0;
+			double	v = m_xts->m_cur->daily() / 3600.0;
 			sprintf(buf, "%.1f", v);
 			m_prjtoday->set_text(buf);
 		} else
@@ -406,8 +1035,8 @@ public:
 	// {{{
 	void	tick(void) {
 		char	buf[128];
-		time_t	daily_s = m_xts->m_daily_s;
-		unsigned	sumunits, allhrs = m_xts->m_allhrs;
+		time_t	daily_s, now = time(NULL);
+		unsigned	sumunits, allhrs;
 		double	f;
 
 
@@ -416,20 +1045,22 @@ public:
 			return;
 		}
 
-		if (m_xts->m_currently_working) {
-			daily_s = m_xts->m_daily_s + (time(NULL)-m_xts->m_last_start);
-			allhrs  = m_xts->m_allhrs  + (time(NULL)-m_xts->m_last_start);
-		}
+		// One pass over the running timers, regardless of how many
+		// cards they belong to, plus everything already logged today
+		// on any card we know of--whoever logged it
+		daily_s = m_xts->m_cur->daily() + m_xts->m_timers.elapsed(m_xts->m_card, now);
+		allhrs  = m_xts->alltoday() + m_xts->m_timers.elapsed(now);
 
-		sumunits = m_xts->m_sumunits + ((daily_s+180)/360);
-		sprintf(buf, "%.1f", sumunits / 10.0);
+		sumunits = m_xts->m_cur->m_sumunits + BILLING::ROUNDING::units(daily_s);
+		sprintf(buf, "%.1f", BILLING::ROUNDING::tenths(sumunits) / 10.0);
 		m_prjhours->set_text(buf);
 
-		double	 v = sumunits * m_xts->m_hourly_rate / 10.0;
-		sprintf(buf, "%.2f", v);
+		int64_t	cents = CENTS::fee<BILLING::ROUNDING>(
+				CENTS::from(m_xts->m_cur->m_hourly_rate), sumunits);
+		sprintf(buf, "%.2f", CENTS::to_double(cents));
 		m_totalcost->set_text(buf);
 
-		allhrs = ((allhrs+180)/360);
+		allhrs = BILLING::ROUNDING::tenths(BILLING::ROUNDING::units(allhrs));
 		sprintf(buf, "%.1f", allhrs / 10.0);
 		m_alltoday->set_text(buf);
 
@@ -445,12 +1076,18 @@ public:
 		sprintf(buf, "%.1f", f);
 		m_prjtoday->set_text(buf);
 
-		if (m_xts->m_currently_working) {
-			unsigned hrs, mns, len;
-			len = (time(NULL)-m_xts->m_last_start);
+		m_xts->publish(now);
+
+		if (m_xts->working()) {
+			unsigned hrs, mns, len, others;
+			len = m_xts->m_timers.elapsed(m_xts->m_card, now);
 			hrs = len / 3600;
 			mns = (len-hrs*3600)/60;
-			if ((mns>0)||(hrs>0)) {
+			others = m_xts->m_timers.active()-1;
+			if (others > 0) {
+				sprintf(buf, "Working (%d:%02d, +%u)", hrs, mns, others);
+				m_working_btn->set_label(buf);
+			} else if ((mns>0)||(hrs>0)) {
 				sprintf(buf, "Working (%d:%02d)", hrs, mns);
 				m_working_btn->set_label(buf);
 			} else m_working_btn->set_label("Working");
@@ -461,7 +1098,9 @@ public:
 	// on_select -- switch tasks
 	// {{{
 	void	on_select(void) {
-		bool		working = m_xts->m_currently_working;
+		// With concurrent timers, switching tasks leaves any running
+		// timers alone.  Otherwise, the timer follows the task.
+		bool		working = !m_parallel && m_xts->working();
 		const	char	*fname;
 		Glib::ustring	taskname;
 
@@ -469,8 +1108,8 @@ public:
 		taskname = m_taskchoice->get_active_text();
 		DBGPRINTF(" -- %s", taskname.c_str());
 
-		if (m_xts && m_xts->m_name && m_xts->m_name[0]
-				&& taskname.compare(m_xts->m_name)==0) {
+		if (m_xts && m_xts->m_cur && m_xts->m_cur->m_name && m_xts->m_cur->m_name[0]
+				&& taskname.compare(m_xts->m_cur->m_name)==0) {
 			// User selected the currently selected task
 			return;
 		}
@@ -481,8 +1120,8 @@ public:
 			if (list_model()->iter_is_valid(list_model()->children().begin()))
 				m_taskchoice->set_active(0);
 			return;
-		} if (m_xts->m_fname && m_xts->m_fname[0]
-				&& strcmp(fname, m_xts->m_fname)==0) {
+		} if (m_xts->m_cur->m_fname && m_xts->m_cur->m_fname[0]
+				&& strcmp(fname, m_xts->m_cur->m_fname)==0) {
 			DBGPRINTF("Task already loaded and active\n");
 			return;
 		}
@@ -501,6 +1140,9 @@ public:
 			m_xts->toggle();
 		}
 
+		if (m_parallel)
+			show_working();
+
 		// Re-sort to make this item the "top" or #1 item
 		TSKMODEL	model = list_model();
 		Gtk::TreeModel::iterator p = m_taskchoice->get_active(),
@@ -516,7 +1158,7 @@ public:
 			
 		}
 
-		if (working) {
+		if (working || m_parallel) {
 			// Adjust the button's active time
 			tick();
 		}
@@ -528,9 +1170,63 @@ public:
 	// {{{
 	void	on_toggle(void) {
 		DBGPRINTF("APP:ON-TOGGLE\n");
+		if (m_syncing)
+			return;
 		m_xts->toggle();
+		show_working();
+		m_chart.redraw();
+
+		tick();
+	}
+	// }}}
+
+	// on_iodone -- the I/O thread has finished something
+	// {{{
+	void	on_iodone(void) {
+		if (m_xts->collect()) {
+			set_values();
+			m_chart.redraw();
+		}
+	}
+	// }}}
+
+	// on_hist_all -- chart this project, or every project
+	// {{{
+	void	on_hist_all(void) {
+		if (!m_hist_all->get_active()) {
+			m_chart.set(&m_xts->m_cur->m_hist);
+			return;
+		}
+
+		if (!m_xts->m_allbuilt) {
+			std::vector<std::string>	cards = m_cards;
+			bool	found = false;
+
+			// The card we're on needn't be in ~/.xtimesheet
+			for(unsigned k=0; k<cards.size() && !found; k++)
+				found = (cards[k] == m_xts->m_cur->m_fname);
+			if (!found)
+				cards.push_back(m_xts->m_cur->m_fname);
+			m_xts->history(cards);
+		}
+
+		m_chart.set(&m_xts->m_allhist);
+	}
+	// }}}
 
-		if (m_xts->m_currently_working) {
+	// show_working -- make the button match the current card's timer
+	// {{{
+	void	show_working(void) {
+		bool	working = m_xts->working();
+
+		if (m_working_btn->get_active() != working) {
+			// Don't let on_toggle() treat this as a button press
+			m_syncing = true;
+			m_working_btn->set_active(working);
+			m_syncing = false;
+		}
+
+		if (working) {
 			m_working_btn->set_label("Working");
 			Gdk::RGBA	clr("red");
 			m_working_btn->override_background_color(clr);
@@ -539,8 +1235,6 @@ public:
 			Gdk::RGBA	clr("green");
 			m_working_btn->override_background_color(clr);
 		}
-
-		tick();
 	}
 	// }}}
 
@@ -582,9 +1276,22 @@ public:
 	bool	close(void) {
 		// If we are currently working, then we should log our last
 		// working interval before closing.  Therefore, let's toggle
-		// the button and log off.
-		if (m_xts->m_currently_working)
-			m_xts->toggle();
+		// the button and log off--on every card with a running timer.
+		m_xts->stop_all();
+		// Wait for all of it to be written
+		m_xts->m_io.shutdown();
+		m_xts->m_status.close();
+
+		{
+			TIMECARD::APPENDSTATS	st = TIMECARD::append_stats();
+
+			if (st.m_contended > 0 || st.m_failed > 0)
+				fprintf(stderr, "%lu appends, %lu locked, %lu "
+					"waited (%.3fs max), %lu failed\n",
+					st.m_appends, st.m_locked,
+					st.m_contended, st.m_maxwait,
+					st.m_failed);
+		}
 		gtk_main_quit();
 		return true;
 	}
@@ -594,7 +1301,8 @@ public:
 		// {{{
 		char	cfg_file[PATH_MAX+2], *home, cfg_task[PATH_MAX],
 			prefix[PATH_MAX], *tsk_name;
-		FILE	*fcfg = NULL, *ftsk;
+		FILE	*fcfg = NULL;
+		CARDBATCH	batch;
 
 // printf("READ-CONFIG\n");
 		home = getenv("HOME");
@@ -612,19 +1320,38 @@ public:
 // printf("READ-CONFIG: cfg_file = %s\n", cfg_file);
 
 		while(fgets(cfg_task, sizeof(cfg_task), fcfg)) {
-			char	*tsk_file = TIMECARD::trimtask(cfg_task), *endp;
+			char	*tsk_file = TIMECARD::trimtask(cfg_task);
 
 			if ('\0' == tsk_file[0])
 				continue;
+			batch.add(tsk_file);
+		} fclose(fcfg);
 
-			ftsk = NULL;
-			if (0 != access(tsk_file, R_OK))
-				continue;
-			if (NULL == (ftsk=fopen(tsk_file,"r")))
+		std::vector<std::string>	first(batch.size());
+		std::vector<bool>		found(batch.size(), false);
+
+		// Every card's first line, read all at once.  Cards that can't
+		// be read are left out, as before.
+		batch.head([&](unsigned k, const char *data, size_t len) {
+			const char	*nl;
+
+			if (NULL == data)
+				return;
+			nl = (const char *)memchr(data, '\n', len);
+			first[k].assign(data, (nl) ? nl - data + 1 : len);
+			found[k] = true;
+		}, sizeof(prefix)-1);
+
+		for(unsigned k=0; k<batch.size(); k++) {
+			char	*endp;
+
+			if (!found[k])
 				continue;
+			m_cards.push_back(batch.name(k));
+			m_xts->add_card(batch.name(k));
 
-			if ((fgets(prefix,sizeof(prefix), ftsk))
-				&&(0==strncasecmp(prefix, "project:", 8))) {
+			strcpy(prefix, first[k].c_str());
+			if (0==strncasecmp(prefix, "project:", 8)) {
 				tsk_name = prefix+8;
 				while(*tsk_name && isspace(*tsk_name))
 					tsk_name++;
@@ -632,20 +1359,18 @@ public:
 				while(tsk_name < endp && isspace(*endp))
 					*endp-- = '\0';
 				if (endp > tsk_name) {
-					tbl_register_fname(tsk_name, cfg_task);
+					tbl_register_fname(tsk_name, batch.name(k));
 					m_taskchoice->append(strdup(tsk_name));
 				}
-			} fclose(ftsk);
+			}
 		}
-
-		fclose(fcfg);
 	}
 	// }}}
 
 	// load
 	// {{{
 	void	load(const char *fname) {
-		bool	working = m_xts->m_currently_working;
+		bool	working = !m_parallel && m_xts->working();
 
 		if (working) {
 			// Stop the time card, write a close task to it
@@ -656,6 +1381,10 @@ public:
 		m_xts->load(fname);
 		DBGPRINTF("LOAD()::CALLING LOAD::SET-VALUES\n");
 		set_values();
+		if (m_hist_all && !m_hist_all->get_active())
+			m_chart.set(&m_xts->m_cur->m_hist);
+		else
+			m_chart.redraw();
 
 		if (working) {
 			// Restart the task
@@ -676,8 +1405,10 @@ extern "C" {
 // on_tick
 // {{{
 int	on_tick(APPDATA *ad) {
-	if (ad)
+	if (ad) {
+		ad->m_xts->count_today();
 		ad->tick();
+	}
 	return 1;
 }
 // }}}
@@ -716,7 +1447,9 @@ void	sig_handler(int v) {
 void usage(void) {
 	fprintf(stderr, "USAGE:  xtimesheet [<timesheet.txt>]\n"
 "\tor\n"
-"\txtimesheet -p project_name -r rate\n\n"
+"\txtimesheet -p project_name -r rate\n"
+"\tor\n"
+"\txtimesheet -m\n\n"
 "\twhere:\n"
 "\t\t- timesheet.txt is the name of an existing textfile.\n "
 "\t\t\tThis file should have in it, as a minimum, a line beginning with 'Project: '\n"
@@ -725,10 +1458,54 @@ void usage(void) {
 "\t\t- second command creates timesheet.txt file automatically\n"
 "\t\t\t-p project_name, where project name can be multiple words separated by space, e.g. \"test project\"\n"
 "\t\t\t-r rate, in decimal format, e.g. 33.3.\n"
+"\t\t- -m allows timers to run on several time cards at once.  Switching\n"
+"\t\t\ttasks then leaves the previous task's timer running.\n"
+"\t\t- --reload timesheet.txt reads the card as the window would, prints\n"
+"\t\t\tits totals, and exits without opening a window.\n"
 	);
 }
 // }}}
 
+// reload_only -- read one card, headless, as the window would
+// {{{
+// Everything the window would do to show a card, short of the window
+// itself: the I/O thread reads the card, and the main thread takes in what
+// it read.  This is what make perf times.
+int	reload_only(const char *fname) {
+	char		full_path[PATH_MAX];
+	sem_t		done;
+	XTIMESHEET	*xts;
+	CARDSTATE	*st;
+	unsigned	today;
+
+	if (NULL == realpath(fname, full_path)) {
+		fprintf(stderr, "ERROR: Cannot access %s\n", fname);
+		return EXIT_FAILURE;
+	}
+
+	sem_init(&done, 0, 0);
+	xts = new XTIMESHEET();
+	xts->m_io.start([&done](void) { sem_post(&done); });
+	xts->load(full_path);
+	st = xts->m_cur;
+	while(st->m_pending) {
+		sem_wait(&done);
+		xts->collect();
+	}
+
+	today = BILLING::ROUNDING::units(st->daily());
+	printf("%s: %.1f hours, %.1f since the last invoice\n",
+		(st->m_name) ? st->m_name : st->m_fname,
+		BILLING::ROUNDING::tenths(st->m_invunits + st->m_sumunits
+			+ today) / 10.0,
+		BILLING::ROUNDING::tenths(st->m_sumunits + today) / 10.0);
+
+	delete xts;
+	sem_destroy(&done);
+	return EXIT_SUCCESS;
+}
+// }}}
+
 // get_file_extension
 // {{{
 char* get_file_extension(char* file_name) {
@@ -760,12 +1537,23 @@ void project_to_filename(char *file_name, char *proj, size_t len) {
 // {{{
 int main(int argc, char **argv) {
 
+	if (argc == 3 && strcmp(argv[1], "--reload")==0)
+		return reload_only(argv[2]);
+
 	Gtk::Main kit(argc, argv);
 	Glib::RefPtr<Gtk::Builder>	builder;
 	// Glib::Error		*error = NULL;
 	char file_name[PATH_MAX];
+	bool	parallel = false;
 	file_name[0] = '\0';
 
+	if (argc > 1 && strcmp(argv[1], "-m")==0) {
+		// Multiple concurrent timers
+		parallel = true;
+		argv[1] = argv[0];
+		argv++; argc--;
+	}
+
 	if (argc == 5) { //new project
 		// {{{
 		if (strcasecmp(argv[1], "-p")==0 && strcasecmp(argv[3], "-r")==0) {
@@ -865,6 +1653,7 @@ int main(int argc, char **argv) {
 
 	ad = new APPDATA();
 	ad->m_xts = new XTIMESHEET();
+	ad->m_parallel = parallel;
 
 	/* Init GTK+ */
 	gtk_init(&argc, &argv);
@@ -898,6 +1687,8 @@ int main(int argc, char **argv) {
 	builder->get_widget("working_btn", ad->m_working_btn);
 	builder->get_widget("daily_prg",   ad->m_daily_prg);
 	builder->get_widget("splash",      ad->m_splash);
+	builder->get_widget("history",     ad->m_history);
+	builder->get_widget("hist_all",    ad->m_hist_all);
 
 	/* Connect signals */
 	// gtk_builder_connect_signals( builder, ad );
@@ -906,6 +1697,13 @@ int main(int argc, char **argv) {
 	ad->m_xts_main->signal_show().connect(sigc::mem_fun(ad, &APPDATA::on_show));
 	ad->m_taskchoice->signal_changed().connect(sigc::mem_fun(ad, &APPDATA::on_select));
 	ad->m_taskfile->signal_file_set().connect(sigc::mem_fun(ad, &APPDATA::on_newfile));
+	ad->m_hist_all->signal_toggled().connect(sigc::mem_fun(ad, &APPDATA::on_hist_all));
+	ad->m_iodone.connect(sigc::mem_fun(ad, &APPDATA::on_iodone));
+	ad->m_xts->m_io.start([](void) { ad->m_iodone.emit(); });
+
+	// Chart the history of this card
+	ad->m_chart.attach(ad->m_history);
+	ad->m_chart.set(&ad->m_xts->m_cur->m_hist);
 
 	// Set the image value
 	ad->m_splash->set(Gdk::Pixbuf::create_from_inline(sizeof(sm_splash), sm_splash));
@@ -915,6 +1713,7 @@ int main(int argc, char **argv) {
 
 	// Add all task choices found in the ~/.xtimesheet file
 	ad->read_config();
+	ad->m_xts->count_today();
 
 	/* Destroy builder, since we don't need it anymore */
 	// g_object_unref( G_OBJECT( builder ));